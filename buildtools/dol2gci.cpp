@@ -2,6 +2,8 @@
 // It adjusts the DOL header for that - this should not break any loader but you never
 // know.
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <assert.h>
@@ -10,7 +12,10 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 
+#include <atomic>
 #include <string>
+#include <thread>
+#include <vector>
 
 using namespace std;
 
@@ -105,40 +110,15 @@ const u8 dol_icon[] = {
 	0x80, 0x88, 0x80, 0x86, 0x80, 0x48, 0x80, 0x46, 0x80, 0x24, 0x80, 0x04, 0x80, 0x02, 0x80, 0x00
 };
 
-// utility functions
-int load( const string & name, void ** data )
-{
-        size_t size = 0;
-        *data = NULL;
-        int fd = open( name.c_str(), O_RDONLY|O_BINARY, 0 );
-        if (fd >= 0) {
-                struct stat sb;
-                if ( fstat( fd, &sb ) >= 0) {
-                        assert( sb.st_size > 0 );
-                        void *tmp = malloc( sb.st_size );
-                        if ( tmp!=NULL ) {
-                                if (read( fd, tmp, sb.st_size ) == sb.st_size) {
-                                        *data = tmp;
-                                        size = sb.st_size;
-                                } else {
-                                        free(tmp);
-                                }
-                        }
-                }
-                close( fd );
-        }
-        return size;
-}
+// DOL files are copied through in blocks of this size rather than loaded whole
+#define COPY_BLOCK_SIZE 65536
 
-void save(const string & name, const void *data, int size)
-{
-        int fd = open( name.c_str(), O_WRONLY|O_CREAT|O_TRUNC|O_BINARY, 0666 );
-        if (fd >= 0) {
-		write( fd, data, size );
-                close( fd );
-        }
-}
- 
+#define DOL_HEADER_SIZE 0x100
+#define DOL_SECTIONS 18
+#define GCI_HEADER_SIZE 0x40
+#define GCI_BLOCK_SIZE 8192
+
+// utility functions
 u32 get_u32be(void const * const buf)
 {
 	return ((u8*)buf)[3] | (((u8*)buf)[2]<<8) | (((u8*)buf)[1]<<16) | (((u8*)buf)[0]<<24);
@@ -158,48 +138,99 @@ void set_u32be(void * buf, u32 v)
 	((u8*)buf)[0] = (v>>24) & 0xFF;
 }
 
-int main (int argc, char * const argv[]) 
+bool write_all(int fd, const void *data, size_t size)
 {
-	if (argc != 3 && argc != 4) {
-		fprintf(stderr, "dol2gci <dolfile> <gcifile> [<filename>]\n");
-		return -1;
-	} 
+	const u8 *p = (const u8 *)data;
+	while (size > 0) {
+		ssize_t written = write( fd, p, size );
+		if (written <= 0) {
+			return false;
+		}
+		p += written;
+		size -= written;
+	}
+	return true;
+}
+
+bool read_all(int fd, void *data, size_t size)
+{
+	u8 *p = (u8 *)data;
+	while (size > 0) {
+		ssize_t got = read( fd, p, size );
+		if (got <= 0) {
+			return false;
+		}
+		p += got;
+		size -= got;
+	}
+	return true;
+}
+
+// strip path from filename, looking for forward and backslash
+string base_name(const string & path)
+{
+	string name = path;
+	size_t i = name.rfind('/');
+	if (i!=string::npos) {
+		name = name.substr(i+1);
+	}
+	i = name.rfind('\\');
+	if (i!=string::npos) {
+		name = name.substr(i+1);
+	}
+	return name;
+}
 
-	// strip path from filename, looking for forward and backslash
-	string name;
-	unsigned int i;
-	if (argc == 4) {
-		name = argv[3];
-	} else {
-		name = argv[1];
-		i = name.rfind('/');
-		if (i!=string::npos) {
-			name = name.substr(i+1);
+// every section must lie within the file, past the header
+bool check_dol(const u8 *header, u32 dol_size)
+{
+	for (int i=0; i<DOL_SECTIONS; i++) {
+		u32 filepos = get_u32be(header + i*4);
+		u32 size = get_u32be(header + 0x90 + i*4);
+		if (size == 0) {
+			continue;
 		}
-		i = name.rfind('\\');
-		if (i!=string::npos) {
-			name = name.substr(i+1);
+		if (filepos < DOL_HEADER_SIZE || filepos > dol_size || size > dol_size - filepos) {
+			return false;
 		}
 	}
-	
-	// load DOL file
-	u8 *dol_data;
-	int dol_size = load(argv[1], (void**)&dol_data);
-	if (dol_size < 256) {
-		fprintf(stderr, "can't read dol\n");
+	return true;
+}
+
+// The icon is the same for every GCI, so it is padded out once up front
+const int icon_size = ((sizeof(dol_icon) + 31) & ~31);
+u8 icon_block[(sizeof(dol_icon) + 31) & ~31];
+
+int convert(const string & dol_name, const string & gci_name, const string & name)
+{
+	// open DOL file
+	int in = open( dol_name.c_str(), O_RDONLY|O_BINARY, 0 );
+	if (in < 0) {
+		fprintf(stderr, "%s: can't read dol\n", dol_name.c_str());
 		return -1;
-	} 
+	}
+	struct stat sb;
+	u8 header[0x180];
+	if (fstat( in, &sb ) < 0 || sb.st_size < DOL_HEADER_SIZE || sb.st_size > 0x7FFFFFFF
+		|| !read_all( in, header + GCI_HEADER_SIZE, DOL_HEADER_SIZE )) {
+		fprintf(stderr, "%s: can't read dol\n", dol_name.c_str());
+		close( in );
+		return -1;
+	}
+	int dol_size = sb.st_size;
+	if (!check_dol(header + GCI_HEADER_SIZE, dol_size)) {
+		fprintf(stderr, "%s: bad dol section table\n", dol_name.c_str());
+		close( in );
+		return -1;
+	}
 	
 	// calculate overal size
-	int icon_size = ((sizeof(dol_icon) + 31) & ~31);
 	int data_size = 64 + icon_size + dol_size;
-	int data_blocks = (data_size + 8191) / 8192;
-	
-	// create GCI file
-	int gci_size = 64 + data_blocks * 8192;
-	u8 *gci_data = (u8 *)malloc(gci_size);
+	int data_blocks = (data_size + GCI_BLOCK_SIZE - 1) / GCI_BLOCK_SIZE;
+	int gci_size = GCI_HEADER_SIZE + data_blocks * GCI_BLOCK_SIZE;
 		
 	// set up GCI header
+	u8 *gci_data = header;
 	memcpy(gci_data + 0x00, "DOLX", 4);     // Game Code
 	memcpy(gci_data + 0x04, "00", 2);       // maker code
 	gci_data[6] = 0xFF;			// unused/reserved
@@ -217,9 +248,8 @@ int main (int argc, char * const argv[])
 	set_u16be(gci_data + 0x3a, 0xffff);     // unused/reserved
 	set_u32be(gci_data + 0x3c, 0x100);      // comment
 	
-	// copy and fix DOL header
-	memcpy(gci_data + 0x40, dol_data, 256);
-	for (i=0; i<18; i++) {
+	// fix DOL header
+	for (int i=0; i<DOL_SECTIONS; i++) {
 		u32 adr = 0x40 + i*4;
 		u32 filepos = get_u32be(gci_data + adr);
 		if (filepos >= 0x100) {
@@ -227,17 +257,102 @@ int main (int argc, char * const argv[])
 		}
 	}
 		
-	// description and icon
+	// description
 	memset(gci_data + 0x140, 0, 64);
 	strcpy((char*)(gci_data + 0x140), "Dolphin Application");
 	strncpy((char*)(gci_data + 0x160), name.c_str(), 31);
-	memcpy(gci_data + 0x180, dol_icon, sizeof(dol_icon));
 	
-	// copy DOL data
-	memcpy(gci_data + 0x180 + icon_size, dol_data + 256, dol_size - 256);
+	// write GCI file, streaming the DOL data after the icon
+	int out = open( gci_name.c_str(), O_WRONLY|O_CREAT|O_TRUNC|O_BINARY, 0666 );
+	if (out < 0) {
+		fprintf(stderr, "%s: can't write gci\n", gci_name.c_str());
+		close( in );
+		return -1;
+	}
+	bool ok = write_all( out, header, sizeof(header) ) && write_all( out, icon_block, icon_size );
+	u8 *block = (u8 *)malloc(COPY_BLOCK_SIZE);
+	int left = dol_size - DOL_HEADER_SIZE;
+	while (ok && left > 0) {
+		int size = left < COPY_BLOCK_SIZE ? left : COPY_BLOCK_SIZE;
+		ok = read_all( in, block, size ) && write_all( out, block, size );
+		left -= size;
+	}
 	
-	// save GCI file
-	save(argv[2], gci_data, gci_size);	
-		
+	// pad out the last block
+	int padding = gci_size - (0x180 + icon_size + dol_size - DOL_HEADER_SIZE);
+	memset(block, 0, padding);
+	ok = ok && write_all( out, block, padding );
+	free(block);
+	close( in );
+	if (close( out ) < 0 || !ok) {
+		fprintf(stderr, "%s: can't write gci\n", gci_name.c_str());
+		unlink( gci_name.c_str() );
+		return -1;
+	}
 	return 0;
 }
+
+// convert each DOL to a GCI of the same name in the output directory
+int batch(const string & dir, const vector<string> & dols, int jobs)
+{
+	atomic<size_t> next(0);
+	atomic<int> result(0);
+	auto worker = [&]() {
+		size_t i;
+		while ((i = next++) < dols.size()) {
+			string name = base_name(dols[i]);
+			string gci_name = name;
+			size_t dot = gci_name.rfind('.');
+			if (dot != string::npos) {
+				gci_name = gci_name.substr(0, dot);
+			}
+			if (convert(dols[i], dir + "/" + gci_name + ".gci", name) != 0) {
+				result = -1;
+			}
+		}
+	};
+	vector<thread> threads;
+	for (int i=1; i<jobs; i++) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto & t : threads) {
+		t.join();
+	}
+	return result;
+}
+
+int usage()
+{
+	fprintf(stderr, "dol2gci <dolfile> <gcifile> [<filename>]\n"
+	                "dol2gci --batch [--jobs <n>] <outdir> <dolfile>...\n");
+	return -1;
+}
+
+int main (int argc, char * const argv[]) 
+{
+	memcpy(icon_block, dol_icon, sizeof(dol_icon));
+
+	if (argc >= 2 && !strcmp(argv[1], "--batch")) {
+		int arg = 2;
+		int jobs = 1;
+		if (arg + 1 < argc && !strcmp(argv[arg], "--jobs")) {
+			jobs = atoi(argv[arg + 1]);
+			if (jobs < 1) {
+				jobs = thread::hardware_concurrency();
+			}
+			arg += 2;
+		}
+		if (argc - arg < 2) {
+			return usage();
+		}
+		vector<string> dols(argv + arg + 1, argv + argc);
+		return batch(argv[arg], dols, jobs);
+	}
+
+	if (argc != 3 && argc != 4) {
+		return usage();
+	} 
+
+	return convert(argv[1], argv[2], argc == 4 ? argv[3] : base_name(argv[1]));
+}
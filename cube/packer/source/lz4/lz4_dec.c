@@ -0,0 +1,128 @@
+/* lz4_dec.c
+	- LZ4 legacy frame decoder
+ */
+
+/*
+ * Decoder for the LZ4 legacy frame format, as written by "lz4 -l".
+ * The frame is a magic number followed by blocks, each prefixed with
+ * its compressed size, that decompress to 8 MiB apiece except the last.
+ *
+ * Copies go through memmove, which the packer provides itself, so that
+ * nothing is pulled in from newlib.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LZ4_LEGACY_MAGIC 0x184C2102
+#define LZ4_MIN_MATCH    4
+
+static inline uint32_t lz4_get_le32(const uint8_t *buf)
+{
+	return buf[0] | buf[1] << 8 | buf[2] << 16 | (uint32_t)buf[3] << 24;
+}
+
+static inline bool lz4_get_length(const uint8_t **in, const uint8_t *in_end, size_t *length)
+{
+	uint8_t byte;
+
+	if (*length != 15)
+		return true;
+
+	do {
+		if (*in == in_end)
+			return false;
+
+		byte = *(*in)++;
+		*length += byte;
+	} while (byte == 255);
+
+	return true;
+}
+
+static uint8_t *lz4_decompress_block(const uint8_t *in, const uint8_t *in_end,
+                                     uint8_t *out, uint8_t *out_end)
+{
+	uint8_t *block = out;
+
+	while (in < in_end) {
+		uint8_t token = *in++;
+		size_t length = token >> 4;
+
+		if (!lz4_get_length(&in, in_end, &length))
+			return NULL;
+		if (length > in_end - in || length > out_end - out)
+			return NULL;
+
+		memmove(out, in, length);
+		out += length;
+		in  += length;
+
+		/* The last sequence is literals only. */
+		if (in == in_end)
+			break;
+		if (in_end - in < 2)
+			return NULL;
+
+		size_t offset = in[0] | in[1] << 8;
+		in += 2;
+
+		length = token & 15;
+		if (!lz4_get_length(&in, in_end, &length))
+			return NULL;
+		length += LZ4_MIN_MATCH;
+
+		if (offset == 0 || offset > out - block || length > out_end - out)
+			return NULL;
+
+		const uint8_t *match = out - offset;
+
+		if (offset >= length) {
+			memmove(out, match, length);
+			out += length;
+		} else {
+			/* Overlapping matches repeat the last offset bytes. */
+			while (length--)
+				*out++ = *match++;
+		}
+	}
+
+	return out;
+}
+
+/*
+ * Returns the number of bytes written to out, or 0 if the input is not a
+ * well-formed legacy frame or doesn't fit.
+ */
+static size_t lz4_decompress(const uint8_t *in, size_t in_size, uint8_t *out, size_t out_size)
+{
+	const uint8_t *in_end = in + in_size;
+	uint8_t *out_start = out;
+	uint8_t *out_end = out + out_size;
+
+	if (in_size < 4 || lz4_get_le32(in) != LZ4_LEGACY_MAGIC)
+		return 0;
+
+	in += 4;
+
+	while (in_end - in >= 4) {
+		uint32_t block_size = lz4_get_le32(in);
+		in += 4;
+
+		/* Another frame may follow when files are concatenated. */
+		if (block_size == LZ4_LEGACY_MAGIC)
+			continue;
+		if (block_size > in_end - in)
+			return 0;
+
+		out = lz4_decompress_block(in, in + block_size, out, out_end);
+		if (out == NULL)
+			return 0;
+
+		in += block_size;
+	}
+
+	return out - out_start;
+}
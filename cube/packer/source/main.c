@@ -17,18 +17,27 @@
  * with Swiss.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#ifdef PACKER_LZ4
+#include "lz4/lz4_dec.c"
+#else
 #include "xz/xz_crc32.c"
 #include "xz/xz_dec_stream.c"
 #include "xz/xz_dec_lzma2.c"
 #include "xz/xz_dec_bcj.c"
+#endif
 
 #include <ogc/machine/processor.h>
+#ifdef PACKER_LZ4
+#include "executable_lz4.h"
+#else
 #include "executable_xz.h"
+#endif
 #include "executable_bin.h"
 #define EXECUTABLE_ADDR ((void *)0x00003100)
 void (*entrypoint)(void) = EXECUTABLE_ADDR;
 extern struct __argv __argv __attribute((section(".init")));
 
+#ifndef PACKER_LZ4
 static struct xz_dec_bcj xz_dec_bcj;
 static struct xz_dec_lzma2 xz_dec_lzma2;
 static struct xz_dec xz_dec;
@@ -39,6 +48,7 @@ static struct xz_buf xz_buf = {
 	.out = EXECUTABLE_ADDR,
 	.out_size = executable_bin_size
 };
+#endif
 
 static void memsync(void *buf, size_t size)
 {
@@ -49,14 +59,23 @@ static void memsync(void *buf, size_t size)
 		asm("dcbst %y0" :: "Z" (b[i]));
 }
 
+/*
+ * The Gekko handles misaligned word accesses in hardware, so only the
+ * destination is aligned and the source is read a word at a time as is.
+ */
+typedef uint32_t __attribute((aligned(1), may_alias)) unaligned_u32;
+
 bool memeq(const void *a, const void *b, size_t size)
 {
 	const uint8_t *x = a;
 	const uint8_t *y = b;
-	size_t i;
 
-	for (i = 0; i < size; ++i)
-		if (x[i] != y[i])
+	for (; size >= 4; size -= 4, x += 4, y += 4)
+		if (*(const unaligned_u32 *)x != *(const unaligned_u32 *)y)
+			return false;
+
+	while (size--)
+		if (*x++ != *y++)
 			return false;
 
 	return true;
@@ -65,9 +84,14 @@ bool memeq(const void *a, const void *b, size_t size)
 void memzero(void *buf, size_t size)
 {
 	uint8_t *b = buf;
-	uint8_t *e = b + size;
 
-	while (b != e)
+	for (; size && ((uintptr_t)b & 3); --size)
+		*b++ = '\0';
+
+	for (; size >= 4; size -= 4, b += 4)
+		*(uint32_t *)b = 0;
+
+	while (size--)
 		*b++ = '\0';
 }
 
@@ -75,15 +99,36 @@ void *memmove(void *dest, const void *src, size_t size)
 {
 	uint8_t *d = dest;
 	const uint8_t *s = src;
-	size_t i;
 
+	/*
+	 * Copying a word at a time in the same direction as the byte loop
+	 * never overwrites source bytes that are yet to be read.
+	 */
 	if (d < s) {
-		for (i = 0; i < size; ++i)
-			d[i] = s[i];
+		if (size >= 8) {
+			for (; (uintptr_t)d & 3; --size)
+				*d++ = *s++;
+
+			for (; size >= 4; size -= 4, d += 4, s += 4)
+				*(uint32_t *)d = *(const unaligned_u32 *)s;
+		}
+
+		while (size--)
+			*d++ = *s++;
 	} else if (d > s) {
-		i = size;
-		while (i-- > 0)
-			d[i] = s[i];
+		d += size;
+		s += size;
+
+		if (size >= 8) {
+			for (; (uintptr_t)d & 3; --size)
+				*--d = *--s;
+
+			for (; size >= 4; size -= 4)
+				*(uint32_t *)(d -= 4) = *(const unaligned_u32 *)(s -= 4);
+		}
+
+		while (size--)
+			*--d = *--s;
 	}
 
 	return dest;
@@ -91,6 +136,11 @@ void *memmove(void *dest, const void *src, size_t size)
 
 void main(void)
 {
+#ifdef PACKER_LZ4
+	if (lz4_decompress(executable_lz4, executable_lz4_size,
+	                   EXECUTABLE_ADDR, executable_bin_size) != executable_bin_size)
+		return;
+#else
 	xz_crc32_init();
 
 	xz_dec.bcj   = &xz_dec_bcj;
@@ -98,9 +148,10 @@ void main(void)
 
 	if (xz_dec_run(&xz_dec, &xz_buf) != XZ_STREAM_END)
 		return;
+#endif
 
 	memmove(entrypoint + 8, &__argv, sizeof(__argv));
-	memsync(xz_buf.out, xz_buf.out_pos);
+	memsync(EXECUTABLE_ADDR, executable_bin_size);
 
 	_sync();
 	mthid0(mfhid0() | 0xC00);
@@ -361,11 +361,20 @@ static bool dict_repeat(struct dictionary *dict, uint32_t *len, uint32_t dist)
 	if (dist >= dict->pos)
 		back += dict->end;
 
-	do {
-		dict->buf[dict->pos++] = dict->buf[back++];
-		if (back == dict->end)
-			back = 0;
-	} while (--left > 0);
+	/*
+	 * In single-call mode the dictionary is the output buffer and never
+	 * wraps, so a match that doesn't overlap itself is a plain copy.
+	 */
+	if (DEC_IS_SINGLE(dict->mode) && left <= dist + 1) {
+		memcpy(dict->buf + dict->pos, dict->buf + back, left);
+		dict->pos += left;
+	} else {
+		do {
+			dict->buf[dict->pos++] = dict->buf[back++];
+			if (back == dict->end)
+				back = 0;
+		} while (--left > 0);
+	}
 
 	if (dict->full < dict->pos)
 		dict->full = dict->pos;
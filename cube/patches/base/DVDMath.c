@@ -7,6 +7,7 @@
 #include <math.h>
 
 #include "common.h"
+#include "dolphin/os.h"
 
 // The size of the first GC disc layer in bytes (712880 sectors, 2048 bytes per sector)
 static const u32 DISC_LAYER_SIZE = 0x57058000;
@@ -149,3 +150,109 @@ double CalculateRawDiscReadTime(u32 offset, u32 length)
 
   return length / speed;
 }
+
+// Fixed-point versions of the above for use from the emulated DI interrupt
+// path, returning timebase ticks without touching the FPU.
+//
+// Disc positions are kept in track turns (radius / pitch) as Q16. A coarse
+// table every 16 MiB gives a first guess which is refined by one Newton step
+// against the exact square, since the fractional turn is the disc angle.
+// Generated from CalculatePhysicalDiscPosition(i << 24) / DISC_TRACK_PITCH.
+static const u32 DISC_TURNS[] = {
+  0x7EB06EB4, 0x7FC80AC8, 0x80DD4830, 0x81F03616, 0x8300E307, 0x840F5CF8,
+  0x851BB152, 0x8625ECF7, 0x872E1C48, 0x88344B33, 0x8938852F, 0x8A3AD54A,
+  0x8B3B462A, 0x8C39E215, 0x8D36B2F3, 0x8E31C254, 0x8F2B1976, 0x9022C145,
+  0x9118C262, 0x920D2524, 0x92FFF19F, 0x93F12FA2, 0x94E0E6BE, 0x95CF1E49,
+  0x96BBDD5C, 0x97A72ADB, 0x98910D73, 0x99798BA0, 0x9A60ABAD, 0x9B4673B4,
+  0x9C2AE9A4, 0x9D0E1341, 0x9DEFF624, 0x9ED097C0, 0x9FAFFD60, 0xA08E2C2C,
+  0xA16B2927, 0xA246F932, 0xA321A10E, 0xA3FB255B, 0xA4D38A9D, 0xA5AAD537,
+  0xA6810973, 0xA7562B7C, 0xA82A3F66, 0xA8FD492B, 0xA9CF4CA9, 0xAAA04DA9,
+  0xAB704FDE, 0xAC3F56E1, 0xAD0D6639, 0xADDA8156, 0xAEA6AB94, 0xAF71E83D,
+  0xB03C3A87, 0xB105A594, 0xB1CE2C78, 0xB295D231, 0xB35C99B2, 0xB42285D8,
+  0xB4E79974, 0xB5ABD747, 0xB66F4202, 0xB731DC4A, 0xB7F3A8B3, 0xB8B4A9C6,
+  0xB974E1FE, 0xBA3453C8, 0xBAF30186, 0xBBB0ED8E, 0xBC6E1A29, 0xBD2A8996,
+  0xBDE63E08, 0xBEA139A7, 0xBF5B7E91, 0xC0150ED9, 0xC0CDEC8A, 0xC18619A2,
+  0xC23D9819, 0xC2F469DB, 0xC3AA90CD, 0xC4600EC9, 0xC514E5A2, 0xC5C91724,
+  0xC67CA510, 0xC72F9120, 0xC7E1DD08, 0xC8938A72, 0xC9449B03, 0xC9F51056,
+};
+
+// Ticks per byte as Q24 at the same positions, from the read speeds above.
+static const u32 DISC_READ_TICKS[] = {
+  0x134FD900, 0x1327161C, 0x12FF542B, 0x12D888C1, 0x12B2AA06, 0x128DAEB0,
+  0x12698DF2, 0x12463F7B, 0x1223BB68, 0x1201FA3F, 0x11E0F4E8, 0x11C0A4A7,
+  0x11A10316, 0x11820A1C, 0x1163B3EE, 0x1145FB08, 0x1128DA27, 0x110C4C47,
+  0x10F04C9D, 0x10D4D699, 0x10B9E5DB, 0x109F7636, 0x108583AC, 0x106C0A6B,
+  0x105306C9, 0x103A7544, 0x1022527E, 0x100A9B40, 0x0FF34C6F, 0x0FDC6314,
+  0x0FC5DC53, 0x0FAFB56E, 0x0F99EBC4, 0x0F847CC9, 0x0F6F660D, 0x0F5AA538,
+  0x0F463805, 0x0F321C47, 0x0F1E4FE4, 0x0F0AD0D5, 0x0EF79D26, 0x0EE4B2F5,
+  0x0ED2106F, 0x0EBFB3D3, 0x0EAD9B6E, 0x0E9BC59D, 0x0E8A30C9, 0x0E78DB6B,
+  0x0E67C406, 0x0E56E92B, 0x0E464978, 0x0E35E393, 0x0E25B630, 0x0E15C00C,
+  0x0E05FFEF, 0x0DF674A8, 0x0DE71D12, 0x0DD7F811, 0x0DC9048F, 0x0DBA4181,
+  0x0DABADE1, 0x0D9D48B4, 0x0D8F1103, 0x0D8105E1, 0x0D732665, 0x0D6571B0,
+  0x0D57E6E5, 0x0D4A8530, 0x0D3D4BC3, 0x0D3039D4, 0x0D234E9F, 0x0D168967,
+  0x0D09E971, 0x0CFD6E0A, 0x0CF11682, 0x0CE4E22D, 0x0CD8D065, 0x0CCCE088,
+  0x0CC111F7, 0x0CB56419, 0x0CA9D657, 0x0C9E681E, 0x0C9318DF, 0x0C87E810,
+  0x0C7CD528, 0x0C71DFA3, 0x0C6706FE, 0x0C5C4ABD, 0x0C51AA62, 0x0C472577,
+};
+
+#define DISC_TABLE_SHIFT 24
+
+// (DISC_INNER_RADIUS / DISC_TRACK_PITCH)^2 and its growth per byte, as Q32
+static const u64 DISC_INNER_TURNS2 = 4517715782498173952ULL;
+static const u64 DISC_TURNS2_PER_BYTE = 4663046690ULL;
+
+// Seek velocities as ticks per turn of head travel, Q16
+static const u32 SHORT_SEEK_MAX_TURNS = 88562162;
+static const u32 SHORT_SEEK_TICKS = 98205696;
+static const u32 LONG_SEEK_TICKS = 8838513;
+
+// Disc rotations per tick as Q64 and ticks per rotation
+static const u64 ROTATIONS_PER_TICK = 12981042125944ULL;
+static const u32 TICKS_PER_ROTATION = 1421053;
+
+static u32 CalculateDiscTurns(u32 offset)
+{
+  u32 index = MIN(offset >> DISC_TABLE_SHIFT, sizeof(DISC_TURNS) / sizeof(*DISC_TURNS) - 2);
+  u32 fraction = offset - (index << DISC_TABLE_SHIFT);
+
+  u32 turns = DISC_TURNS[index] +
+      ((u64)(DISC_TURNS[index + 1] - DISC_TURNS[index]) * fraction >> DISC_TABLE_SHIFT);
+
+  s32 error = (s64)(DISC_INNER_TURNS2 + offset * DISC_TURNS2_PER_BYTE - (u64)turns * turns) >> 17;
+
+  return turns + error / (s32)(turns >> 16);
+}
+
+OSTick CalculateSeekTicks(u32 offset_from, u32 offset_to)
+{
+  const u32 turns_from = CalculateDiscTurns(offset_from);
+  const u32 turns_to = CalculateDiscTurns(offset_to);
+
+  const u32 distance = turns_from > turns_to ? turns_from - turns_to : turns_to - turns_from;
+
+  if (distance < SHORT_SEEK_MAX_TURNS)
+    return ((u64)distance * SHORT_SEEK_TICKS >> 32) + OSMillisecondsToTicks(35);
+  else
+    return ((u64)distance * LONG_SEEK_TICKS >> 32) + OSMillisecondsToTicks(75);
+}
+
+OSTick CalculateRotationalLatencyTicks(u32 offset, OSTime time)
+{
+  const u16 target_angle = CalculateDiscTurns(offset);
+  const u16 start_angle = (u64)time * ROTATIONS_PER_TICK >> 48;
+
+  return (u64)(u16)(target_angle - start_angle) * TICKS_PER_ROTATION >> 16;
+}
+
+OSTick CalculateRawDiscReadTicks(u32 offset, u32 length)
+{
+  offset += length / 2;
+
+  u32 index = MIN(offset >> DISC_TABLE_SHIFT, sizeof(DISC_READ_TICKS) / sizeof(*DISC_READ_TICKS) - 2);
+  u32 fraction = offset - (index << DISC_TABLE_SHIFT);
+
+  u32 ticks = DISC_READ_TICKS[index] -
+      ((u64)(DISC_READ_TICKS[index] - DISC_READ_TICKS[index + 1]) * fraction >> DISC_TABLE_SHIFT);
+
+  return (u64)length * ticks >> 24;
+}
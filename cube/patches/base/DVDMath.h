@@ -5,8 +5,13 @@
 #pragma once
 
 #include "common.h"
+#include "dolphin/os.h"
 
 double CalculatePhysicalDiscPosition(u32 offset);
 double CalculateSeekTime(u32 offset_from, u32 offset_to);
 double CalculateRotationalLatency(u32 offset, double time);
 double CalculateRawDiscReadTime(u32 offset, u32 length);
+
+OSTick CalculateSeekTicks(u32 offset_from, u32 offset_to);
+OSTick CalculateRotationalLatencyTicks(u32 offset, OSTime time);
+OSTick CalculateRawDiscReadTicks(u32 offset, u32 length);
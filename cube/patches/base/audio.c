@@ -40,9 +40,10 @@ static inline int32_t clamp_s22(int32_t x)
 		return x;
 }
 
-static int_fast16_t decode_sample(uint8_t header, int sample, int32_t prev[2])
+__attribute((always_inline))
+static inline void decode_frame(uint8_t header, const uint8_t *in, int nibble, int32_t prev[2], int16_t *out)
 {
-	static uint8_t table[][4] = {
+	static const uint8_t table[][4] = {
 		{ 0, 60, 115, 98 },
 		{ 0,  0,  52, 55 }
 	};
@@ -50,15 +51,25 @@ static int_fast16_t decode_sample(uint8_t header, int sample, int32_t prev[2])
 	int index = (header & 0x30) >> 4;
 	int shift = header & 0xF;
 
-	int32_t curr = prev[0] * table[0][index]
-	             - prev[1] * table[1][index];
+	int32_t coef0 = table[0][index];
+	int32_t coef1 = table[1][index];
+	int32_t prev0 = prev[0];
+	int32_t prev1 = prev[1];
+
+	for (int i = 0; i < 28; i++) {
+		int32_t curr = prev0 * coef0 - prev1 * coef1;
 
-	curr = clamp_s22((curr + 32) >> 6) + ((int16_t)(sample << 12) >> shift << 6);
+		curr = clamp_s22((curr + 32) >> 6) + ((int16_t)(((in[i] >> nibble) & 0xF) << 12) >> shift << 6);
 
-	prev[1] = prev[0];
-	prev[0] = curr;
+		prev1 = prev0;
+		prev0 = curr;
+
+		*out = clamp_s16((curr + 32) >> 6);
+		out += sizeof(sample_t) / sizeof(int16_t);
+	}
 
-	return clamp_s16((curr + 32) >> 6);
+	prev[0] = prev0;
+	prev[1] = prev1;
 }
 
 static void pop_sample(fifo_t *fifo, sample_t *sample)
@@ -72,17 +83,6 @@ static void pop_sample(fifo_t *fifo, sample_t *sample)
 	fifo->used -= sizeof(sample_t);
 }
 
-static void push_sample(fifo_t *fifo, sample_t sample)
-{
-	if (fifo_space(fifo) < sizeof(sample_t)) return;
-	*(sample_t *)fifo->write_ptr = sample;
-
-	fifo->write_ptr += sizeof(sample_t);
-	if (fifo->write_ptr == fifo->end_ptr)
-		fifo->write_ptr = fifo->start_ptr;
-	fifo->used += sizeof(sample_t);
-}
-
 void adpcm_reset(adpcm_t *adpcm)
 {
 	adpcm->l[0] = adpcm->l[1] = 0;
@@ -92,29 +92,82 @@ void adpcm_reset(adpcm_t *adpcm)
 void adpcm_decode(adpcm_t *adpcm, fifo_t *fifo, const uint8_t *in, int count)
 {
 	for (int j = 0; j < count; j += 28, in += 32) {
-		for (int i = 0; i < 28; i++) {
-			sample_t sample;
-			sample.l = decode_sample(in[0], in[4 + i] & 0xF, adpcm->l);
-			sample.r = decode_sample(in[1], in[4 + i] >>  4, adpcm->r);
-			push_sample(fifo, sample);
-		}
+		sample_t frame[28], *out = fifo->write_ptr;
+
+		// Decode straight into the FIFO unless the frame would wrap around
+		if (fifo_space(fifo) < sizeof(frame) || fifo->end_ptr - fifo->write_ptr < sizeof(frame))
+			out = frame;
+
+		decode_frame(in[0], in + 4, 0, adpcm->l, &out->l);
+		decode_frame(in[1], in + 4, 4, adpcm->r, &out->r);
+
+		if (out != frame) {
+			fifo->write_ptr += sizeof(frame);
+			if (fifo->write_ptr == fifo->end_ptr)
+				fifo->write_ptr = fifo->start_ptr;
+			fifo->used += sizeof(frame);
+		} else if (fifo_space(fifo) >= sizeof(frame))
+			fifo_write(fifo, frame, sizeof(frame));
 	}
 }
 
-void mix_samples(volatile sample_t *out, volatile sample_t *in, fifo_t *fifo, int count, bool _3to2, uint8_t volume_l, uint8_t volume_r)
+void resampler_reset(resampler_t *resampler)
+{
+	resampler->pos = 0;
+
+	for (int i = 0; i < RESAMPLER_TAPS * 2; i++)
+		resampler->history[i] = (sample_t){0};
+}
+
+static void resampler_push(resampler_t *resampler, fifo_t *fifo)
+{
+	sample_t sample = {0};
+	pop_sample(fifo, &sample);
+
+	resampler->history[resampler->pos] =
+	resampler->history[resampler->pos + RESAMPLER_TAPS] = sample;
+
+	if (++resampler->pos == RESAMPLER_TAPS)
+		resampler->pos = 0;
+}
+
+static sample_t resampler_filter(resampler_t *resampler, int phase)
+{
+	// 48kHz to 32kHz as 2x interpolation and 3x decimation of a 24-tap
+	// Kaiser-windowed (beta 3.4) sinc lowpass at 15kHz, split into its two
+	// phases. Anything from 20kHz up is held 40dB down, see pc/patchtest.
+	static const int16_t table[2][RESAMPLER_TAPS] = {
+		{ -175,  448,   97, -1774, 2475, 9815, 6760, -757, -1043,  632,   34, -128 },
+		{ -128,   34,  632, -1043, -757, 6760, 9815, 2475, -1774,   97,  448, -175 }
+	};
+
+	const sample_t *history = &resampler->history[resampler->pos];
+	int32_t r = 0x2000, l = 0x2000;
+
+	for (int i = 0; i < RESAMPLER_TAPS; i++) {
+		r += history[i].r * table[phase][i];
+		l += history[i].l * table[phase][i];
+	}
+
+	return (sample_t){clamp_s16(r >> 14), clamp_s16(l >> 14)};
+}
+
+void mix_samples(volatile sample_t *out, volatile sample_t *in, fifo_t *fifo, resampler_t *resampler, int count, bool _3to2, uint8_t volume_l, uint8_t volume_r)
 {
 	for (int i = 0; i < count; i++) {
-		sample_t sample = {0};
-		pop_sample(fifo, &sample);
+		sample_t sample;
+
+		resampler_push(resampler, fifo);
+
+		if (_3to2) {
+			sample = resampler_filter(resampler, i & 1);
+			if (i & 1) resampler_push(resampler, fifo);
+		} else
+			sample = resampler->history[resampler->pos + RESAMPLER_TAPS - 1];
+
 		int_fast16_t r = sample.r;
 		int_fast16_t l = sample.l;
 
-		if (i & _3to2) {
-			pop_sample(fifo, &sample);
-			r = (r + sample.r) >> 1;
-			l = (l + sample.l) >> 1;
-		}
-
 		sample = in[i];
 		r = (r * volume_r >> 8) + sample.r;
 		l = (l * volume_l >> 8) + sample.l;
@@ -34,9 +34,17 @@ typedef struct {
 	int16_t l;
 } sample_t;
 
+#define RESAMPLER_TAPS 12
+
+typedef struct {
+	int pos;
+	sample_t history[RESAMPLER_TAPS * 2];
+} resampler_t;
+
 void adpcm_reset(adpcm_t *adpcm);
 void adpcm_decode(adpcm_t *adpcm, fifo_t *fifo, const uint8_t *in, int count);
 
-void mix_samples(volatile sample_t *out, volatile sample_t *in, fifo_t *fifo, int count, bool _3to2, uint8_t volume_l, uint8_t volume_r);
+void resampler_reset(resampler_t *resampler);
+void mix_samples(volatile sample_t *out, volatile sample_t *in, fifo_t *fifo, resampler_t *resampler, int count, bool _3to2, uint8_t volume_l, uint8_t volume_r);
 
 #endif /* AUDIO_H */
@@ -515,6 +515,7 @@ static struct {
 	#ifdef DTK
 	adpcm_t adpcm;
 	fifo_t fifo;
+	resampler_t resampler;
 	uint8_t (*buffer)[512];
 	#endif
 
@@ -625,8 +626,26 @@ static void di_update_interrupts(void)
 	pi_update_interrupts();
 }
 
+#ifdef DI_TRACE
+// Timestamped records of emulated DI activity sent out over the USB Gecko,
+// so that a game's access pattern can be captured and replayed on a host.
+// The full time base is sent as the read speed model depends on it.
+void di_trace(uint32_t type, uint32_t arg0, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+{
+	struct {
+		uint32_t type;
+		uint32_t args[4];
+		OSTime time;
+	} trace = {type, {arg0, arg1, arg2, arg3}, OSGetTime()};
+
+	WriteUARTN(&trace, sizeof(trace));
+}
+#endif
+
 void di_error(uint32_t error)
 {
+	di_trace(DI_TRACE_COMPLETE, di.reg.cmdbuf0, error, di.reg.mar, di.reg.length);
+
 	di.reg.sr |=  0b0000100;
 	di.reg.cr &= ~0b001;
 	di.error = error;
@@ -635,6 +654,8 @@ void di_error(uint32_t error)
 
 void di_complete_transfer()
 {
+	di_trace(DI_TRACE_COMPLETE, di.reg.cmdbuf0, 0, di.reg.mar, di.reg.length);
+
 	if (di.reg.cr & 0b010) {
 		di.reg.mar += di.reg.length;
 		di.reg.length = 0;
@@ -672,6 +693,8 @@ static void di_execute_command()
 {
 	uint32_t result = 0;
 
+	di_trace(DI_TRACE_COMMAND, di.reg.cmdbuf0, di.reg.cmdbuf1, di.reg.cmdbuf2, di.reg.length);
+
 #ifdef FLIPPY
 	// extern void gprintf(const char *fmt, ...);
 	// gprintf("di_execute_command %08x\n", di.reg.cmdbuf0);
@@ -752,6 +775,7 @@ static void di_execute_command()
 
 					adpcm_reset(&dtk.adpcm);
 					fifo_reset(&dtk.fifo);
+					resampler_reset(&dtk.resampler);
 					#endif
 					break;
 				}
@@ -946,7 +970,7 @@ static void dsp_write(unsigned index, uint16_t value)
 				uint32_t aicr = AI[0];
 				uint32_t aivr = AI[1];
 
-				if (aicr & 0b0000001) mix_samples(out, in, &dtk.fifo, count, aicr & 0b1000000, aivr, aivr >> 8);
+				if (aicr & 0b0000001) mix_samples(out, in, &dtk.fifo, &dtk.resampler, count, aicr & 0b1000000, aivr, aivr >> 8);
 				else if (out != in) out = memcpy(out, in, length);
 
 				DSP[12] = (intptr_t)out;
@@ -1195,6 +1219,9 @@ static bool ppc_store32(uint32_t address, uint32_t value)
 	if ((address & ~0b111) == 0x800000E8) {
 		if (value == 0xfee1dead) {
 			asm volatile("mtdabr %0" :: "r" (0x800000E8));
+			#ifdef CARD_EMULATOR
+			card_fini();
+			#endif
 			reset_devices();
 		}
 		return true;
@@ -1350,6 +1377,9 @@ void init(void **arenaLo, void **arenaHi)
 	#ifdef ETH_EMULATOR
 	eth_init(arenaLo, arenaHi);
 	#endif
+	#ifdef CARD_EMULATOR
+	card_init(arenaLo, arenaHi);
+	#endif
 	#ifdef DI_PASSTHROUGH
 	DI[0] = 0b0101010;
 	DI[1] = 0b010;
@@ -1378,5 +1408,8 @@ void idle_thread(void)
 void fini(void)
 {
 	OSDisableInterrupts();
+	#ifdef CARD_EMULATOR
+	card_fini();
+	#endif
 	reset_devices();
 }
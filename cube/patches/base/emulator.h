@@ -77,4 +77,15 @@ void di_close_cover();
 
 void dvd_schedule_read(uint32_t offset, uint32_t length, OSAlarmHandler handler);
 
+#ifdef DI_TRACE
+#define DI_TRACE_COMMAND  0x44495243 // 'DIRC'
+#define DI_TRACE_COMPLETE 0x44494350 // 'DICP'
+#define DI_TRACE_SCHEDULE 0x44495343 // 'DISC'
+#define DI_TRACE_FRAG     0x44494652 // 'DIFR'
+
+void di_trace(uint32_t type, uint32_t arg0, uint32_t arg1, uint32_t arg2, uint32_t arg3);
+#else
+#define di_trace(...) ((void)0)
+#endif
+
 #endif /* EMULATOR_H */
@@ -20,6 +20,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <string.h>
 #include "common.h"
 #include "dolphin/exi.h"
 #include "dolphin/os.h"
@@ -30,6 +31,13 @@
 #define carda_read_callback exi0_complete_transfer
 #define cardb_read_callback exi1_complete_transfer
 
+#define CARD_PAGE_SIZE  512
+#define CARD_BLOCK_SIZE 8192
+
+#ifndef CARD_FLUSH_DELAY
+#define CARD_FLUSH_DELAY 100
+#endif
+
 static void carda_write_callback(void *address, uint32_t length);
 static void cardb_write_callback(void *address, uint32_t length);
 
@@ -41,6 +49,8 @@ static struct {
 	#ifdef ASYNC_READ
 	frag_callback read_callback;
 	frag_callback write_callback;
+	void *buffer;
+	uint32_t length;
 	#endif
 } card[2] = {
 	{
@@ -70,6 +80,152 @@ static void cardb_write_callback(void *address, uint32_t length)
 	exi1_complete_transfer();
 }
 
+#ifdef ASYNC_READ
+// Pages written in order from the start of a block are gathered here and
+// written out together once the block is complete. The card library only
+// considers a block written once its last page is, so that transfer is
+// held back until the whole block is out. A block left incomplete is
+// written out once the card has been idle for CARD_FLUSH_DELAY ms.
+static OSAlarm block_alarm;
+
+static struct {
+	int chan;
+	unsigned waiter;
+	uint32_t offset;
+	uint32_t length;
+	uint32_t flushed;
+	bool flushing;
+	uint8_t (*data)[CARD_BLOCK_SIZE];
+	void (*resume)(unsigned chan);
+} block = {
+	.chan = -1
+};
+
+static void card_complete_transfer(unsigned chan)
+{
+	if (chan == EXI_CHANNEL_0)
+		exi0_complete_transfer();
+	else
+		exi1_complete_transfer();
+}
+
+static void card_flush_callback(void *address, uint32_t length);
+
+static bool card_flush_next(void)
+{
+	return frag_write_async(FRAGS_CARD(block.chan), *block.data + block.flushed,
+		block.length - block.flushed, block.offset + block.flushed, card_flush_callback);
+}
+
+static void card_flush_callback(void *address, uint32_t length)
+{
+	block.flushed += length;
+
+	if (length && block.flushed < block.length && card_flush_next())
+		return;
+	if (block.flushed < block.length)
+		card[block.chan].status |= 0b00001000;
+
+	block.chan = -1;
+	block.flushing = false;
+	block.resume(block.waiter);
+}
+
+static bool card_flush(unsigned waiter, void (*resume)(unsigned chan))
+{
+	block.waiter = waiter;
+	block.resume = resume;
+	block.flushed = 0;
+	block.flushing = true;
+
+	if (card_flush_next())
+		return true;
+
+	card[block.chan].status |= 0b00001000;
+	block.chan = -1;
+	block.flushing = false;
+	return false;
+}
+
+static void card_resume_idle(unsigned chan)
+{
+}
+
+// Waits out a block that is being written out after the card went idle.
+static bool card_wait(unsigned chan, void (*resume)(unsigned chan))
+{
+	if (!block.flushing || block.resume != card_resume_idle)
+		return false;
+
+	block.waiter = chan;
+	block.resume = resume;
+	return true;
+}
+
+static void card_flush_alarm(OSAlarm *alarm, OSContext *context)
+{
+	if (block.chan >= 0 && !block.flushing)
+		card_flush(block.chan, card_resume_idle);
+}
+
+static bool card_write(unsigned chan, void *buffer);
+
+static void card_resume_write(unsigned chan)
+{
+	if (!card_write(chan, card[chan].buffer))
+		card_complete_transfer(chan);
+}
+
+static void card_resume_erase(unsigned chan)
+{
+	if (card[chan].status & 0b00000010)
+		exi_interrupt(chan);
+}
+
+static void card_resume_read(unsigned chan)
+{
+	if (!frag_read_async(FRAGS_CARD(chan), card[chan].buffer, card[chan].length, card[chan].offset, card[chan].read_callback))
+		card_complete_transfer(chan);
+}
+
+static bool card_write(unsigned chan, void *buffer)
+{
+	uint32_t offset = card[chan].offset;
+
+	if (card_wait(chan, card_resume_write)) {
+		card[chan].buffer = buffer;
+		return true;
+	}
+
+	// The other slot's block is still being written out.
+	if (block.flushing)
+		return frag_write_async(FRAGS_CARD(chan), buffer, CARD_PAGE_SIZE, offset, card[chan].write_callback);
+
+	if (block.chan >= 0 && (block.chan != (int)chan || block.offset + block.length != offset)) {
+		card[chan].buffer = buffer;
+		if (card_flush(chan, card_resume_write))
+			return true;
+	}
+
+	if (block.chan < 0) {
+		if (offset % CARD_BLOCK_SIZE)
+			return frag_write_async(FRAGS_CARD(chan), buffer, CARD_PAGE_SIZE, offset, card[chan].write_callback);
+
+		block.chan = chan;
+		block.offset = offset;
+		block.length = 0;
+	}
+
+	memcpy(*block.data + block.length, buffer, CARD_PAGE_SIZE);
+	block.length += CARD_PAGE_SIZE;
+
+	if (block.length == CARD_BLOCK_SIZE)
+		return card_flush(chan, card_complete_transfer);
+
+	return false;
+}
+#endif
+
 uint8_t card_imm(unsigned chan, uint8_t data)
 {
 	uint8_t result = ~0;
@@ -143,6 +299,13 @@ bool card_dma(unsigned chan, uint32_t address, uint32_t length, int type)
 		{
 			if (card[chan].position >= 5 && type == EXI_READ) {
 				#ifdef ASYNC_READ
+				if (block.chan == (int)chan) {
+					card[chan].buffer = buffer;
+					card[chan].length = length;
+					if (card_wait(chan, card_resume_read) ||
+						card_flush(chan, card_resume_read))
+						return true;
+				}
 				return frag_read_async(FRAGS_CARD(chan), buffer, length, card[chan].offset, card[chan].read_callback);
 				#else
 				frag_read(FRAGS_CARD(chan), buffer, length, card[chan].offset);
@@ -155,7 +318,7 @@ bool card_dma(unsigned chan, uint32_t address, uint32_t length, int type)
 			if (card[chan].position == 5 && type == EXI_WRITE) {
 				if (card[chan].offset % 512 == 0) {
 					#ifdef ASYNC_READ
-					return frag_write_async(FRAGS_CARD(chan), buffer, 512, card[chan].offset, card[chan].write_callback);
+					return card_write(chan, buffer);
 					#else
 					if (frag_write(FRAGS_CARD(chan), buffer, 512, card[chan].offset) != 512) card[chan].status |= 0b00001000;
 					#endif
@@ -173,6 +336,32 @@ void card_select(unsigned chan)
 {
 }
 
+void card_init(void **arenaLo, void **arenaHi)
+{
+	#ifdef ASYNC_READ
+	*arenaHi -= sizeof(*block.data); block.data = OSCachedToUncached(*arenaHi);
+	#endif
+}
+
+void card_fini(void)
+{
+	#ifdef ASYNC_READ
+	OSCancelAlarm(&block_alarm);
+
+	// A block being written out won't finish with interrupts disabled, so
+	// whatever hasn't completed yet is written again here.
+	if (block.chan >= 0) {
+		for (uint32_t i = block.flushing ? block.flushed : 0; i < block.length; ) {
+			int length = frag_write(FRAGS_CARD(block.chan), *block.data + i, block.length - i, block.offset + i);
+			if (!length) break;
+			i += length;
+		}
+		block.chan = -1;
+		block.flushing = false;
+	}
+	#endif
+}
+
 void card_deselect(unsigned chan)
 {
 	switch (card[chan].command) {
@@ -182,6 +371,19 @@ void card_deselect(unsigned chan)
 			break;
 		}
 		case 0xF1:
+		{
+			#ifdef ASYNC_READ
+			// An erase means the card library is done with any gathered block.
+			if (card[chan].position >= 3 && block.chan >= 0)
+				if (card_wait(chan, card_resume_erase) ||
+					(!block.flushing && card_flush(chan, card_resume_erase)))
+					break;
+			#endif
+			if (card[chan].position >= 3)
+				if (card[chan].status & 0b00000010)
+					exi_interrupt(chan);
+			break;
+		}
 		case 0xF4:
 		{
 			if (card[chan].position >= 3)
@@ -191,6 +393,10 @@ void card_deselect(unsigned chan)
 		}
 		case 0xF2:
 		{
+			#ifdef ASYNC_READ
+			if (card[chan].position >= 5 && block.chan >= 0 && !block.flushing)
+				OSSetAlarm(&block_alarm, OSMillisecondsToTicks(CARD_FLUSH_DELAY), card_flush_alarm);
+			#endif
 			if (card[chan].position >= 5)
 				if (card[chan].status & 0b00000010)
 					exi_interrupt(chan);
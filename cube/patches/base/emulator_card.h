@@ -27,5 +27,7 @@ uint8_t card_imm(unsigned chan, uint8_t data);
 bool card_dma(unsigned chan, uint32_t address, uint32_t length, int type);
 void card_select(unsigned chan);
 void card_deselect(unsigned chan);
+void card_init(void **arenaLo, void **arenaHi);
+void card_fini(void);
 
 #endif /* EMULATOR_CARD_H */
@@ -28,6 +28,10 @@
 #include "emulator.h"
 #include "emulator_eth.h"
 
+#ifndef ETH_BACKLOG_SIZE
+#define ETH_BACKLOG_SIZE 8192
+#endif
+
 static struct {
 	struct {
 		int position;
@@ -46,6 +50,16 @@ static struct {
 		int txfifocnt;
 		uint8_t (*fifo)[BBA_TX_MAX_PACKET_SIZE];
 	} mac;
+
+	struct {
+		uint16_t head;
+		uint16_t tail;
+		uint16_t count;
+		uint8_t (*backlog)[ETH_BACKLOG_SIZE];
+
+		uint32_t dropped;
+		uint32_t high_water;
+	} rx;
 } eth;
 
 static void eth_update_interrupts(void)
@@ -57,16 +71,20 @@ static void eth_update_interrupts(void)
 		exi_interrupt(EXI_CHANNEL_2);
 }
 
-void eth_mac_receive(const void *data, size_t size)
+static bool eth_mac_deliver(const void *data, size_t size)
 {
-	if (!(eth.mac.regs[BBA_NCRA] & BBA_NCRA_SR))
-		return;
-
 	uint16_t bp = __lhbrx(&eth.mac.regs[BBA_BP]);
 	uint16_t rwp = __lhbrx(&eth.mac.regs[BBA_RWP]);
 	uint16_t rrp = __lhbrx(&eth.mac.regs[BBA_RRP]);
 	uint16_t rhbp = __lhbrx(&eth.mac.regs[BBA_RHBP]);
 
+	int pages = rhbp - bp + 1;
+	int used = (rwp - rrp + pages) % pages;
+
+	// Leave a page between the write and read pointers so that a full ring isn't mistaken for an empty one.
+	if ((int)((sizeof(bba_header_t) + size + 255) / 256) > pages - used - 1)
+		return false;
+
 	bba_page_t *page = (bba_page_t *)(*eth.mac.data);
 	bba_header_t *bba = (bba_header_t *)page[rwp];
 	uint8_t *dst = bba->data;
@@ -76,7 +94,7 @@ void eth_mac_receive(const void *data, size_t size)
 	bba->status = 0x00;
 
 	while (size) {
-		int page_size = MIN(page[rwp + 1] - dst, size);
+		size_t page_size = MIN((size_t)(page[rwp + 1] - dst), size);
 		memcpy(dst, data, page_size);
 		data += page_size;
 		size -= page_size;
@@ -84,20 +102,88 @@ void eth_mac_receive(const void *data, size_t size)
 		if (rwp == rhbp) rwp = bp;
 		else rwp++;
 		dst = page[rwp];
+	}
 
-		if (rwp == rrp)
-			break;
+	bba->next = rwp;
+	__sthbrx(&eth.mac.regs[BBA_RWP], rwp);
+
+	if (eth.mac.regs[BBA_IMR] & BBA_IMR_RIM) {
+		eth.mac.regs[BBA_IR] |= BBA_IR_RI;
+		eth_update_interrupts();
 	}
 
-	if (!size) {
-		bba->next = rwp;
-		__sthbrx(&eth.mac.regs[BBA_RWP], rwp);
+	return true;
+}
 
-		if (eth.mac.regs[BBA_IMR] & BBA_IMR_RIM) {
-			eth.mac.regs[BBA_IR] |= BBA_IR_RI;
-			eth_update_interrupts();
+static void eth_backlog_push(const void *data, size_t size)
+{
+	uint16_t length = 4 + ((size + 3) & ~3);
+	uint16_t tail = eth.rx.tail;
+
+	if (!eth.rx.count) {
+		eth.rx.head = tail = 0;
+	} else if (tail > eth.rx.head) {
+		if (length > ETH_BACKLOG_SIZE - tail) {
+			if (length > eth.rx.head)
+				goto drop;
+
+			// A zero length marks the rest of the backlog as unused.
+			*(uint16_t *)(*eth.rx.backlog + tail) = 0;
+			tail = 0;
 		}
+	} else if (length > eth.rx.head - tail) {
+		goto drop;
 	}
+
+	*(uint16_t *)(*eth.rx.backlog + tail) = size;
+	memcpy(*eth.rx.backlog + tail + 4, data, size);
+
+	eth.rx.tail = (tail + length) % ETH_BACKLOG_SIZE;
+	eth.rx.count++;
+
+	if (eth.rx.high_water < eth.rx.count)
+		eth.rx.high_water = eth.rx.count;
+	return;
+
+drop:
+	eth.rx.dropped++;
+}
+
+static void eth_backlog_drain(void)
+{
+	while (eth.rx.count) {
+		uint16_t size = *(uint16_t *)(*eth.rx.backlog + eth.rx.head);
+
+		if (!size) {
+			eth.rx.head = 0;
+			continue;
+		}
+
+		if (!eth_mac_deliver(*eth.rx.backlog + eth.rx.head + 4, size))
+			break;
+
+		eth.rx.head = (eth.rx.head + 4 + ((size + 3) & ~3)) % ETH_BACKLOG_SIZE;
+		eth.rx.count--;
+	}
+}
+
+void eth_mac_receive(const void *data, size_t size)
+{
+	if (!(eth.mac.regs[BBA_NCRA] & BBA_NCRA_SR))
+		return;
+
+	// Frames that didn't fit in the receive ring wait until the game frees up pages,
+	// and are delivered ahead of this one.
+	eth_backlog_drain();
+
+	if (eth.rx.count || !eth_mac_deliver(data, size))
+		eth_backlog_push(data, size);
+}
+
+void eth_mac_stats(uint32_t *dropped, uint32_t *high_water)
+{
+	*dropped = eth.rx.dropped;
+	*high_water = eth.rx.high_water;
 }
 
 static uint8_t eth_mac_read(void)
@@ -120,6 +206,9 @@ static void eth_mac_write(uint8_t value)
 		{
 			eth.mac.regs[address] = value;
 
+			if (eth.mac.regs[BBA_NCRA] & BBA_NCRA_RESET)
+				eth.rx.count = 0;
+
 			if ((eth.mac.regs[BBA_NCRA] & (BBA_NCRA_ST0 | BBA_NCRA_ST1)) == BBA_NCRA_ST1) {
 				bba_transmit_fifo(*eth.mac.fifo, eth.mac.txfifocnt);
 				eth.mac.txfifocnt = 0;
@@ -142,6 +231,12 @@ static void eth_mac_write(uint8_t value)
 			(*eth.mac.fifo)[eth.mac.txfifocnt++] = value;
 			break;
 		}
+		case BBA_RRP ... BBA_RRP + 1:
+		{
+			eth.mac.regs[address] = value;
+			eth_backlog_drain();
+			break;
+		}
 		#ifdef BBA
 		case BBA_NAFR_MAR0 ... BBA_NAFR_MAR7:
 		{
@@ -243,8 +338,18 @@ void eth_exi_dma(uint32_t address, uint32_t length, int type)
 			}
 		} else {
 			if (eth.exi.position >= 4 && type == EXI_READ) {
-				memcpy(buffer, *eth.mac.data + eth.mac.address, length);
-				eth.mac.address += length;
+				uint8_t *dst = buffer;
+				uint32_t remaining = length;
+
+				// Copy up to the end of the receive ring at a time, wrapping as eth_mac_read would.
+				while (remaining) {
+					uint16_t offset = (eth.mac.address % 8192 - 256) % 4096 + 256;
+					uint32_t size = MIN(remaining, sizeof(*eth.mac.data) - offset);
+					memcpy(dst, *eth.mac.data + offset, size);
+					eth.mac.address += size;
+					dst += size;
+					remaining -= size;
+				}
 			}
 		}
 	}
@@ -265,6 +370,11 @@ void eth_init(void **arenaLo, void **arenaHi)
 {
 	eth.mac.txfifocnt = 0;
 
+	eth.rx.count = 0;
+	eth.rx.dropped = 0;
+	eth.rx.high_water = 0;
+
+	*arenaHi -= sizeof(*eth.rx.backlog); eth.rx.backlog = *arenaHi;
 	*arenaHi -= sizeof(*eth.mac.fifo); eth.mac.fifo = *arenaHi;
 	*arenaHi -= sizeof(*eth.mac.data); eth.mac.data = *arenaHi;
 
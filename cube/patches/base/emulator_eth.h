@@ -24,6 +24,7 @@
 #include <stddef.h>
 
 void eth_mac_receive(const void *data, size_t size);
+void eth_mac_stats(uint32_t *dropped, uint32_t *high_water);
 
 uint8_t eth_exi_imm(uint8_t data);
 void eth_exi_dma(uint32_t address, uint32_t length, int type);
@@ -22,6 +22,7 @@
 #include <stdbool.h>
 #include "common.h"
 #include "dolphin/os.h"
+#include "emulator.h"
 #include "frag.h"
 
 #define DEVICE_DISC 0
@@ -71,9 +72,12 @@ static bool frag_get(int file, uint32_t offset, size_t size, frag_t *frag)
 		frag->offset = offset - frags[i].offset;
 		frag->size = MIN(size, OSRoundUp32B(frags[i].size) - frag->offset);
 		frag->data = frags[i].data;
+
+		di_trace(DI_TRACE_FRAG, file, offset, frag->size, i);
 		return true;
 	}
 
+	di_trace(DI_TRACE_FRAG, file, offset, 0, -1);
 	return false;
 }
 
@@ -123,7 +127,7 @@ bool frag_read_write_async(int file, void *buffer, uint32_t length, uint32_t off
 
 int frag_read_complete(int file, void *buffer, uint32_t length, uint32_t offset)
 {
-	int i = 0;
+	uint32_t i = 0;
 
 	while (i < length) {
 		int read = frag_read(file, buffer + i, length - i, offset + i);
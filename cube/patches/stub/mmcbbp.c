@@ -33,8 +33,10 @@ void dly_us (UINT n);		/* Delay n microseconds (asmfunc.S) */
 #define CMD1	(0x40+1)	/* SEND_OP_COND (MMC) */
 #define	ACMD41	(0xC0+41)	/* SEND_OP_COND (SDC) */
 #define CMD8	(0x40+8)	/* SEND_IF_COND */
+#define CMD12	(0x40+12)	/* STOP_TRANSMISSION */
 #define CMD16	(0x40+16)	/* SET_BLOCKLEN */
 #define CMD17	(0x40+17)	/* READ_SINGLE_BLOCK */
+#define CMD18	(0x40+18)	/* READ_MULTIPLE_BLOCK */
 #define CMD24	(0x40+24)	/* WRITE_BLOCK */
 #define CMD55	(0x40+55)	/* APP_CMD */
 #define CMD58	(0x40+58)	/* READ_OCR */
@@ -198,3 +200,55 @@ DRESULT disk_readp (
 }
 
 
+
+/*-----------------------------------------------------------------------*/
+/* Read multiple sectors                                                 */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_readm (
+	BYTE *buff,		/* Pointer to the read buffer */
+	DWORD sector,	/* Start sector number (LBA) */
+	UINT count		/* Number of sectors to read (1..) */
+)
+{
+	BYTE d;
+	UINT bc, tmr;
+
+
+	if (!(CardType & CT_BLOCK)) sector *= 512;	/* Convert to byte address if needed */
+
+	if (send_cmd(CMD18, sector) == 0) {		/* READ_MULTIPLE_BLOCK */
+		do {
+			tmr = 1000;
+			do {						/* Wait for data packet in timeout of 100ms */
+				dly_us(100);
+				d = rcv_spi();
+			} while (d == 0xFF && --tmr);
+
+			if (d != 0xFE) break;		/* No data packet arrived */
+
+			/* Receive the sector */
+			bc = 512;
+			do {
+				*buff++ = rcv_spi();
+			} while (--bc);
+
+			/* Skip CRC */
+			rcv_spi(); rcv_spi();
+		} while (--count);
+
+		send_cmd(CMD12, 0);				/* STOP_TRANSMISSION */
+
+		tmr = 1000;
+		do {							/* Wait for the card to leave the busy state */
+			dly_us(100);
+			d = rcv_spi();
+		} while (d != 0xFF && --tmr);
+	}
+
+	deselect();
+
+	return count ? RES_ERROR : RES_OK;
+}
+
+
@@ -424,6 +424,40 @@ static int mem_cmp (const void* dst, const void* src, int cnt) {
 
 
 
+/*-----------------------------------------------------------------------*/
+/* FAT access - Read bytes of the FAT through the FAT window             */
+/*-----------------------------------------------------------------------*/
+
+static int read_fat (	/* 0:Succeeded, 1:IO error */
+	BYTE* buf,		/* Pointer to the read buffer */
+	DWORD bofs,		/* Byte offset in the FAT */
+	UINT cnt		/* Number of bytes to read */
+)
+{
+	DWORD sect;
+	UINT ofs;
+	FATFS *fs = FatFs;
+
+
+	do {
+		sect = fs->fatbase + bofs / 512;
+		ofs = (UINT)bofs % 512 & ~(PF_FAT_WIN - 1);
+		if (sect != fs->winsect || ofs != fs->winofs) {	/* Load the window if the byte is not in it */
+			fs->winsect = 0;
+			if (disk_readp(fs->win, sect, ofs, PF_FAT_WIN)) return 1;
+			fs->winsect = sect;
+			fs->winofs = (WORD)ofs;
+		}
+		*buf++ = fs->win[bofs % PF_FAT_WIN];
+		bofs++;
+	} while (--cnt);
+
+	return 0;
+}
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* FAT access - Read value of a FAT entry                                */
 /*-----------------------------------------------------------------------*/
@@ -435,34 +469,26 @@ static CLUST get_fat (	/* 1:IO error, Else:Cluster status */
 	BYTE buf[4];
 	FATFS *fs = FatFs;
 #if PF_FS_FAT12
-	UINT wc, bc, ofs;
+	UINT wc;
 #endif
 
 	if (clst < 2 || clst >= fs->n_fatent) return 1;	/* Range check */
 
 	switch (fs->fs_type) {
 #if PF_FS_FAT12
-	case FS_FAT12 : {
-		bc = (UINT)clst; bc += bc / 2;
-		ofs = bc % 512; bc /= 512;
-		if (ofs != 511) {
-			if (disk_readp(buf, fs->fatbase + bc, ofs, 2)) break;
-		} else {
-			if (disk_readp(buf, fs->fatbase + bc, 511, 1)) break;
-			if (disk_readp(buf+1, fs->fatbase + bc + 1, 0, 1)) break;
-		}
+	case FS_FAT12 :
+		if (read_fat(buf, clst + clst / 2, 2)) break;
 		wc = ld_word(buf);
 		return (clst & 1) ? (wc >> 4) : (wc & 0xFFF);
-	}
 #endif
 #if PF_FS_FAT16
 	case FS_FAT16 :
-		if (disk_readp(buf, fs->fatbase + clst / 256, ((UINT)clst % 256) * 2, 2)) break;
+		if (read_fat(buf, clst * 2, 2)) break;
 		return ld_word(buf);
 #endif
 #if PF_FS_FAT32
 	case FS_FAT32 :
-		if (disk_readp(buf, fs->fatbase + clst / 128, ((UINT)clst % 128) * 4, 4)) break;
+		if (read_fat(buf, clst * 4, 4)) break;
 		return ld_dword(buf) & 0x0FFFFFFF;
 #endif
 	}
@@ -878,6 +904,7 @@ FRESULT pf_mount (
 	fs->database = fs->fatbase + fsize + fs->n_rootdir / 16;	/* Data start sector (lba) */
 
 	fs->flag = 0;
+	fs->winsect = 0;
 	FatFs = fs;
 
 	return FR_OK;
@@ -934,6 +961,9 @@ FRESULT pf_read (
 	CLUST clst;
 	DWORD sect, remain;
 	UINT rcnt;
+#if PF_USE_READM
+	UINT scnt;
+#endif
 	BYTE cs, *rbuff = buff;
 	FATFS *fs = FatFs;
 
@@ -960,6 +990,25 @@ FRESULT pf_read (
 			sect = clust2sect(fs->curr_clust);		/* Get current sector */
 			if (!sect) ABORT(FR_DISK_ERR);
 			fs->dsect = sect + cs;
+#if PF_USE_READM
+			if (rbuff && btr >= 512) {				/* Read whole sectors straight into memory */
+				scnt = fs->csize - cs;				/* Sectors left in the current cluster */
+				while (scnt < btr / 512) {			/* Extend the run over contiguous clusters */
+					clst = get_fat(fs->curr_clust);
+					if (clst != fs->curr_clust + 1) break;
+					fs->curr_clust = clst;
+					scnt += fs->csize;
+				}
+				if (scnt > btr / 512) scnt = btr / 512;
+				dr = disk_readm(rbuff, fs->dsect, scnt);
+				if (dr) ABORT(FR_DISK_ERR);
+				rcnt = scnt * 512;
+				fs->fptr += rcnt;
+				btr -= rcnt; *br += rcnt;
+				rbuff += rcnt;
+				continue;
+			}
+#endif
 		}
 		rcnt = 512 - (UINT)fs->fptr % 512;			/* Get partial sector data from sector buffer */
 		if (rcnt > btr) rcnt = btr;
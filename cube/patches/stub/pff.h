@@ -73,6 +73,9 @@ typedef struct {
 	CLUST	org_clust;	/* File start cluster */
 	CLUST	curr_clust;	/* File current cluster */
 	DWORD	dsect;		/* File current data sector */
+	DWORD	winsect;	/* FAT window sector (0:Invalid) */
+	WORD	winofs;		/* FAT window offset in the sector */
+	BYTE	win[PF_FAT_WIN];	/* FAT window */
 } FATFS;
 
 
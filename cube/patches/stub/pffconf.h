@@ -13,6 +13,9 @@
 #define	PF_USE_DIR		0	/* pf_opendir() and pf_readdir() function */
 #define	PF_USE_LSEEK	1	/* pf_lseek() function */
 #define	PF_USE_WRITE	0	/* pf_write() function */
+#define	PF_USE_READM	1	/* Multiple sector reads in pf_read() (requires disk_readm()) */
+
+#define	PF_FAT_WIN		64	/* Size of the FAT read window in bytes (power of 2, 4..512) */
 
 #define PF_FS_FAT12		1	/* FAT12 */
 #define PF_FS_FAT16		1	/* FAT16 */
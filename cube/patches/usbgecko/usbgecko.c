@@ -61,7 +61,10 @@ static struct {
 		uint32_t length;
 		uint32_t offset;
 		frag_callback callback;
+		uint8_t sequence;
+		bool requested;
 	} queue[QUEUE_SIZE], *queued;
+	uint8_t sequence;
 } usb;
 
 static struct {
@@ -111,11 +114,59 @@ static bool usb_lock_file(void)
 
 static void usb_unlock_file(void)
 {
+	while (EXI[EXI_CHANNEL_1][3] & 0b000001);
+
+	// A transfer the interrupt handler hasn't seen yet has already taken its bytes off the FIFO.
+	if (_usb.requested && (EXI[EXI_CHANNEL_1][0] & 0b001000)) {
+		uint32_t val = EXI[EXI_CHANNEL_1][4];
+		if (val & 0x08000000)
+			_usb.requested--;
+		if ((EXI[EXI_CHANNEL_1][3] & 0b110000) == 0b110000 && (val & 0x800))
+			_usb.requested--;
+	}
+
 	usb_receive(OSPhysicalToCached(_usb.buffer), _usb.requested, _usb.requested);
 	_usb.requested = 0;
+
+	// Drain whatever was asked for ahead of time, in the order it was asked for
+	for (;;) {
+		int next = -1;
+
+		for (int i = 0; i < QUEUE_SIZE; i++) {
+			if (!usb.queue[i].requested || &usb.queue[i] == usb.queued)
+				continue;
+			if (next < 0 || (uint8_t)(usb.sequence - usb.queue[i].sequence) >
+				(uint8_t)(usb.sequence - usb.queue[next].sequence))
+				next = i;
+		}
+
+		if (next < 0)
+			break;
+
+		void *buffer = OSPhysicalToCached((intptr_t)usb.queue[next].buffer & ~OS_BASE_UNCACHED);
+		usb_receive(buffer, usb.queue[next].length, usb.queue[next].length);
+		usb.queue[next].requested = false;
+	}
+
+	if (usb.queued)
+		usb.queued->requested = false;
+
 	usb_request(0, 0);
 }
 
+// The host answers requests in order, so the rest of the queue can be asked
+// for now and its data will follow the current transfer without a round trip.
+static void usb_request_queued(void)
+{
+	for (int i = 0; i < QUEUE_SIZE; i++) {
+		if (usb.queue[i].callback != NULL && !usb.queue[i].requested) {
+			usb_request(usb.queue[i].offset, usb.queue[i].length);
+			usb.queue[i].sequence = usb.sequence++;
+			usb.queue[i].requested = true;
+		}
+	}
+}
+
 static void usb_read_queued(void)
 {
 	if (!EXILock(EXI_CHANNEL_1, EXI_DEVICE_0, (EXICallback)usb_read_queued))
@@ -127,11 +178,23 @@ static void usb_read_queued(void)
 
 	_usb.buffer = (intptr_t)buffer & ~OS_BASE_UNCACHED;
 	_usb.requested = length;
-	usb_request(offset, length);
 
+	if (!usb.queued->requested) {
+		usb_request(offset, length);
+		usb.queued->sequence = usb.sequence++;
+		usb.queued->requested = true;
+	}
+
+	usb_request_queued();
+
+	// The interrupt handler takes over from the first transfer, two bytes at a time
+	// for as long as at least two are left.
 	exi_select();
 	exi_clear_interrupts(false, true, false);
-	exi_imm_read_write(0xD << 28, 1, false);
+	if (length > 1)
+		exi_imm_read_write(0xA << 28 | 0xA << 12, 4, false);
+	else
+		exi_imm_read_write(0xA << 28, 2, false);
 
 	set_interrupt_handler(OS_INTERRUPT_EXI_1_TC, tc_interrupt_handler);
 	unmask_interrupts(OS_INTERRUPTMASK_EXI_1_TC);
@@ -141,15 +204,25 @@ static void usb_done_queued(void)
 {
 	void *buffer = usb.queued->buffer;
 	uint32_t length = usb.queued->length;
-	uint32_t offset = usb.queued->offset;
+	uint8_t sequence = usb.queued->sequence + 1;
 
 	usb.queued->callback(buffer, length);
 
 	EXIUnlock(EXI_CHANNEL_1);
 
 	usb.queued->callback = NULL;
+	usb.queued->requested = false;
 	usb.queued = NULL;
 
+	// Data for requests made ahead of time arrives in the order they were made
+	for (int i = 0; i < QUEUE_SIZE; i++) {
+		if (usb.queue[i].requested && usb.queue[i].sequence == sequence) {
+			usb.queued = &usb.queue[i];
+			usb_read_queued();
+			return;
+		}
+	}
+
 	for (int i = 0; i < QUEUE_SIZE; i++) {
 		if (usb.queue[i].callback != NULL) {
 			usb.queued = &usb.queue[i];
@@ -46,6 +46,8 @@ static uint32_t exi_imm_read_write(uint32_t data, uint32_t len, bool sync)
 		while (EXI[EXI_CHANNEL_1][3] & 0b01);
 		return EXI[EXI_CHANNEL_1][4] >> ((4 - len) * 8);
 	}
+
+	return 0;
 }
 
 static bool usb_probe(void)
@@ -59,15 +61,25 @@ static bool usb_probe(void)
 	return val == 0x470;
 }
 
-static bool usb_receive_byte(uint8_t *data)
+// Two receive commands can go out in one 4-byte transfer, each answered with
+// its own valid bit, so this returns how many of the bytes asked for arrived.
+static int usb_receive_bytes(uint8_t *data, int length)
 {
-	uint16_t val;
+	uint32_t val;
+	int i;
 
 	exi_select();
-	val = exi_imm_read_write(0xA << 28, 2, true); *data = val;
+	val = exi_imm_read_write(0xA << 28 | 0xA << 12, length * 2, true);
 	exi_deselect();
 
-	return !(val & 0x800);
+	for (i = 0; i < length; i++) {
+		uint16_t frame = val >> (length - 1 - i) * 16;
+		if (!(frame & 0x800))
+			break;
+		data[i] = frame;
+	}
+
+	return i;
 }
 
 static bool usb_transmit_byte(const uint8_t *data)
@@ -130,15 +142,23 @@ static int usb_receive(void *data, int size, int minsize)
 	bool check = true;
 
 	while (i < size) {
-		if ((check && usb_receive_check()) ||
-			(check = usb_receive_byte(data + i))) {
+		// Bytes are taken two at a time while both are within the 64 the FIFO last had ready.
+		int length = size - i > 1 && (i + 1) % 64 != j ? 2 : 1;
+		int count = 0;
+
+		if (!check || !usb_receive_check())
+			count = usb_receive_bytes(data + i, length);
+
+		i += count;
+
+		if (count < length) {
+			check = true;
 			j = i % 64;
 			if (i < minsize)
 				continue;
 			else break;
 		}
 
-		i++;
 		check = i % 64 == j;
 	}
 
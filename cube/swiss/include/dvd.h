@@ -32,13 +32,13 @@ struct pvd_s
 	char system_id[32];
 	char volume_id[32];
 	char zero[8];
-	unsigned long total_sector_le, total_sect_be;
+	u32 total_sector_le, total_sect_be;
 	char zero2[32];
-	unsigned long volume_set_size, volume_seq_nr;
+	u32 volume_set_size, volume_seq_nr;
 	unsigned short sector_size_le, sector_size_be;
-	unsigned long path_table_len_le, path_table_len_be;
-	unsigned long path_table_le, path_table_2nd_le;
-	unsigned long path_table_be, path_table_2nd_be;
+	u32 path_table_len_le, path_table_len_be;
+	u32 path_table_le, path_table_2nd_le;
+	u32 path_table_be, path_table_2nd_be;
 	unsigned char root_direntry[34];
 	char volume_set_id[128], publisher_id[128], data_preparer_id[128], application_id[128];
 	char copyright_file_id[37], abstract_file_id[37], bibliographical_file_id[37];
@@ -58,6 +58,7 @@ extern void load_dol_fn_inmem(void* dol, int size);
 int DVD_ReadID(dvddiskid *diskID);
 s32 DVD_Read(void* dst, uint64_t offset, u32 len);
 int read_sector(void* buffer, int numSectors, u32 sector);
+void dvd_clear_dircache();
 int DVD_LowRead64(void* dst, unsigned int len, u64 offset);
 void dvd_set_offset(u64 offset);
 void xeno_disable();
@@ -6,11 +6,11 @@
 #include <stdint.h>
 #include "deviceHandler.h"
 
-file_handle** sortFiles(file_handle* dir, int num_files);
+file_handle** sortFiles(file_handle** dir, int num_files);
 void freeFiles();
 void scanFiles();
 file_handle** getSortedDirEntries();
-file_handle* getCurrentDirEntries();
+dir_list* getCurrentDirEntries();
 #define getSortedDirEntryCount getCurrentDirEntryCount
 int getCurrentDirEntryCount();
 size_t concat_path(char *pathName, const char *dirName, const char *baseName);
@@ -0,0 +1,18 @@
+#ifndef FILESORT_H
+#define FILESORT_H
+#include <gctypes.h>
+
+// Sort key built once per entry so that sorting doesn't touch the file handles.
+typedef struct {
+	u64 key[2];			// case-folded name, encoded to order as naturalCompare does
+	const char *name;	// name past the common directory
+	u32 index;			// position in the directory
+	u16 rest;			// offset in the name that the key leaves off at
+	u8 class;			// disc first, then by descending attribute
+} file_sort_key;
+
+int naturalCompare(const char *a, const char *b);
+void makeSortKey(file_sort_key *key, const char *name, u8 class, u32 index);
+void sortKeys(file_sort_key *keys, file_sort_key *temp, int count);
+
+#endif
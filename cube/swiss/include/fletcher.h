@@ -0,0 +1,29 @@
+/* 
+ * Copyright (c) 2020-2023, Extrems <extrems@extremscorner.org>
+ * 
+ * This file is part of Swiss.
+ * 
+ * Swiss is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * Swiss is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * with Swiss.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __FLETCHER_H__
+#define __FLETCHER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+uint8_t fletcher8(const void *buffer, size_t size);
+uint16_t fletcher16(const void *buffer, size_t size);
+
+#endif /* __FLETCHER_H__ */
@@ -23,11 +23,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <sys/types.h>
+#include "fletcher.h"
 #include "gcm.h"
 
-uint8_t fletcher8(const void *buffer, size_t size);
-uint16_t fletcher16(const void *buffer, size_t size);
-
 bool is_datel_disc(const DiskHeader *header);
 bool is_diag_disc(const DiskHeader *header);
 bool is_multi_disc(const file_meta *meta);
@@ -13,11 +13,13 @@
 #include <malloc.h>
 #include <network.h>
 #include <ogc/lwp_threads.h>
+#include <ogc/machine/processor.h>
 #include <gctypes.h>
 
 #include "sidestep.h"
 #include "ssaram.h"
 #include "elf.h"
+#include "devices/deviceHandler.h"
 #include "gui/FrameBufferMagic.h"
 #include "patcher.h"
 
@@ -180,6 +182,37 @@ void ARAMRun(u32 entrypoint, u32 dst, u32 src, u32 len)
 	__lwp_thread_stopmultitasking(ARAMRunStub);
 }
 
+/****************************************************************************
+* ARAMRunArgs
+*
+* Passes a command line after the last section, then runs everything
+* between minaddress and maxaddress
+****************************************************************************/
+static int ARAMRunArgs(u32 entrypoint, char *argz, size_t argz_len)
+{
+  u32 sizeinbytes = maxaddress - minaddress;
+  struct __argv args;
+
+  if (argz)
+  {
+    args.argvMagic = ARGV_MAGIC;
+    args.commandLine = argz;
+    args.length = argz_len;
+
+    ARAMPut((unsigned char *) args.commandLine, (char *) ((maxaddress - minaddress) + ARAMSTART), args.length);
+
+    args.commandLine = (char *) maxaddress;
+    sizeinbytes += args.length;
+
+    ARAMPut((unsigned char *) &args, (char *) ((entrypoint + 8 - minaddress) + ARAMSTART), sizeof(struct __argv));
+  }
+
+  ARAMRun(entrypoint, minaddress, ARAMSTART, sizeinbytes);
+
+  /*** Will never return ***/
+  return 1;
+}
+
 /*--- DOL Decoding functions -----------------------------------------------*/
 /****************************************************************************
 * DOLMinMax
@@ -268,9 +301,7 @@ u32 DOLSize(DOLHEADER *dol)
 int DOLtoARAM(unsigned char *dol, char *argz, size_t argz_len)
 {
   DOLHEADER *dolhdr;
-  u32 sizeinbytes;
   int i;
-  struct __argv args;
 
   /*** Make sure ARAM subsystem is alive! ***/
   AR_Reset();
@@ -286,7 +317,6 @@ int DOLtoARAM(unsigned char *dol, char *argz, size_t argz_len)
 
   /*** Get DOL stats ***/
   DOLMinMax(dolhdr);
-  sizeinbytes = maxaddress - minaddress;
 
   /*** Move all DOL sections into ARAM ***/
   /*** Move text sections ***/
@@ -322,26 +352,8 @@ int DOLtoARAM(unsigned char *dol, char *argz, size_t argz_len)
     }
   }
 
-  /*** Pass a command line ***/
-  if (argz)
-  {
-    args.argvMagic = ARGV_MAGIC;
-    args.commandLine = argz;
-    args.length = argz_len;
-
-    ARAMPut((unsigned char *) args.commandLine, (char *) ((maxaddress - minaddress) + ARAMSTART), args.length);
-
-    args.commandLine = (char *) maxaddress;
-    sizeinbytes += args.length;
-
-    ARAMPut((unsigned char *) &args, (char *) ((dolhdr->entryPoint + 8 - minaddress) + ARAMSTART), sizeof(struct __argv));
-  }
-
   /*** Now go run it ***/
-  ARAMRun(dolhdr->entryPoint, minaddress, ARAMSTART, sizeinbytes);
-
-  /*** Will never return ***/
-  return 1;
+  return ARAMRunArgs(dolhdr->entryPoint, argz, argz_len);
 }
 
 static void ELFMinMax(Elf32_Ehdr *ehdr, Elf32_Phdr *phdr)
@@ -368,9 +380,7 @@ int ELFtoARAM(unsigned char *elf, char *argz, size_t argz_len)
 {
   Elf32_Ehdr *ehdr;
   Elf32_Phdr *phdr;
-  u32 sizeinbytes;
   int i;
-  struct __argv args;
 
   /*** Make sure ARAM subsystem is alive! ***/
   AR_Reset();
@@ -387,7 +397,6 @@ int ELFtoARAM(unsigned char *elf, char *argz, size_t argz_len)
 
   /*** Get ELF stats ***/
   ELFMinMax(ehdr, phdr);
-  sizeinbytes = maxaddress - minaddress;
 
   /*** Move all ELF segments into ARAM ***/
   for (i = 0; i < ehdr->e_phnum; i++)
@@ -410,26 +419,8 @@ int ELFtoARAM(unsigned char *elf, char *argz, size_t argz_len)
     }
   }
 
-  /*** Pass a command line ***/
-  if (argz)
-  {
-    args.argvMagic = ARGV_MAGIC;
-    args.commandLine = argz;
-    args.length = argz_len;
-
-    ARAMPut((unsigned char *) args.commandLine, (char *) ((maxaddress - minaddress) + ARAMSTART), args.length);
-
-    args.commandLine = (char *) maxaddress;
-    sizeinbytes += args.length;
-
-    ARAMPut((unsigned char *) &args, (char *) ((ehdr->e_entry + 8 - minaddress) + ARAMSTART), sizeof(struct __argv));
-  }
-
   /*** Now go run it ***/
-  ARAMRun(ehdr->e_entry, minaddress, ARAMSTART, sizeinbytes);
-
-  /*** Will never return ***/
-  return 1;
+  return ARAMRunArgs(ehdr->e_entry, argz, argz_len);
 }
 
 int BINtoARAM(unsigned char *bin, size_t len, unsigned int entrypoint, unsigned int minaddress)
@@ -448,3 +439,122 @@ int BINtoARAM(unsigned char *bin, size_t len, unsigned int entrypoint, unsigned
   /*** Will never return ***/
   return 1;
 }
+
+/*--- Streamed loading -----------------------------------------------------*/
+static volatile bool staging = false;
+
+/****************************************************************************
+* ARAMStageClaim
+*
+* Staging resets ARAM and overwrites it as the image arrives. It may not
+* start while the ARAM or System device is mounted, and they refuse to
+* mount until ARAMStageRelease
+****************************************************************************/
+int ARAMStageClaim(void)
+{
+  u32 level;
+
+  _CPU_ISR_Disable(level);
+  if (devices[DEVICE_CUR] == &__device_aram || devices[DEVICE_CUR] == &__device_sys ||
+      devices[DEVICE_DEST] == &__device_aram || devices[DEVICE_DEST] == &__device_sys)
+  {
+    _CPU_ISR_Restore(level);
+    return 0;
+  }
+  staging = true;
+  _CPU_ISR_Restore(level);
+  return 1;
+}
+
+void ARAMStageRelease(void)
+{
+  staging = false;
+}
+
+int ARAMStageActive(void)
+{
+  return staging;
+}
+
+/****************************************************************************
+* ARAMStageInit
+*
+* Readies ARAM to receive sections as they arrive, for loaders that never
+* hold the whole image in main memory. Only internal ARAM is used, so the
+* ARAM device's filesystem in the expansion survives a failed transfer.
+****************************************************************************/
+static int ARAMStageInit(u32 len)
+{
+  if (!staging)
+    return 0;
+
+  AR_Reset();
+  AR_Init(NULL, 0); /*** No stack - we need it all ***/
+  AR_Clear(AR_ARAMINTALL);
+
+  return ARAMSTART + len <= AR_GetInternalSize();
+}
+
+int DOLStageBegin(DOLHEADER *dolhdr)
+{
+  /*** First, does this look like a DOL? ***/
+  if (dolhdr->textOffset[0] != DOLHDRLENGTH && dolhdr->textOffset[0] != 0x0620)	// DOLX style 
+    return 0;
+
+  DOLMinMax(dolhdr);
+  return maxaddress > minaddress && ARAMStageInit(maxaddress - minaddress);
+}
+
+int ELFStageBegin(Elf32_Ehdr *ehdr, Elf32_Phdr *phdr)
+{
+  ELFMinMax(ehdr, phdr);
+  return maxaddress > minaddress && ARAMStageInit(maxaddress - minaddress);
+}
+
+int BINStageBegin(size_t len)
+{
+  minaddress = 0;
+  maxaddress = len;
+  return ARAMStageInit(len);
+}
+
+/****************************************************************************
+* ARAMStage
+*
+* Places part of a section at its final position relative to minaddress.
+* Raw binaries are staged by file offset instead.
+****************************************************************************/
+void ARAMStage(unsigned char *src, u32 address, int len)
+{
+  if (address < minaddress || address + len > maxaddress)
+    return;
+
+  ARAMPut(src, (char *) ((address - minaddress) + ARAMSTART), len);
+}
+
+int ARAMStageRun(u32 entrypoint, char *argz, size_t argz_len)
+{
+  static u32 entry[8] ATTRIBUTE_ALIGN(32);
+  u32 offset = entrypoint + 4 - minaddress;
+
+  if (entrypoint < minaddress || entrypoint + 8 > maxaddress)
+    return 0;
+
+  /*** The entry point has already been staged, check it for argv support ***/
+  ARAMFetch((unsigned char *) entry, (char *) ((offset & ~0x1f) + ARAMSTART), 32);
+  if (entry[(offset & 0x1f) >> 2] != ARGV_MAGIC)
+  {
+    argz = NULL;
+    argz_len = 0;
+  }
+
+  return ARAMRunArgs(entrypoint, argz, argz_len);
+}
+
+int BINStageRun(unsigned int entrypoint, unsigned int minaddress)
+{
+  ARAMRun(entrypoint, minaddress, ARAMSTART, maxaddress);
+
+  /*** Will never return ***/
+  return 1;
+}
@@ -10,6 +10,8 @@
 #ifndef __SIDESTEP__
 #define __SIDESTEP__
 
+#include "elf.h"
+
 /*** A standard DOL header ***/
 #define DOLHDRLENGTH 256	/*** All DOLS must have a 256 byte header ***/
 #define MAXTEXTSECTION 7
@@ -38,5 +40,15 @@ int DOLtoARAM(unsigned char *dol, char *argz, size_t argz_len);
 int ELFtoARAM(unsigned char *elf, char *argz, size_t argz_len);
 int BINtoARAM(unsigned char *bin, size_t len, unsigned int entrypoint, unsigned int minaddress);
 
+int DOLStageBegin(DOLHEADER *dolhdr);
+int ELFStageBegin(Elf32_Ehdr *ehdr, Elf32_Phdr *phdr);
+int ARAMStageClaim(void);
+void ARAMStageRelease(void);
+int ARAMStageActive(void);
+int BINStageBegin(size_t len);
+void ARAMStage(unsigned char *src, u32 address, int len);
+int ARAMStageRun(u32 entrypoint, char *argz, size_t argz_len);
+int BINStageRun(unsigned int entrypoint, unsigned int minaddress);
+
 #endif
 #endif
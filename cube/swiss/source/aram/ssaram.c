@@ -32,6 +32,9 @@ void ARAMPut(unsigned char *src, char *dst, int len)
   int i, block;
   int offset = 0;
 
+  if (len <= 0)
+    return;
+
   /*** Check destination alignment ***/
   if ((u32) dst & 0x1f)
   {
@@ -39,6 +42,11 @@ void ARAMPut(unsigned char *src, char *dst, int len)
     misalignaddress = ((u32) dst & ~0x1f);
     misalignedbytestodo = 32 - ((u32) dst & 0x1f);
     misalignedbytes = ((u32) dst & 0x1f);
+
+    /*** The whole piece may fit within this section ***/
+    if (misalignedbytestodo > len)
+      misalignedbytestodo = len;
+
     ARAMFetch(aramfix, (char *) misalignaddress, 32);
 
     /*** Update from source ***/
@@ -53,6 +61,9 @@ void ARAMPut(unsigned char *src, char *dst, int len)
     src += misalignedbytestodo;
     len -= misalignedbytestodo;
     dst = (char *) (((u32) dst & ~0x1f) + 32);
+
+    if (!len)
+      return;
   }
 
   /*** Move 2k blocks - saves aligning source buffer ***/
@@ -71,10 +82,13 @@ void ARAMPut(unsigned char *src, char *dst, int len)
   if (len)
   {
     block = len & 0x1f;		/*** Is length aligned ? ***/
-    memcpy(aramfix, src + offset, len & ~0x1f);
-    DCFlushRange(aramfix, len & ~0x1f);
-    AR_StartDMA(ARAM_WRITE, (u32) aramfix, (u32) dst + offset, len & ~0x1f);
-    while (AR_GetDMAStatus());
+    if (len & ~0x1f)
+    {
+      memcpy(aramfix, src + offset, len & ~0x1f);
+      DCFlushRange(aramfix, len & ~0x1f);
+      AR_StartDMA(ARAM_WRITE, (u32) aramfix, (u32) dst + offset, len & ~0x1f);
+      while (AR_GetDMAStatus());
+    }
 
     if (block)
     {
@@ -16,6 +16,7 @@
 #include <errno.h>
 #include <malloc.h>
 #include <ctype.h>
+#include <limits.h>
 #include "swiss.h"
 #include "main.h"
 #include "cheats.h"
@@ -61,15 +62,57 @@ int getEnabledCheatsCount(void) {
 	return enabled;
 }
 
-// Checks that the line contains a valid code in the format of "01234567 89ABCDEF"
-int isValidCode(char *line) {
-	int len = 0;
-	return sscanf(line, "%*8[0-9A-Fa-f] %*8[0-9A-Fa-f]%n", &len) == 0 && len > 16;
+enum {
+	LINE_TEXT = 0,
+	LINE_CODE,
+	LINE_UNSUPPORTED
+};
+
+// Counts up to max leading characters accepted by class, like a scanf %[ conversion
+static inline int spanClass(const char *s, int max, int (*class)(int)) {
+	int n = 0;
+	while(n < max && class((unsigned char)s[n])) n++;
+	return n;
+}
+
+static int spanSpace(const char *s) {
+	int n = 0;
+	while(isspace((unsigned char)s[n])) n++;
+	return n;
+}
+
+// Saturates past 8 significant digits, as strtoul does for sscanf's %x
+static u32 parseHex(const char *s, int len) {
+	u32 value = 0;
+	for(int i = 0; i < len; i++) {
+		int c = (unsigned char)s[i];
+		if(value >> 28) return 0xFFFFFFFF;
+		value = (value << 4) | (c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+	}
+	return value;
 }
 
-int isCheatCode(char *line) {
-	int len = 0;
-	return sscanf(line, "%*2[0-9A-Fa-f]%*6[0-9A-Za-z] %*8[0-9A-Za-z]%n", &len) == 0 && len > 16;
+// Classifies a line in one pass. It looks like a code if it matches
+// "%*2[0-9A-Fa-f]%*6[0-9A-Za-z] %*8[0-9A-Za-z]" for more than 16 characters,
+// and the code is usable if it also matches "%*8[0-9A-Fa-f] %*8[0-9A-Fa-f]"
+// the same way, e.g. "01234567 89ABCDEF" but not "0123XXXX 89ABCDEF".
+static int classifyLine(const char *line, u32 code[2]) {
+	int hex = spanClass(line, 2, isxdigit);
+	if(!hex) return LINE_TEXT;
+	int len = hex + spanClass(line + hex, 6, isalnum);
+	if(len == hex) return LINE_TEXT;
+	len += spanSpace(line + len);
+	int value = spanClass(line + len, 8, isalnum);
+	if(!value || len + value <= 16) return LINE_TEXT;
+
+	int addressLen = spanClass(line, 8, isxdigit);
+	len = addressLen + spanSpace(line + addressLen);
+	value = spanClass(line + len, 8, isxdigit);
+	if(!value || len + value <= 16) return LINE_UNSUPPORTED;
+
+	code[0] = parseHex(line, addressLen);
+	code[1] = parseHex(line + len, value + spanClass(line + len + value, INT_MAX, isxdigit));
+	return LINE_CODE;
 }
 
 /** 
@@ -78,7 +121,8 @@ int isCheatCode(char *line) {
 */
 void parseCheats(char *filecontents) {
 	char *line = NULL, *prevLine = NULL, *linectx = NULL;
-	int numCheats = 0;
+	int numCheats = 0, maxCheats = 0;
+	u32 code[2];
 	line = strtok_r( filecontents, "\r\n", &linectx );
 
 	// Free previous
@@ -97,8 +141,12 @@ void parseCheats(char *filecontents) {
 	CheatEntry *curCheat = NULL;	// The current one we're parsing
 	while( line != NULL ) {
 		//print_gecko("Line [%s]\r\n", line);
-		if(isCheatCode(line)) {		// The line looks like a valid code
-			_cheats.cheat = reallocarray(_cheats.cheat, numCheats+1, sizeof(CheatEntry));
+		int type = classifyLine(line, code);
+		if(type != LINE_TEXT) {		// The line looks like a valid code
+			if(numCheats == maxCheats) {
+				maxCheats = maxCheats ? maxCheats * 2 : 64;
+				_cheats.cheat = reallocarray(_cheats.cheat, maxCheats, sizeof(CheatEntry));
+			}
 			curCheat = &_cheats.cheat[numCheats];
 			memset(curCheat, 0, sizeof(CheatEntry));
 			
@@ -106,39 +154,27 @@ void parseCheats(char *filecontents) {
 				curCheat->name = strdup(prevLine);
 				//print_gecko("Cheat Name: [%s]\r\n", prevLine);
 			}
-			int numCodes = 0, unsupported = 0;
-			if(isValidCode(line)) {
-				// Add this valid code as the first code for this cheat
-				curCheat->codes = reallocarray(curCheat->codes, numCodes+1, sizeof(*curCheat->codes));
-				sscanf(line, "%x %x", &curCheat->codes[numCodes][0], &curCheat->codes[numCodes][1]);
-				numCodes++;
-			}
-			else {
-				// If a code contains "XX" in it, it is unsupported, discard it entirely
-				unsupported = 1;
-				numCodes++;
-			}
-			
-			line = strtok_r( NULL, "\r\n", &linectx);
+			int numCodes = 0, maxCodes = 0, unsupported = 0;
 			// Keep going until we're out of codes for this cheat
-			while( line != NULL ) {
-				if(isCheatCode(line)) {
-					if(isValidCode(line)) {
-						// Add this valid code
-						curCheat->codes = reallocarray(curCheat->codes, numCodes+1, sizeof(*curCheat->codes));
-						sscanf(line, "%x %x", &curCheat->codes[numCodes][0], &curCheat->codes[numCodes][1]);
-						numCodes++;
-					}
-					else {
-						// If a code contains "XX" in it, it is unsupported, discard it entirely
-						unsupported = 1;
-						numCodes++;
-					}
+			while(type != LINE_TEXT) {
+				if(type == LINE_UNSUPPORTED) {
+					// If a code contains "XX" in it, it is unsupported, discard it entirely
+					unsupported = 1;
 				}
-				else {
-					break;
+				else if(!unsupported) {
+					// Add this valid code
+					if(numCodes == maxCodes) {
+						maxCodes = maxCodes ? maxCodes * 2 : 8;
+						curCheat->codes = reallocarray(curCheat->codes, maxCodes, sizeof(*curCheat->codes));
+					}
+					curCheat->codes[numCodes][0] = code[0];
+					curCheat->codes[numCodes][1] = code[1];
 				}
+				numCodes++;
+				
 				line = strtok_r( NULL, "\r\n", &linectx);
+				if(line == NULL) break;
+				type = classifyLine(line, code);
 			}
 			
 			if(unsupported) {
@@ -152,7 +188,9 @@ void parseCheats(char *filecontents) {
 		}
 		prevLine = line;
 		// And round we go again
-		line = strtok_r( NULL, "\r\n", &linectx);
+		if(line != NULL) {
+			line = strtok_r( NULL, "\r\n", &linectx);
+		}
 	}
 	_cheats.num_cheats = numCheats;
 	//printCheats();
@@ -302,12 +340,14 @@ int findCheats(bool silent) {
 }
 
 int applyAllCheats() {
-	int i = 0, j = 0;
+	int i = 0, j = 0, size = 0, maxSize = kenobi_get_maxsize();
 	for(i = 0; i < _cheats.num_cheats; i++) {
 		CheatEntry *cheat = &_cheats.cheat[i];
 		cheat->enabled = 1;
-		if(getEnabledCheatsSize() > kenobi_get_maxsize())
+		if(size + ((cheat->num_codes*2)*4) > maxSize)
 			cheat->enabled = 0;
+		else
+			size += ((cheat->num_codes*2)*4);
 		j++;
 	}
 	return j;
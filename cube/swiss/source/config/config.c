@@ -251,9 +251,7 @@ int config_update_recent(bool checkConfigDevice) {
 }
 
 
-int config_update_game(ConfigEntry* entry, bool checkConfigDevice) {
-	if(checkConfigDevice && !config_set_device()) return 0;
-
+static int config_write_game(ConfigEntry* entry) {
 	char *configString = NULL;
 	size_t len = 0;
 	FILE *fp = open_memstream(&configString, &len);
@@ -282,13 +280,20 @@ int config_update_game(ConfigEntry* entry, bool checkConfigDevice) {
 	fprintf(fp, "Prefer Clean Boot=%s\r\n", entry->preferCleanBoot ? "Yes":"No");
 	fclose(fp);
 
+	concatf_path(txtbuffer, SWISS_GAME_SETTINGS_DIR, "%.4s.ini", entry->game_id);
+	int res = config_file_write(txtbuffer, configString);
+	free(configString);
+	return res;
+}
+
+int config_update_game(ConfigEntry* entry, bool checkConfigDevice) {
+	if(checkConfigDevice && !config_set_device()) return 0;
+
 	ensure_path(DEVICE_CONFIG, SWISS_BASE_DIR, NULL);
 	ensure_path(DEVICE_CONFIG, SWISS_SETTINGS_DIR, NULL);
 	ensure_path(DEVICE_CONFIG, SWISS_GAME_SETTINGS_DIR, NULL);
 	
-	concatf_path(txtbuffer, SWISS_GAME_SETTINGS_DIR, "%.4s.ini", entry->game_id);
-	int res = config_file_write(txtbuffer, configString);
-	free(configString);
+	int res = config_write_game(entry);
 	if(checkConfigDevice) {
 		config_unset_device();
 	}
@@ -597,11 +602,14 @@ void config_parse_legacy(char *configData, void (*progress_indicator)(char*, int
 	
 	 print_gecko("Found %i entries in the (legacy) config file\r\n",configEntriesCount);
 	 
-	 // Write out to individual files.
-	 int i;
+	 // Write out to individual files, config_init has already made the directories.
+	 int i, percent = -1;
 	 for(i = 0; i < configEntriesCount; i++) {
-		 progress_indicator("Migrating settings to new format.", 1, (int)(((float)i / (float)configEntriesCount) * 100));
-		 config_update_game(&configEntries[i], false);
+		 if(percent != i * 100 / configEntriesCount) {
+			 percent = i * 100 / configEntriesCount;
+			 progress_indicator("Migrating settings to new format.", 1, percent);
+		 }
+		 config_write_game(&configEntries[i]);
 	 }
 	 // Write out a new swiss.ini
 	 config_update_global(false);
@@ -916,154 +924,180 @@ void config_parse_args(int argc, char *argv[]) {
 	}
 }
 
-void config_parse_recent(char *configData) {
-	char *line, *linectx = NULL;
-	line = strtok_r( configData, "\r\n", &linectx );
-	while( line != NULL ) {
-		//print_gecko("Line [%s]\r\n", line);
+// Splits off the next "name=value" line, skipping blank lines and comments.
+// A line without a '=' has no value, callers skip it.
+static bool config_next_entry(char **ctx, char **name, char **value) {
+	char *line = *ctx;
+	while(1) {
+		line += strspn(line, "\r\n");
+		if(*line == '\0') {
+			*ctx = line;
+			return false;
+		}
+		char *end = line + strcspn(line, "\r\n");
+		*ctx = *end ? end + 1 : end;
+		*end = '\0';
 		if(line[0] != '#') {
-			char *name, *value = NULL;
-			name = strtok_r(line, "=", &value);
-			
-			if(value != NULL) {
-				//print_gecko("Name [%s] Value [%s]\r\n", name, value);
-				if(!strncmp("Recent_", name, strlen("Recent_"))) {
-					int recent_slot = atoi(name+strlen("Recent_"));
-					if(recent_slot >= 0 && recent_slot < RECENT_MAX) {
-						//print_gecko("found recent num %i [%s]\r\n", recent_slot, value);
-						strlcpy(swissSettings.recent[recent_slot], value, PATHNAME_MAX);
-					}
-				}
+			line += strspn(line, "=");
+			if(*line != '\0') break;
+		}
+		line = *ctx;
+	}
+	*name = line;
+	*value = line + strcspn(line, "=");
+	if(**value == '=') *(*value)++ = '\0';
+	else *value = NULL;
+	return true;
+}
+
+enum {
+	GAME_KEY_NONE = 0,
+	GAME_KEY_NAME,
+	GAME_KEY_COMMENT,
+	GAME_KEY_STATUS,
+	GAME_KEY_VIDEO_MODE,
+	GAME_KEY_HSCALE,
+	GAME_KEY_VOFFSET,
+	GAME_KEY_VFILTER,
+	GAME_KEY_VJITTER,
+	GAME_KEY_DITHERING,
+	GAME_KEY_ANISOTROPY,
+	GAME_KEY_WIDESCREEN,
+	GAME_KEY_POLL_RATE,
+	GAME_KEY_INVERT_CSTICK,
+	GAME_KEY_SWAP_CSTICK,
+	GAME_KEY_TRIGGER_LEVEL,
+	GAME_KEY_AUDIO_STREAM,
+	GAME_KEY_READ_SPEED,
+	GAME_KEY_ETHERNET,
+	GAME_KEY_CLEAN_BOOT,
+};
+
+// Game setting names, placed by a hash that has no collisions among them.
+// Adding a name means finding new multipliers that keep it that way.
+#define GAME_KEY_HASH(name, len) (((len) * 16 + (name)[(len) - 1] + (name)[(len) / 2] * 5) & 31)
+
+static const struct {
+	const char *name;
+	int key;
+} gameKeys[32] = {
+	[ 0] = {"Prefer Clean Boot", GAME_KEY_CLEAN_BOOT},
+	[ 1] = {"Force Polling Rate", GAME_KEY_POLL_RATE},
+	[ 2] = {"Force Widescreen", GAME_KEY_WIDESCREEN},
+	[ 4] = {"Emulate Audio Streaming", GAME_KEY_AUDIO_STREAM},
+	[ 5] = {"Comment", GAME_KEY_COMMENT},
+	[ 6] = {"Name", GAME_KEY_NAME},
+	[ 9] = {"Digital Trigger Level", GAME_KEY_TRIGGER_LEVEL},
+	[11] = {"Force Field Rendering", GAME_KEY_VJITTER},
+	[12] = {"Force Anisotropic Filter", GAME_KEY_ANISOTROPY},
+	[15] = {"Force Vertical Filter", GAME_KEY_VFILTER},
+	[16] = {"Force Horizontal Scale", GAME_KEY_HSCALE},
+	[17] = {"Force Vertical Offset", GAME_KEY_VOFFSET},
+	[20] = {"Swap Camera Stick", GAME_KEY_SWAP_CSTICK},
+	[22] = {"Emulate Broadband Adapter", GAME_KEY_ETHERNET},
+	[23] = {"Status", GAME_KEY_STATUS},
+	[25] = {"Force Video Mode", GAME_KEY_VIDEO_MODE},
+	[28] = {"Invert Camera Stick", GAME_KEY_INVERT_CSTICK},
+	[29] = {"Emulate Read Speed", GAME_KEY_READ_SPEED},
+	[31] = {"Disable Alpha Dithering", GAME_KEY_DITHERING},
+};
+
+static int config_game_key(const char *name) {
+	size_t len = strlen(name);
+	if(len == 0) return GAME_KEY_NONE;
+	int i = GAME_KEY_HASH(name, len);
+	return gameKeys[i].name && !strcmp(gameKeys[i].name, name) ? gameKeys[i].key : GAME_KEY_NONE;
+}
+
+// Matches value against a list of option names, leaving option untouched if none match
+static void config_match_option(const char *value, char **options, int count, int *option) {
+	for(int i = 0; i < count; i++) {
+		if(!strcmp(options[i], value)) {
+			*option = i;
+			break;
+		}
+	}
+}
+
+void config_parse_recent(char *configData) {
+	char *name, *value, *ctx = configData;
+	while(config_next_entry(&ctx, &name, &value)) {
+		if(value == NULL) continue;
+		//print_gecko("Name [%s] Value [%s]\r\n", name, value);
+		if(!strncmp("Recent_", name, strlen("Recent_"))) {
+			int recent_slot = atoi(name+strlen("Recent_"));
+			if(recent_slot >= 0 && recent_slot < RECENT_MAX) {
+				//print_gecko("found recent num %i [%s]\r\n", recent_slot, value);
+				strlcpy(swissSettings.recent[recent_slot], value, PATHNAME_MAX);
 			}
 		}
-		// And round we go again
-		line = strtok_r( NULL, "\r\n", &linectx);
 	}
 }
 
 void config_parse_game(char *configData, ConfigEntry *entry) {
-	// Parse each entry and put it into our array
-	char *line, *linectx = NULL;
-	line = strtok_r( configData, "\r\n", &linectx );
-	while( line != NULL ) {
-		//print_gecko("Line [%s]\r\n", line);
-		if(line[0] != '#') {
-			char *name, *value = NULL;
-			name = strtok_r(line, "=", &value);
-			
-			if(value != NULL) {
-				//print_gecko("Name [%s] Value [%s]\r\n", name, value);
-				if(!strcmp("Name", name)) {
-					strncpy(entry->game_name, value, 64);
-				}
-				else if(!strcmp("Comment", name)) {
-					strncpy(entry->comment, value, 128);
-				}
-				else if(!strcmp("Status", name)) {
-					strncpy(entry->status, value, 32);
-				}
-				else if(!strcmp("Force Video Mode", name)) {
-					for(int i = 0; i < 15; i++) {
-						if(!strcmp(gameVModeStr[i], value)) {
-							entry->gameVMode = i;
-							break;
-						}
-					}
-				}
-				else if(!strcmp("Force Horizontal Scale", name)) {
-					for(int i = 0; i < 9; i++) {
-						if(!strcmp(forceHScaleStr[i], value)) {
-							entry->forceHScale = i;
-							break;
-						}
-					}
-				}
-				else if(!strcmp("Force Vertical Offset", name)) {
-					entry->forceVOffset = atoi(value);
-				}
-				else if(!strcmp("Force Vertical Filter", name)) {
-					for(int i = 0; i < 4; i++) {
-						if(!strcmp(forceVFilterStr[i], value)) {
-							entry->forceVFilter = i;
-							break;
-						}
-					}
-				}
-				else if(!strcmp("Force Field Rendering", name)) {
-					for(int i = 0; i < 3; i++) {
-						if(!strcmp(forceVJitterStr[i], value)) {
-							entry->forceVJitter = i;
-							break;
-						}
-					}
-				}
-				else if(!strcmp("Disable Alpha Dithering", name)) {
-					entry->disableDithering = !strcmp("Yes", value);
-				}
-				else if(!strcmp("Force Anisotropic Filter", name)) {
-					entry->forceAnisotropy = !strcmp("Yes", value);
-				}
-				else if(!strcmp("Force Widescreen", name)) {
-					for(int i = 0; i < 3; i++) {
-						if(!strcmp(forceWidescreenStr[i], value)) {
-							entry->forceWidescreen = i;
-							break;
-						}
-					}
-				}
-				else if(!strcmp("Force Polling Rate", name)) {
-					for(int i = 0; i < 13; i++) {
-						if(!strcmp(forcePollRateStr[i], value)) {
-							entry->forcePollRate = i;
-							break;
-						}
-					}
-				}
-				else if(!strcmp("Invert Camera Stick", name)) {
-					for(int i = 0; i < 4; i++) {
-						if(!strcmp(invertCStickStr[i], value)) {
-							entry->invertCStick = i;
-							break;
-						}
-					}
-				}
-				else if(!strcmp("Swap Camera Stick", name)) {
-					for(int i = 0; i < 4; i++) {
-						if(!strcmp(swapCStickStr[i], value)) {
-							entry->swapCStick = i;
-							break;
-						}
-					}
-				}
-				else if(!strcmp("Digital Trigger Level", name)) {
-					entry->triggerLevel = atoi(value);
-				}
-				else if(!strcmp("Emulate Audio Streaming", name)) {
-					for(int i = 0; i < 3; i++) {
-						if(!strcmp(emulateAudioStreamStr[i], value)) {
-							entry->emulateAudioStream = i;
-							break;
-						}
-					}
-				}
-				else if(!strcmp("Emulate Read Speed", name)) {
-					for(int i = 0; i < 3; i++) {
-						if(!strcmp(emulateReadSpeedStr[i], value)) {
-							entry->emulateReadSpeed = i;
-							break;
-						}
-					}
-				}
-				else if(!strcmp("Emulate Broadband Adapter", name)) {
-					entry->emulateEthernet = !strcmp("Yes", value);
-				}
-				else if(!strcmp("Prefer Clean Boot", name)) {
-					entry->preferCleanBoot = !strcmp("Yes", value);
-				}
-			}
+	char *name, *value, *ctx = configData;
+	while(config_next_entry(&ctx, &name, &value)) {
+		if(value == NULL) continue;
+		//print_gecko("Name [%s] Value [%s]\r\n", name, value);
+		switch(config_game_key(name)) {
+			case GAME_KEY_NAME:
+				strncpy(entry->game_name, value, 64);
+				break;
+			case GAME_KEY_COMMENT:
+				strncpy(entry->comment, value, 128);
+				break;
+			case GAME_KEY_STATUS:
+				strncpy(entry->status, value, 32);
+				break;
+			case GAME_KEY_VIDEO_MODE:
+				config_match_option(value, gameVModeStr, 15, &entry->gameVMode);
+				break;
+			case GAME_KEY_HSCALE:
+				config_match_option(value, forceHScaleStr, 9, &entry->forceHScale);
+				break;
+			case GAME_KEY_VOFFSET:
+				entry->forceVOffset = atoi(value);
+				break;
+			case GAME_KEY_VFILTER:
+				config_match_option(value, forceVFilterStr, 4, &entry->forceVFilter);
+				break;
+			case GAME_KEY_VJITTER:
+				config_match_option(value, forceVJitterStr, 3, &entry->forceVJitter);
+				break;
+			case GAME_KEY_DITHERING:
+				entry->disableDithering = !strcmp("Yes", value);
+				break;
+			case GAME_KEY_ANISOTROPY:
+				entry->forceAnisotropy = !strcmp("Yes", value);
+				break;
+			case GAME_KEY_WIDESCREEN:
+				config_match_option(value, forceWidescreenStr, 3, &entry->forceWidescreen);
+				break;
+			case GAME_KEY_POLL_RATE:
+				config_match_option(value, forcePollRateStr, 13, &entry->forcePollRate);
+				break;
+			case GAME_KEY_INVERT_CSTICK:
+				config_match_option(value, invertCStickStr, 4, &entry->invertCStick);
+				break;
+			case GAME_KEY_SWAP_CSTICK:
+				config_match_option(value, swapCStickStr, 4, &entry->swapCStick);
+				break;
+			case GAME_KEY_TRIGGER_LEVEL:
+				entry->triggerLevel = atoi(value);
+				break;
+			case GAME_KEY_AUDIO_STREAM:
+				config_match_option(value, emulateAudioStreamStr, 3, &entry->emulateAudioStream);
+				break;
+			case GAME_KEY_READ_SPEED:
+				config_match_option(value, emulateReadSpeedStr, 3, &entry->emulateReadSpeed);
+				break;
+			case GAME_KEY_ETHERNET:
+				entry->emulateEthernet = !strcmp("Yes", value);
+				break;
+			case GAME_KEY_CLEAN_BOOT:
+				entry->preferCleanBoot = !strcmp("Yes", value);
+				break;
 		}
-		// And round we go again
-		line = strtok_r( NULL, "\r\n", &linectx);
 	}
 }
 
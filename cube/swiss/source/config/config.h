@@ -26,6 +26,8 @@ typedef struct {
 	int preferCleanBoot;
 } ConfigEntry;
 
+bool config_set_device();
+void config_unset_device();
 void config_find(ConfigEntry *entry);
 void config_defaults(ConfigEntry *entry);
 int config_update_game(ConfigEntry *entry, bool checkConfigDevice);
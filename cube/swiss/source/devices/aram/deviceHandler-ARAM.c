@@ -14,20 +14,19 @@
 #include "swiss.h"
 #include "main.h"
 #include "aram.h"
+#include "aram/sidestep.h"
 
 static FATFS *aramfs = NULL;
 
 file_handle initial_ARAM =
-	{ "ram:/",       // directory
-	  0ULL,     // fileBase (u64)
-	  0,        // offset
-	  0,        // size
-	  IS_DIR,
-	  0,
-	  0
+	{ .name = "ram:/",
+	  .fileAttrib = IS_DIR
 	};
 
 s32 deviceHandler_ARAM_init(file_handle* file) {
+	// A wiiload transfer is staging into ARAM
+	if(ARAMStageActive()) return EBUSY;
+
 	if(aramfs != NULL) {
 		f_unmount("ram:/");
 		free(aramfs);
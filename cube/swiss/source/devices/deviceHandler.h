@@ -30,7 +30,10 @@ typedef struct {
 	u64 fileBase : 48;
 } file_frag;
 
-typedef struct {
+typedef struct file_handle file_handle;
+typedef struct file_meta file_meta;
+
+struct file_meta {
 	dvddiskid diskId;
 	const char *displayName;
 	GXTexObj *fileTypeTexObj;
@@ -41,10 +44,13 @@ typedef struct {
 	GXTexObj bannerTexObj;
 	GXTlutObj bannerTlutObj;
 	BNRDesc bannerDesc;
-} file_meta;
+	file_handle *owner;		// entry this was populated for, used for eviction
+	u32 view;				// visible range it was last drawn in, kept while that lasts
+	file_meta *lruPrev;
+	file_meta *lruNext;
+};
 
-typedef struct {
-	char name[PATHNAME_MAX]; 		// File or Folder, absolute path goes here
+struct file_handle {
 	uint64_t fileBase;   	// Raw sector on device
 	u32 offset;    			// Offset in the file
 	u32 size;      			// size of the file
@@ -57,7 +63,19 @@ typedef struct {
 	void* uiObj;			// UI associated with this file_handle
 	vu32 lockCount;
 	lwp_t thread;
-} file_handle;	// Note: If the contents of this change, recompile pc/usbgecko/main.c
+	char name[PATHNAME_MAX]; 		// File or Folder, absolute path goes here
+};	// name comes last, directory entries only have room for their own
+
+// Directory listing, the entries are carved out of chunks of memory, each as
+// long as its name needs, and kept in order in an array that grows by doubling.
+typedef struct dir_chunk dir_chunk;
+
+typedef struct {
+	file_handle **entry;
+	int num;
+	int capacity;
+	dir_chunk *chunks;
+} dir_list;
 
 typedef struct {
 	u64 freeSpace;
@@ -84,7 +102,7 @@ typedef bool (* _fn_test)(void);
 typedef device_info* (* _fn_info)(file_handle*);
 typedef s32 (* _fn_init)(file_handle*);
 typedef s32 (* _fn_makeDir)(file_handle*);
-typedef s32 (* _fn_readDir)(file_handle*, file_handle**, u32);
+typedef s32 (* _fn_readDir)(file_handle*, dir_list*, u32);
 typedef s64 (* _fn_seekFile)(file_handle*, s64, u32);
 typedef s32 (* _fn_readFile)(file_handle*, void*, u32);
 typedef s32 (* _fn_writeFile)(file_handle*, const void*, u32);
@@ -245,6 +263,13 @@ extern const char* getHwNameByLocation(u32 location);
 extern bool getFragments(int deviceSlot, file_handle *file, file_frag **fragList, u32 *totFrags, u8 fileNum, u32 forceBaseOffset, u32 forceSize);
 extern void print_frag_list(file_frag *fragList, u32 totFrags);
 
+extern file_handle* addDirEntry(dir_list *dir, const char *name, s32 fileAttrib);
+extern bool spliceDirList(dir_list *dir, int index, dir_list *from, int first);
+extern bool isDirEntry(dir_list *dir, file_handle *file);
+extern void freeDirList(dir_list *dir);
+extern void copyFileHandle(file_handle *dst, const file_handle *src);
+extern void updateDirEntry(file_handle *entry, const file_handle *file);
+
 extern FILE* openFileStream(int deviceSlot, file_handle *file);
 
 #endif
@@ -0,0 +1,118 @@
+/* dirlist.c
+	- directory listings carved out of chunks of memory
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <sys/param.h>
+#include "deviceHandler.h"
+
+#define DIR_CHUNK_SIZE 0x8000
+// populate_meta turns a directory holding a DOL into the DOL, so directories
+// have room for its name on top of their own
+#define DIR_ENTRY_DOL_NAME "/default.dol"
+
+struct dir_chunk {
+	dir_chunk *next;
+	u32 used;
+	u32 size;
+	u64 data[];
+};
+
+// Size of an entry with room for a name of len characters
+static u32 entrySize(size_t len) {
+	return (offsetof(file_handle, name) + len + 1 + sizeof(u64) - 1) & ~(sizeof(u64) - 1);
+}
+
+// Adds an entry at the end of a listing, with all but its name and attribute cleared.
+// Returns NULL when out of memory, the listing is left as it was.
+file_handle* addDirEntry(dir_list *dir, const char *name, s32 fileAttrib) {
+	size_t len = strnlen(name, PATHNAME_MAX - 1);
+	u32 size = entrySize(len + (fileAttrib == IS_DIR ? strlen(DIR_ENTRY_DOL_NAME) : 0));
+
+	if(dir->num == dir->capacity) {
+		int capacity = dir->capacity ? dir->capacity * 2 : 64;
+		file_handle **entry = reallocarray(dir->entry, capacity, sizeof(file_handle*));
+		if(!entry) return NULL;
+		dir->entry = entry;
+		dir->capacity = capacity;
+	}
+	dir_chunk *chunk = dir->chunks;
+	if(!chunk || chunk->size - chunk->used < size) {
+		u32 chunkSize = MAX(DIR_CHUNK_SIZE, offsetof(dir_chunk, data) + size);
+		chunk = malloc(chunkSize);
+		if(!chunk) return NULL;
+		chunk->next = dir->chunks;
+		chunk->used = 0;
+		chunk->size = chunkSize - offsetof(dir_chunk, data);
+		dir->chunks = chunk;
+	}
+	file_handle *file = (file_handle*)((u8*)chunk->data + chunk->used);
+	chunk->used += size;
+
+	memset(file, 0, offsetof(file_handle, name));
+	memcpy(file->name, name, len);
+	file->name[len] = '\0';
+	file->fileAttrib = fileAttrib;
+	dir->entry[dir->num++] = file;
+	return file;
+}
+
+// Replaces entry index of a listing with the entries of another from first on,
+// taking over their memory. Returns false when out of memory, nothing is moved.
+bool spliceDirList(dir_list *dir, int index, dir_list *from, int first) {
+	int count = MAX(from->num - first, 0);
+	int num = dir->num - 1 + count;
+
+	if(num > dir->capacity) {
+		file_handle **entry = reallocarray(dir->entry, num, sizeof(file_handle*));
+		if(!entry) return false;
+		dir->entry = entry;
+		dir->capacity = num;
+	}
+	memmove(&dir->entry[index + count], &dir->entry[index + 1], (dir->num - index - 1) * sizeof(file_handle*));
+	memcpy(&dir->entry[index], &from->entry[first], count * sizeof(file_handle*));
+	dir->num = num;
+
+	dir_chunk **last = &dir->chunks;
+	while(*last) last = &(*last)->next;
+	*last = from->chunks;
+	from->chunks = NULL;
+	freeDirList(from);
+	return true;
+}
+
+// Whether a file handle is one of the entries of a listing.
+bool isDirEntry(dir_list *dir, file_handle *file) {
+	for(dir_chunk *chunk = dir->chunks; chunk; chunk = chunk->next) {
+		if((u8*)file >= (u8*)chunk->data && (u8*)file < (u8*)chunk->data + chunk->used) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void freeDirList(dir_list *dir) {
+	while(dir->chunks) {
+		dir_chunk *next = dir->chunks->next;
+		free(dir->chunks);
+		dir->chunks = next;
+	}
+	free(dir->entry);
+	dir->entry = NULL;
+	dir->num = 0;
+	dir->capacity = 0;
+}
+
+// Copies a file handle, dst must have room for the name of src.
+void copyFileHandle(file_handle *dst, const file_handle *src) {
+	memcpy(dst, src, offsetof(file_handle, name));
+	strcpy(dst->name, src->name);
+}
+
+// Hands the state of a file handle back to the directory entry it was copied from,
+// leaving the entry's name as it is.
+void updateDirEntry(file_handle *entry, const file_handle *file) {
+	memcpy(entry, file, offsetof(file_handle, name));
+}
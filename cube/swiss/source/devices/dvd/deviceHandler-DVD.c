@@ -20,13 +20,10 @@
 #include "wkf.h"
 
 file_handle initial_DVD =
-{ "dvd:/",     // directory
-	  0ULL,     // fileBase (u64)
-	  0,        // offset
-	  0,        // size
-	  IS_DIR,
-	  DRV_ERROR
-};
+	{ .name = "dvd:/",
+	  .fileAttrib = IS_DIR,
+	  .status = DRV_ERROR
+	};
 
 device_info initial_DVD_info = {
 	DISC_SIZE,
@@ -130,6 +127,7 @@ char *dvd_error_str()
 int initialize_disc(u32 streaming) {
 	int patched = NORMAL_MODE;
 	uiDrawObj_t* progBar = DrawPublish(DrawProgressBar(true, 0, "DVD Initializing"));
+	dvd_clear_dircache();
 	if(is_gamecube())
 	{
 		// Reset WKF hard to allow for a real disc to be read if SD is removed
@@ -239,15 +237,16 @@ device_info* deviceHandler_DVD_info(file_handle* file) {
 	return &initial_DVD_info;
 }
 
-s32 deviceHandler_DVD_readDir(file_handle* ffile, file_handle** dir, u32 type){
+s32 deviceHandler_DVD_readDir(file_handle* ffile, dir_list* dir, u32 type){
 
 	unsigned int i = 0, isGC = is_gamecube();
 	unsigned int  *tmpTable = NULL;
 	char *tmpName  = NULL;
 	u64 tmpOffset = 0LL;
 	u64 usedSpace = 0LL;
+	char name[PATHNAME_MAX];
 
-	int num_entries = 0, ret = 0, num = 0;
+	int num_entries = 0, ret = 0;
 	dvd_get_error(); // Clear any 0x052400's
 	
 	if(dvd_get_error() || !dvd_init) { //if some error
@@ -289,31 +288,36 @@ s32 deviceHandler_DVD_readDir(file_handle* ffile, file_handle** dir, u32 type){
 		}
 		print_gecko("%i entries found\r\n", num_entries);
 
-		if(num_entries <= 0) { return num_entries; }
-		// malloc the directory structure
-		*dir = calloc(num_entries, sizeof(file_handle));
+		if(num_entries <= 0) {
+			free(tmpTable);
+			free(tmpName);
+			return num_entries;
+		}
 		
 		// parse entries
 		for(i = 0; i < num_entries; i++) {
 			tmpOffset = (dvdDiscTypeInt == GCOSD9_MULTIGAME_DISC) ? (tmpTable[i]<<2):(tmpTable[i]);
-			if(num > 0) {
-				(*dir)[num-1].size = tmpOffset - (*dir)[num-1].fileBase;
+			if(dir->num > 0) {
+				dir->entry[dir->num-1]->size = tmpOffset - dir->entry[dir->num-1]->fileBase;
 			}
 			print_gecko("fileBase is %016llX isGC? %s\r\n", tmpOffset, isGC ? "yes" : "no");
 			if((tmpOffset%(isGC?0x8000:0x20000)==0) && (tmpOffset<(isGC?DISC_SIZE:WII_D9_SIZE))) {
 				DVD_Read(&tmpName[0],tmpOffset+32,64);
-				concatf_path((*dir)[num].name, ffile->name, "%.64s.gcm", &tmpName[0]);
-				(*dir)[num].fileBase = tmpOffset;
-				(*dir)[num].offset = 0;
-				(*dir)[num].size   = (isGC?DISC_SIZE:WII_D9_SIZE)-tmpOffset;
-				(*dir)[num].fileAttrib	 = IS_FILE;
-				(*dir)[num].meta = 0;
-				(*dir)[num].status = STATUS_NOT_MAPPED;
-				num++;
+				concatf_path(name, ffile->name, "%.64s.gcm", &tmpName[0]);
+				file_handle* file = addDirEntry(dir, name, IS_FILE);
+				if(!file) {
+					free(tmpTable);
+					free(tmpName);
+					goto fail;
+				}
+				file->fileBase = tmpOffset;
+				file->size   = (isGC?DISC_SIZE:WII_D9_SIZE)-tmpOffset;
+				file->status = STATUS_NOT_MAPPED;
 			}
 		}
 		free(tmpTable);
 		free(tmpName);
+		num_entries = dir->num;
 		usedSpace = (isGC?DISC_SIZE:WII_D9_SIZE);
 	}
 	else if((dvdDiscTypeInt == GAMECUBE_DISC) || (dvdDiscTypeInt == MULTIDISC_DISC)) {
@@ -326,48 +330,52 @@ s32 deviceHandler_DVD_readDir(file_handle* ffile, file_handle** dir, u32 type){
 		// If it was not successful, just return the error
 		if(num_entries <= 0) return -1;
 		// Convert the DVD "file" data to fileBrowser_files
-		*dir = calloc(num_entries, sizeof(file_handle));
+		bool isRoot = true;
 		int i;
 		for(i=0; i<num_entries; ++i){
-			concat_path((*dir)[i].name, ffile->name, DVDToc->file[i].name);
-			(*dir)[i].fileBase = (uint64_t)(((uint64_t)DVDToc->file[i].sector)*2048);
-			(*dir)[i].offset = 0;
-			(*dir)[i].size   = DVDToc->file[i].size;
-			(*dir)[i].fileAttrib	 = IS_FILE;
+			concat_path(name, ffile->name, DVDToc->file[i].name);
+			if(name[strlen(name)-1] == '/' )
+			name[strlen(name)-1] = 0;	//get rid of trailing '/'
+			s32 fileAttrib = IS_FILE;
 			if(DVDToc->file[i].flags == 2)//on DVD, 2 is a dir
-			(*dir)[i].fileAttrib   = IS_DIR;
-			if((*dir)[i].name[strlen((*dir)[i].name)-1] == '/' )
-			(*dir)[i].name[strlen((*dir)[i].name)-1] = 0;	//get rid of trailing '/'
-			(*dir)[i].meta = 0;
-			usedSpace += (*dir)[i].size;
+			fileAttrib = IS_DIR;
+			if(i == 0 && strcmp(name, ffile->name) == 0) {
+				concat_path(name, ffile->name, "..");
+				fileAttrib = IS_SPECIAL;
+				isRoot = false;
+			}
+			file_handle* file = addDirEntry(dir, name, fileAttrib);
+			if(!file) {
+				free(DVDToc);
+				DVDToc = NULL;
+				goto fail;
+			}
+			file->fileBase = (uint64_t)(((uint64_t)DVDToc->file[i].sector)*2048);
+			file->size   = DVDToc->file[i].size;
+			usedSpace += file->size;
 		}
 		//kill the large TOC so we can have a lot more memory ingame (256k more)
 		free(DVDToc);
 		DVDToc = NULL;
 
-		if(strcmp((*dir)[0].name, ffile->name) == 0) {
-			concat_path((*dir)[0].name, ffile->name, "..");
-			(*dir)[0].fileAttrib = IS_SPECIAL;
-		}
-		else if(dvdDiscTypeInt == ISO9660_GAMECUBE_DISC) {
+		if(isRoot && dvdDiscTypeInt == ISO9660_GAMECUBE_DISC) {
 			DiskHeader *diskHeader = get_gcm_header(ffile);
-			if(!diskHeader) return -1;
-
-			*dir = reallocarray(*dir, num_entries + 1, sizeof(file_handle));
-			memset(&(*dir)[num_entries], 0, sizeof(file_handle));
-			concatf_path((*dir)[num_entries].name, ffile->name, "%.64s.gcm", diskHeader->GameName);
-			(*dir)[num_entries].fileBase = 0;
-			(*dir)[num_entries].offset = 0;
-			(*dir)[num_entries].size = DISC_SIZE;
-			(*dir)[num_entries].fileAttrib = IS_FILE;
-			(*dir)[num_entries].meta = 0;
-			num_entries++;
+			if(!diskHeader) goto fail;
 
+			concatf_path(name, ffile->name, "%.64s.gcm", diskHeader->GameName);
 			free(diskHeader);
+			file_handle* file = addDirEntry(dir, name, IS_FILE);
+			if(!file) goto fail;
+			file->size = DISC_SIZE;
+			num_entries++;
 		}
 	}
 	initial_DVD_info.freeSpace = initial_DVD_info.totalSpace - usedSpace;
 	return num_entries;
+
+fail:
+	freeDirList(dir);
+	return -1;
 }
 
 s64 deviceHandler_DVD_seekFile(file_handle* file, s64 where, u32 type){
@@ -545,6 +553,7 @@ s32 deviceHandler_DVD_init(file_handle* file){
 
 s32 deviceHandler_DVD_deinit(file_handle* file) {
 	dvd_motor_off();
+	dvd_clear_dircache();
 	dvdDiscTypeStr = NotInitStr;
 	return 0;
 }
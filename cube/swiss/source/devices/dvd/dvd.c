@@ -14,10 +14,8 @@
 #include "drivecodes.h"
 
 /* Simple DVD functions */
-int is_unicode,files,isXenoGC = 0;
-static int last_current_dir = -1;
+int isXenoGC = 0;
 u32 inquiryBuf[32] __attribute__((aligned(32)));
-file_entries *DVDToc = NULL; //Dynamically allocate this
 volatile unsigned long* dvd = (volatile unsigned long*)0xCC006000;
 
 void dvd_reset()
@@ -90,6 +88,7 @@ void dvd_motor_off()
 
 void dvd_set_offset(u64 offset)
 {
+	dvd_clear_dircache();
 	if(is_gamecube() && isXenoGC) {
 		print_gecko("XenoGC offset set\r\n");
 		dvd[0] = 0x2e;
@@ -493,6 +492,12 @@ int DVD_ReadID(dvddiskid *diskID)
 }
 
 int read_sector(void* buffer, int numSectors, uint32_t sector){
+	// Aligned buffers can take the whole run in one request
+	if(!((u32)buffer & 31)) {
+		if(DVD_LowRead64(buffer, numSectors*2048, (uint64_t)sector*2048))
+			return -1;
+		return numSectors*2048;
+	}
 	return DVD_Read(buffer, sector*2048, numSectors*2048);
 }
 
@@ -505,200 +510,3 @@ void xeno_disable() {
   DVD_LowRead64(readBuf, 64*1024, 0x1000000);   //xeno GC disable patching
   free(readBuf);
 }
-
-int read_direntry(unsigned char* direntry)
-{
-       int nrb = *direntry++;
-       ++direntry;
-
-       int sector;
-
-       direntry += 4;
-       sector = (*direntry++) << 24;
-       sector |= (*direntry++) << 16;
-       sector |= (*direntry++) << 8;
-       sector |= (*direntry++);        
-
-       int size;
-
-       direntry += 4;
-
-       size = (*direntry++) << 24;
-       size |= (*direntry++) << 16;
-       size |= (*direntry++) << 8;
-       size |= (*direntry++);
-
-       direntry += 7; // skip date
-
-       int flags = *direntry++;
-       ++direntry; ++direntry; direntry += 4;
-
-       int nl = *direntry++;
-
-       char* name = DVDToc->file[files].name;
-
-       DVDToc->file[files].sector = sector;
-       DVDToc->file[files].size = size;
-       DVDToc->file[files].flags = flags;
-
-       if ((nl == 1) && (direntry[0] == 1)) // ".."
-       {
-               DVDToc->file[files].name[0] = 0;
-               if (last_current_dir != sector)
-                       files++;
-       }
-       else if ((nl == 1) && (direntry[0] == 0))
-       {
-               last_current_dir = sector;
-       }
-       else
-       {
-               if (is_unicode)
-               {
-                       int i;
-                       for (i = 0; i < (nl / 2); ++i)
-                               name[i] = direntry[i * 2 + 1];
-                       name[i] = 0;
-                       nl = i;
-               }
-               else
-               {
-                       memcpy(name, direntry, nl);
-                       name[nl] = 0;
-               }
-
-               if (!(flags & 2))
-               {
-                       if (name[nl - 2] == ';')
-                               name[nl - 2] = 0;
-
-                       int i = nl;
-                       while (i >= 0)
-                               if (name[i] == '.')
-                                       break;
-                               else
-                                       --i;
-
-                       ++i;
-
-               }
-               else
-               {
-                       name[nl++] = '/';
-                       name[nl] = 0;
-               }
-
-               files++;
-       }
-
-       return nrb;
-}
-
-
-
-void read_directory(int sector, int len)
-{
-  int ptr = 0;
-  unsigned char *sector_buffer = (unsigned char*)memalign(32,2048);
-  read_sector(sector_buffer, 1, sector);
-  
-  files = 0;
-  memset(DVDToc,0,sizeof(file_entries));
-  while (len > 0)
-  {
-    ptr += read_direntry(sector_buffer + ptr);
-    if (ptr >= 2048 || !sector_buffer[ptr])
-    {
-      len -= 2048;
-      sector++;
-      read_sector(sector_buffer, 1, sector);
-      ptr = 0;
-    }
-  }
-  free(sector_buffer);
-}
-
-
-int dvd_read_directoryentries(uint64_t offset, int size) {
-  int sector = 16;
-  unsigned char *bufferDVD = (unsigned char*)memalign(32,2048);
-  struct pvd_s* pvd = 0;
-  struct pvd_s* svd = 0;
-  
-  if(DVDToc)
-  {
-    free(DVDToc);
-    DVDToc = NULL;
-  }
-  DVDToc = memalign(32,sizeof(file_entries));
-  
-  while (sector < 32)
-  {
-    if (read_sector(bufferDVD, 1, sector)!=2048)
-    {
-      free(bufferDVD);
-      free(DVDToc);
-      DVDToc = NULL;
-      return FATAL_ERROR;
-    }
-    if (!memcmp(((struct pvd_s *)bufferDVD)->id, "\2CD001\1", 8))
-    {
-      svd = (void*)bufferDVD;
-      break;
-    }
-    ++sector;
-  }
-  
-  
-  if (!svd)
-  {
-    sector = 16;
-    while (sector < 32)
-    {
-      if (read_sector(bufferDVD, 1, sector)!=2048)
-      {
-        free(bufferDVD);
-        free(DVDToc);
-        DVDToc = NULL;
-        return FATAL_ERROR;
-      }
-      
-      if (!memcmp(((struct pvd_s *)bufferDVD)->id, "\1CD001\1", 8))
-      {
-        pvd = (void*)bufferDVD;
-        break;
-      }
-      ++sector;
-    }
-  }
-  
-  if ((!pvd) && (!svd))
-  {
-    free(bufferDVD);
-    free(DVDToc);
-    DVDToc = NULL;
-    return NO_ISO9660_DISC;
-  }
-  
-  files = 0;
-  if (svd)
-  {
-    is_unicode = 1;
-    read_direntry(svd->root_direntry);
-  }
-  else
-  {
-    is_unicode = 0;
-    read_direntry(pvd->root_direntry);
-  }
-  
-  if((size + offset) == 0)  // enter root
-    read_directory(DVDToc->file[0].sector, DVDToc->file[0].size);
-  else
-    read_directory(offset>>11, size);
-
-  free(bufferDVD);
-  if(files>0)
-    return files;
-  return NO_FILES;
-}
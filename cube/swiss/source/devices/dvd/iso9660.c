@@ -0,0 +1,264 @@
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include "dvd.h"
+
+/* ISO9660 directory parsing */
+int is_unicode,files;
+static int last_current_dir = -1;
+file_entries *DVDToc = NULL; //Dynamically allocate this
+
+/* ISO9660 directory extents, most recently used first */
+#define DIR_CACHE_SIZE (256*1024)
+
+typedef struct dir_extent {
+	struct dir_extent *next;
+	u32 sector;
+	u32 numSectors;
+	u8 *data;
+} dir_extent;
+
+static dir_extent *dir_cache = NULL;
+static u32 dir_cache_size = 0;
+
+void dvd_clear_dircache()
+{
+	while(dir_cache) {
+		dir_extent *next = dir_cache->next;
+		free(dir_cache->data);
+		free(dir_cache);
+		dir_cache = next;
+	}
+	dir_cache_size = 0;
+}
+
+/* 
+read_extent(u32 sector, u32 numSectors)
+  Returns the sectors from the directory cache, reading them in on a miss.
+  The pointer is only valid until the next call.
+*/
+static u8 *read_extent(u32 sector, u32 numSectors)
+{
+	dir_extent **prev = &dir_cache, *extent;
+	for(extent = dir_cache; extent != NULL; prev = &extent->next, extent = extent->next) {
+		if(extent->sector == sector && extent->numSectors >= numSectors) {
+			*prev = extent->next;
+			extent->next = dir_cache;
+			dir_cache = extent;
+			return extent->data;
+		}
+	}
+
+	extent = calloc(1, sizeof(dir_extent));
+	if(!extent)
+		return NULL;
+	extent->sector = sector;
+	extent->numSectors = numSectors;
+	extent->data = memalign(32, numSectors*2048);
+	if(!extent->data || read_sector(extent->data, numSectors, sector) != (int)numSectors*2048) {
+		free(extent->data);
+		free(extent);
+		return NULL;
+	}
+
+	// Drop the least recently used extents to make room
+	dir_cache_size += numSectors*2048;
+	while(dir_cache_size > DIR_CACHE_SIZE && dir_cache) {
+		for(prev = &dir_cache; (*prev)->next != NULL; prev = &(*prev)->next);
+		dir_cache_size -= (*prev)->numSectors*2048;
+		free((*prev)->data);
+		free(*prev);
+		*prev = NULL;
+	}
+	extent->next = dir_cache;
+	dir_cache = extent;
+	return extent->data;
+}
+
+int read_direntry(unsigned char* direntry)
+{
+       int nrb = *direntry++;
+       ++direntry;
+
+       int sector;
+
+       direntry += 4;
+       sector = (*direntry++) << 24;
+       sector |= (*direntry++) << 16;
+       sector |= (*direntry++) << 8;
+       sector |= (*direntry++);        
+
+       int size;
+
+       direntry += 4;
+
+       size = (*direntry++) << 24;
+       size |= (*direntry++) << 16;
+       size |= (*direntry++) << 8;
+       size |= (*direntry++);
+
+       direntry += 7; // skip date
+
+       int flags = *direntry++;
+       ++direntry; ++direntry; direntry += 4;
+
+       int nl = *direntry++;
+
+       char* name = DVDToc->file[files].name;
+
+       DVDToc->file[files].sector = sector;
+       DVDToc->file[files].size = size;
+       DVDToc->file[files].flags = flags;
+
+       if ((nl == 1) && (direntry[0] == 1)) // ".."
+       {
+               DVDToc->file[files].name[0] = 0;
+               if (last_current_dir != sector)
+                       files++;
+       }
+       else if ((nl == 1) && (direntry[0] == 0))
+       {
+               last_current_dir = sector;
+       }
+       else
+       {
+               if (is_unicode)
+               {
+                       int i;
+                       for (i = 0; i < (nl / 2); ++i)
+                               name[i] = direntry[i * 2 + 1];
+                       name[i] = 0;
+                       nl = i;
+               }
+               else
+               {
+                       memcpy(name, direntry, nl);
+                       name[nl] = 0;
+               }
+
+               if (!(flags & 2))
+               {
+                       if (name[nl - 2] == ';')
+                               name[nl - 2] = 0;
+
+                       int i = nl;
+                       while (i >= 0)
+                               if (name[i] == '.')
+                                       break;
+                               else
+                                       --i;
+
+                       ++i;
+
+               }
+               else
+               {
+                       name[nl++] = '/';
+                       name[nl] = 0;
+               }
+
+               files++;
+       }
+
+       return nrb;
+}
+
+
+
+void read_directory(int sector, int len)
+{
+  int ptr = 0;
+  unsigned char *sector_buffer = read_extent(sector, (len + 2047) / 2048);
+  
+  files = 0;
+  memset(DVDToc,0,sizeof(file_entries));
+  if (!sector_buffer)
+    return;
+  while (len > 0)
+  {
+    ptr += read_direntry(sector_buffer + ptr);
+    if (ptr >= 2048 || !sector_buffer[ptr])
+    {
+      len -= 2048;
+      sector_buffer += 2048;
+      ptr = 0;
+    }
+  }
+}
+
+
+int dvd_read_directoryentries(uint64_t offset, int size) {
+  int sector = 16;
+  unsigned char *bufferDVD;
+  struct pvd_s* pvd = 0;
+  struct pvd_s* svd = 0;
+  
+  if(DVDToc)
+  {
+    free(DVDToc);
+    DVDToc = NULL;
+  }
+  DVDToc = memalign(32,sizeof(file_entries));
+  
+  // The volume descriptors are read together and kept with the directories
+  bufferDVD = read_extent(16, 16);
+  if (!bufferDVD)
+  {
+    free(DVDToc);
+    DVDToc = NULL;
+    return FATAL_ERROR;
+  }
+  
+  while (sector < 32)
+  {
+    if (!memcmp(((struct pvd_s *)(bufferDVD + (sector - 16) * 2048))->id, "\2CD001\1", 8))
+    {
+      svd = (void*)(bufferDVD + (sector - 16) * 2048);
+      break;
+    }
+    ++sector;
+  }
+  
+  
+  if (!svd)
+  {
+    sector = 16;
+    while (sector < 32)
+    {
+      if (!memcmp(((struct pvd_s *)(bufferDVD + (sector - 16) * 2048))->id, "\1CD001\1", 8))
+      {
+        pvd = (void*)(bufferDVD + (sector - 16) * 2048);
+        break;
+      }
+      ++sector;
+    }
+  }
+  
+  if ((!pvd) && (!svd))
+  {
+    free(DVDToc);
+    DVDToc = NULL;
+    return NO_ISO9660_DISC;
+  }
+  
+  files = 0;
+  if (svd)
+  {
+    is_unicode = 1;
+    read_direntry(svd->root_direntry);
+  }
+  else
+  {
+    is_unicode = 0;
+    read_direntry(pvd->root_direntry);
+  }
+  
+  if((size + offset) == 0)  // enter root
+    read_directory(DVDToc->file[0].sector, DVDToc->file[0].size);
+  else
+    read_directory(offset>>11, size);
+
+  if(files>0)
+    return files;
+  return NO_FILES;
+}
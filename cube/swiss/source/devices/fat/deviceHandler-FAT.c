@@ -33,63 +33,33 @@ int GET_SLOT(file_handle* file) {
 }
 
 file_handle initial_SD_A =
-	{ "sda:/",       // directory
-	  0ULL,     // fileBase (u64)
-	  0,        // offset
-	  0,        // size
-	  IS_DIR,
-	  0,
-	  0
+	{ .name = "sda:/",
+	  .fileAttrib = IS_DIR
 	};
 	
 file_handle initial_SD_B =
-	{ "sdb:/",       // directory
-	  0ULL,     // fileBase (u64)
-	  0,        // offset
-	  0,        // size
-	  IS_DIR,
-	  0,
-	  0
+	{ .name = "sdb:/",
+	  .fileAttrib = IS_DIR
 	};
 	
 file_handle initial_SD_C =
-	{ "sdc:/",       // directory
-	  0ULL,     // fileBase (u64)
-	  0,        // offset
-	  0,        // size
-	  IS_DIR,
-	  0,
-	  0
+	{ .name = "sdc:/",
+	  .fileAttrib = IS_DIR
 	};	
 	
 file_handle initial_ATA_A =
-	{ "ataa:/",       // directory
-	  0ULL,     // fileBase (u64)
-	  0,        // offset
-	  0,        // size
-	  IS_DIR,
-	  0,
-	  0
+	{ .name = "ataa:/",
+	  .fileAttrib = IS_DIR
 	};
 	
 file_handle initial_ATA_B =
-	{ "atab:/",       // directory
-	  0ULL,     // fileBase (u64)
-	  0,        // offset
-	  0,        // size
-	  IS_DIR,
-	  0,
-	  0
+	{ .name = "atab:/",
+	  .fileAttrib = IS_DIR
 	};
 	
 file_handle initial_ATA_C =
-	{ "atac:/",       // directory
-	  0ULL,     // fileBase (u64)
-	  0,        // offset
-	  0,        // size
-	  IS_DIR,
-	  0,
-	  0
+	{ .name = "atac:/",
+	  .fileAttrib = IS_DIR
 	};
 
 static device_info initial_FAT_info[FF_VOLUMES];
@@ -107,18 +77,17 @@ device_info* deviceHandler_FAT_info(file_handle* file) {
 	return info;
 }
 
-s32 deviceHandler_FAT_readDir(file_handle* ffile, file_handle** dir, u32 type) {	
+s32 deviceHandler_FAT_readDir(file_handle* ffile, dir_list* dir, u32 type) {	
 
 	DIRF* dp = malloc(sizeof(DIRF));
 	memset(dp, 0, sizeof(DIRF));
 	if(f_opendir(dp, ffile->name) != FR_OK) return -1;
 	FILINFO entry;
+	char name[PATHNAME_MAX];
 	
 	// Set everything up to read
-	int num_entries = 1, i = 1;
-	*dir = calloc(num_entries, sizeof(file_handle));
-	concat_path((*dir)[0].name, ffile->name, "..");
-	(*dir)[0].fileAttrib = IS_SPECIAL;
+	concat_path(name, ffile->name, "..");
+	if(!addDirEntry(dir, name, IS_SPECIAL)) goto fail;
 
 	// Read each entry of the directory
 	while( f_readdir(dp, &entry) == FR_OK && entry.fname[0] != '\0') {
@@ -130,23 +99,23 @@ s32 deviceHandler_FAT_readDir(file_handle* ffile, file_handle** dir, u32 type) {
 			if(!(entry.fattrib & AM_DIR)) {
 				if(!checkExtension(entry.fname)) continue;
 			}
-			// Make sure we have room for this one
-			if(i == num_entries){
-				++num_entries;
-				*dir = reallocarray(*dir, num_entries, sizeof(file_handle));
-			}
-			memset(&(*dir)[i], 0, sizeof(file_handle));
-			if(concat_path((*dir)[i].name, ffile->name, entry.fname) < PATHNAME_MAX && entry.fsize <= UINT32_MAX) {
-				(*dir)[i].size       = entry.fsize;
-				(*dir)[i].fileAttrib = (entry.fattrib & AM_DIR) ? IS_DIR : IS_FILE;
-				++i;
+			if(concat_path(name, ffile->name, entry.fname) < PATHNAME_MAX && entry.fsize <= UINT32_MAX) {
+				file_handle* file = addDirEntry(dir, name, (entry.fattrib & AM_DIR) ? IS_DIR : IS_FILE);
+				if(!file) goto fail;
+				file->size = entry.fsize;
 			}
 		}
 	}
 	
 	f_closedir(dp);
 	free(dp);
-	return i;
+	return dir->num;
+
+fail:
+	f_closedir(dp);
+	free(dp);
+	freeDirList(dir);
+	return -1;
 }
 
 s64 deviceHandler_FAT_seekFile(file_handle* file, s64 where, u32 type){
@@ -18,7 +18,7 @@ extern DEVICEHANDLER_INTERFACE __device_ata_c;
 
 extern device_info* deviceHandler_FAT_info(file_handle* file);
 extern s32 deviceHandler_FAT_makeDir(file_handle* dir);
-extern s32 deviceHandler_FAT_readDir(file_handle* ffile, file_handle** dir, u32 type);
+extern s32 deviceHandler_FAT_readDir(file_handle* ffile, dir_list* dir, u32 type);
 extern s64 deviceHandler_FAT_seekFile(file_handle* file, s64 where, u32 type);
 extern s32 deviceHandler_FAT_readFile(file_handle* file, void* buffer, u32 length);
 extern s32 deviceHandler_FAT_writeFile(file_handle* file, const void* buffer, u32 length);
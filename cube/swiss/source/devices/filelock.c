@@ -65,6 +65,37 @@ bool trylockFile(file_handle *file)
 	return true;
 }
 
+/* Like lockFile, but gives up once *cancel is set and cancelLockFile is called. */
+bool lockFileUntil(file_handle *file, volatile bool *cancel)
+{
+	uint32_t level;
+
+	_CPU_ISR_Disable(level);
+
+	while (file->lockCount != 0 && file->thread != LWP_GetSelf()) {
+		if (*cancel) {
+			_CPU_ISR_Restore(level);
+			return false;
+		}
+		LWP_ThreadSleep(queue);
+	}
+
+	file->lockCount++;
+	file->thread = LWP_GetSelf();
+
+	_CPU_ISR_Restore(level);
+	return true;
+}
+
+void cancelLockFile(void)
+{
+	uint32_t level;
+
+	_CPU_ISR_Disable(level);
+	LWP_ThreadBroadcast(queue);
+	_CPU_ISR_Restore(level);
+}
+
 void unlockFile(file_handle *file)
 {
 	uint32_t level;
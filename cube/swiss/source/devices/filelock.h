@@ -25,6 +25,8 @@
 
 void lockFile(file_handle *file);
 bool trylockFile(file_handle *file);
+bool lockFileUntil(file_handle *file, volatile bool *cancel);
+void cancelLockFile(void);
 void unlockFile(file_handle *file);
 
 #endif /* __FILELOCK_H__ */
@@ -18,7 +18,9 @@
 #include "dvd.h"
 #include "filelock.h"
 #include "filemeta.h"
+#include "metacache.h"
 #include "nkit.h"
+#include "sidestep.h"
 #include "swiss.h"
 #include "deviceHandler.h"
 #include "FrameBufferMagic.h"
@@ -29,17 +31,122 @@ extern BNR blankbanner;
 #define NUM_META_MAX (512)
 #define META_CACHE_SIZE (sizeof(file_meta) * NUM_META_MAX)
 
+#define NUM_META_THREADS (2)
+#define NUM_META_SKIPPED (16)
+
 static heap_cntrl* meta_cache = NULL;
-static lwp_t meta_thread = LWP_THREAD_NULL;
+static lwp_t meta_threads[NUM_META_THREADS] = {LWP_THREAD_NULL, LWP_THREAD_NULL};
+// Asks a meta thread to finish, its handle is kept until meta_thread_stop joins it
+static volatile bool meta_threads_quit[NUM_META_THREADS];
+static void* meta_loading_box = NULL;
+
+// Guards the LRU list, the visible range as last seen and the queue
+static mutex_t meta_mutex = LWP_MUTEX_NULL;
+
+// Allocated metas of directory entries, most recently used at the head
+static file_meta meta_lru = {.lruPrev = &meta_lru, .lruNext = &meta_lru};
+
+// Visible range as last seen, bumping meta_view each time it moves, and how far
+// past it has been handed out to the meta threads
+static int meta_view_start = 0;
+static int meta_view_end = 0;
+static u32 meta_view = 1;
+static int meta_queue_pos = 0;
+
+__attribute((constructor))
+static void initMutex(void)
+{
+	LWP_MutexInit(&meta_mutex, false);
+}
+
+static void meta_lru_unlink(file_meta* meta) {
+	meta->lruPrev->lruNext = meta->lruNext;
+	meta->lruNext->lruPrev = meta->lruPrev;
+	meta->lruPrev = meta->lruNext = meta;
+}
+
+static void meta_lru_push(file_meta* meta) {
+	meta->lruPrev = &meta_lru;
+	meta->lruNext = meta_lru.lruNext;
+	meta_lru.lruNext->lruPrev = meta;
+	meta_lru.lruNext = meta;
+}
+
+// Catches up with the visible range, called with meta_mutex held.
+static void meta_view_update() {
+	if(meta_view_start != current_view_start || meta_view_end != current_view_end) {
+		// The view has moved on, drop whatever was queued for the old one
+		meta_view_start = current_view_start;
+		meta_view_end = current_view_end;
+		meta_view++;
+		meta_queue_pos = 0;
+	}
+}
+
+// Moves a meta to the head of the LRU list. Only metas of directory entries are
+// evicted, one handed off to another file_handle is left to whoever has it.
+static void meta_touch(file_handle *f) {
+	bool entry = isDirEntry(getCurrentDirEntries(), f);
+	LWP_MutexLock(meta_mutex);
+	meta_lru_unlink(f->meta);
+	if(entry) {
+		f->meta->owner = f;
+		meta_lru_push(f->meta);
+	}
+	LWP_MutexUnlock(meta_mutex);
+}
+
+static int meta_thread_slot() {
+	for(int i = 0; i < NUM_META_THREADS; i++) {
+		if(meta_threads[i] == LWP_GetSelf()) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static void meta_destroy(file_meta* meta) {
+	if(meta->banner) {
+		free(meta->banner);
+		meta->banner = NULL;
+	}
+	__lwp_heap_free(meta_cache, meta);
+}
 
 void meta_free(file_meta* meta) {
 	if(meta_cache && meta) {
-		if(meta->banner) {
-			free(meta->banner);
-			meta->banner = NULL;
+		LWP_MutexLock(meta_mutex);
+		meta_lru_unlink(meta);
+		LWP_MutexUnlock(meta_mutex);
+		meta_destroy(meta);
+	}
+}
+
+// Evicts the least recently used meta that wasn't drawn in the current view and
+// is not in use.
+static bool meta_release() {
+	LWP_MutexLock(meta_mutex);
+	meta_view_update();
+	for(file_meta* meta = meta_lru.lruPrev; meta != &meta_lru; ) {
+		file_meta* prev = meta->lruPrev;
+		file_handle* f = meta->owner;
+		if(f->meta != meta) {
+			// Handed off to another file_handle, leave it to whoever owns it now
+			meta_lru_unlink(meta);
+		}
+		else if(meta->view != meta_view && trylockFile(f)) {
+			meta_lru_unlink(meta);
+			LWP_MutexUnlock(meta_mutex);
+			meta_destroy(meta);
+			f->meta = NULL;
+			devices[DEVICE_CUR]->closeFile(f);
+			unlockFile(f);
+			return true;
 		}
-		__lwp_heap_free(meta_cache, meta);
+		meta = prev;
 	}
+	LWP_MutexUnlock(meta_mutex);
+	return false;
 }
 
 file_meta* meta_alloc() {
@@ -49,32 +156,27 @@ file_meta* meta_alloc() {
 	}
 
 	file_meta* meta = __lwp_heap_allocate(meta_cache, sizeof(file_meta));
-	// When there's no room to allocate, kill thread
+	// When there's no room to allocate, stop threads
 	if(!meta) {
-		lwp_t thread = meta_thread;
-		meta_thread = LWP_THREAD_NULL;
-		if(thread == LWP_GetSelf()) {
+		int slot = meta_thread_slot();
+		if(slot >= 0) {
+			meta_threads_quit[slot] = true;
 			return NULL;
 		}
+		for(int i = 0; i < NUM_META_THREADS; i++) {
+			meta_threads_quit[i] = true;
+		}
+		cancelLockFile();
 	}
 	// While there's no room to allocate, call release
 	while(!meta) {
-		file_handle** dirEntries = getSortedDirEntries();
-		int dirEntryCount = getSortedDirEntryCount();
-		for(int i = 0; i < dirEntryCount; i++) {
-			if(!in_range(i, current_view_start, current_view_end)) {
-				if(dirEntries[i]->meta && trylockFile(dirEntries[i])) {
-					meta_free(dirEntries[i]->meta);
-					dirEntries[i]->meta = NULL;
-					devices[DEVICE_CUR]->closeFile(dirEntries[i]);
-					unlockFile(dirEntries[i]);
-					break;
-				}
-			}
+		if(!meta_release()) {
+			LWP_YieldThread();
 		}
 		meta = __lwp_heap_allocate(meta_cache, sizeof(file_meta));
 	}
 	memset(meta, 0, sizeof(file_meta));
+	meta->lruPrev = meta->lruNext = meta;
 	return meta;
 }
 
@@ -153,6 +255,23 @@ void populate_save_meta(file_handle *f, u8 bannerFormat, u32 bannerOffset, u32 c
 	}
 }
 
+void set_banner_display_name(file_meta *meta) {
+	if(strnlen(meta->bannerDesc.fullGameName, BNR_FULL_TEXT_LEN))
+		meta->displayName = meta->bannerDesc.fullGameName;
+	else if(strnlen(meta->bannerDesc.gameName, BNR_SHORT_TEXT_LEN))
+		meta->displayName = meta->bannerDesc.gameName;
+}
+
+// Restores banner meta previously recorded by metacache_put, returns false on a miss.
+bool populate_cached_game_meta(file_handle *f, u16 headerSum) {
+	if(!metacache_get(f, f->meta, headerSum)) {
+		return false;
+	}
+	set_banner_display_name(f->meta);
+	meta_create_direct_texture(f->meta);
+	return true;
+}
+
 void populate_game_meta(file_handle *f, u32 bannerOffset, u32 bannerSize) {
 	f->meta->bannerSum = 0xFFFF;
 	f->meta->bannerSize = BNR_PIXELDATA_LEN;
@@ -182,13 +301,10 @@ void populate_game_meta(file_handle *f, u32 bannerOffset, u32 bannerSize) {
 					memcpy(&f->meta->bannerDesc, &banner->desc[SYS_LANG_ENGLISH], sizeof(f->meta->bannerDesc));
 			}
 			fixBannerDesc(f->meta->bannerDesc.gameName, BNR_SHORT_TEXT_LEN);
-			if(strnlen(f->meta->bannerDesc.gameName, BNR_SHORT_TEXT_LEN))
-				f->meta->displayName = f->meta->bannerDesc.gameName;
 			fixBannerDesc(f->meta->bannerDesc.company, BNR_SHORT_TEXT_LEN);
 			fixBannerDesc(f->meta->bannerDesc.fullGameName, BNR_FULL_TEXT_LEN);
-			if(strnlen(f->meta->bannerDesc.fullGameName, BNR_FULL_TEXT_LEN))
-				f->meta->displayName = f->meta->bannerDesc.fullGameName;
 			fixBannerDesc(f->meta->bannerDesc.fullCompany, BNR_FULL_TEXT_LEN);
+			set_banner_display_name(f->meta);
 			// Some banners only have empty spaces as padding until they hit a new line in the IPL
 			fixBannerDesc(f->meta->bannerDesc.description, BNR_DESC_LEN);
 			// ...and some banners have no CR/LF and we'd like a sane wrap point
@@ -209,7 +325,11 @@ void populate_game_meta(file_handle *f, u32 bannerOffset, u32 bannerSize) {
 
 void populate_meta(file_handle *f) {
 	// If the meta hasn't been created, lets read it.
-	if(!f->meta && (f->meta = meta_alloc())) {
+	if(f->meta) {
+		meta_touch(f);
+	}
+	else if((f->meta = meta_alloc())) {
+		meta_touch(f);
 		// File detection (GCM, DOL, MP3 etc)
 		if(f->fileAttrib==IS_FILE) {
 			if(devices[DEVICE_CUR] == &__device_wode && f->status == STATUS_NOT_MAPPED) {
@@ -279,10 +399,14 @@ void populate_meta(file_handle *f) {
 			else if(endsWith(f->name,".gcm") || endsWith(f->name,".iso")) {
 				DiskHeader *diskHeader = get_gcm_header(f);
 				if(diskHeader) {
-					u32 bannerOffset = 0, bannerSize = f->size;
-					if(!get_gcm_banner_fast(diskHeader, &bannerOffset, &bannerSize))
-						get_gcm_banner(f, &bannerOffset, &bannerSize);
-					populate_game_meta(f, bannerOffset, bannerSize);
+					u16 headerSum = fletcher16(diskHeader, sizeof(DiskHeader));
+					if(!populate_cached_game_meta(f, headerSum)) {
+						u32 bannerOffset = 0, bannerSize = f->size;
+						if(!get_gcm_banner_fast(diskHeader, &bannerOffset, &bannerSize))
+							get_gcm_banner(f, &bannerOffset, &bannerSize);
+						populate_game_meta(f, bannerOffset, bannerSize);
+						metacache_put(f, f->meta, headerSum);
+					}
 					get_gcm_title(diskHeader, f->meta);
 					// Assign GCM region texture
 					char region = wodeRegionToChar(diskHeader->RegionCode);
@@ -300,20 +424,34 @@ void populate_meta(file_handle *f) {
 				TGCHeader tgcHeader;
 				devices[DEVICE_CUR]->seekFile(f, 0, DEVICE_HANDLER_SEEK_SET);
 				if(devices[DEVICE_CUR]->readFile(f, &tgcHeader, sizeof(TGCHeader)) == sizeof(TGCHeader) && tgcHeader.magic == TGC_MAGIC) {
-					populate_game_meta(f, tgcHeader.bannerStart, tgcHeader.bannerLength);
+					u16 headerSum = fletcher16(&tgcHeader, sizeof(TGCHeader));
+					if(!populate_cached_game_meta(f, headerSum)) {
+						populate_game_meta(f, tgcHeader.bannerStart, tgcHeader.bannerLength);
+						metacache_put(f, f->meta, headerSum);
+					}
 				}
 			}
 			else if(endsWith(f->name,"/default.dol")) {
-				file_handle *bannerFile = calloc(1, sizeof(file_handle));
-				getParentPath(f->name, bannerFile->name);
-				concat_path(bannerFile->name, bannerFile->name, "opening.bnr");
-				bannerFile->meta = f->meta;
-				
-				if (devices[DEVICE_CUR]->readFile(bannerFile, NULL, 0) == 0 && bannerFile->size)
-					populate_game_meta(bannerFile, 0, bannerFile->size);
-				
-				devices[DEVICE_CUR]->closeFile(bannerFile);
-				free(bannerFile);
+				DOLHEADER dolHeader;
+				devices[DEVICE_CUR]->seekFile(f, 0, DEVICE_HANDLER_SEEK_SET);
+				// Without the header a replaced file can't be told apart, so the cache is left out
+				bool hasHeader = devices[DEVICE_CUR]->readFile(f, &dolHeader, sizeof(DOLHEADER)) == sizeof(DOLHEADER);
+				u16 headerSum = hasHeader ? fletcher16(&dolHeader, sizeof(DOLHEADER)) : 0;
+				if(!hasHeader || !populate_cached_game_meta(f, headerSum)) {
+					file_handle *bannerFile = calloc(1, sizeof(file_handle));
+					getParentPath(f->name, bannerFile->name);
+					concat_path(bannerFile->name, bannerFile->name, "opening.bnr");
+					bannerFile->meta = f->meta;
+					
+					if (devices[DEVICE_CUR]->readFile(bannerFile, NULL, 0) == 0 && bannerFile->size) {
+						populate_game_meta(bannerFile, 0, bannerFile->size);
+						if(hasHeader)
+							metacache_put(f, f->meta, headerSum);
+					}
+					
+					devices[DEVICE_CUR]->closeFile(bannerFile);
+					free(bannerFile);
+				}
 			}
 			if(endsWith(f->name,".dol"))
 				f->meta->fileTypeTexObj = &dolimgTexObj;
@@ -343,7 +481,7 @@ void populate_meta(file_handle *f) {
 				if (devices[DEVICE_CUR]->readFile(bootFile, NULL, 0) == 0 && bootFile->size) {
 					devices[DEVICE_CUR]->closeFile(bootFile);
 					
-					f = memcpy(f, bootFile, sizeof(file_handle));
+					copyFileHandle(f, bootFile);
 					f->meta->fileTypeTexObj = &dolimgTexObj;
 				}
 				devices[DEVICE_CUR]->closeFile(bootFile);
@@ -366,39 +504,50 @@ void repopulate_meta(file_handle *f) {
 	populate_meta(f);
 }
 
+// Populates the meta of an entry being drawn, it is kept until the view moves on.
+void populate_visible_meta(file_handle *f) {
+	populate_meta(f);
+	if(f->meta) {
+		LWP_MutexLock(meta_mutex);
+		meta_view_update();
+		f->meta->view = meta_view;
+		LWP_MutexUnlock(meta_mutex);
+	}
+}
+
 file_handle* meta_find_disc2(file_handle *f) {
 	file_handle* disc2File = NULL;
 	if(is_multi_disc(f->meta) && !(devices[DEVICE_CUR]->quirks & QUIRK_GCLOADER_NO_DISC_2)) {
-		file_handle* dirEntries = getCurrentDirEntries();
+		file_handle** dirEntries = getCurrentDirEntries()->entry;
 		int dirEntryCount = getCurrentDirEntryCount();
 		for(int i = 0; i < 2; i++) {
 			for(int j = 0; j < dirEntryCount; j++) {
-				if(!dirEntries[j].meta) {
+				if(!dirEntries[j]->meta) {
 					if(i == 0) continue;
-					populate_meta(&dirEntries[j]);
+					populate_meta(dirEntries[j]);
 				}
-				if(dirEntries[j].meta) {
-					if(strncmp((const char*)dirEntries[j].meta->diskId.gamename, (const char*)f->meta->diskId.gamename, 4)) {
+				if(dirEntries[j]->meta) {
+					if(strncmp((const char*)dirEntries[j]->meta->diskId.gamename, (const char*)f->meta->diskId.gamename, 4)) {
 						continue;
 					}
-					if(strncmp((const char*)dirEntries[j].meta->diskId.company, (const char*)f->meta->diskId.company, 2)) {
+					if(strncmp((const char*)dirEntries[j]->meta->diskId.company, (const char*)f->meta->diskId.company, 2)) {
 						continue;
 					}
-					if(dirEntries[j].meta->diskId.disknum == f->meta->diskId.disknum) {
+					if(dirEntries[j]->meta->diskId.disknum == f->meta->diskId.disknum) {
 						continue;
 					}
-					if(dirEntries[j].meta->diskId.gamever != f->meta->diskId.gamever) {
+					if(dirEntries[j]->meta->diskId.gamever != f->meta->diskId.gamever) {
 						continue;
 					}
-					if(strlen(dirEntries[j].name) != strlen(f->name)) {
-						disc2File = &dirEntries[j];
+					if(strlen(dirEntries[j]->name) != strlen(f->name)) {
+						disc2File = dirEntries[j];
 						continue;
 					}
-					if(strcasecmp(dirEntries[j].name, f->name) != dirEntries[j].meta->diskId.disknum - f->meta->diskId.disknum) {
-						disc2File = &dirEntries[j];
+					if(strcasecmp(dirEntries[j]->name, f->name) != dirEntries[j]->meta->diskId.disknum - f->meta->diskId.disknum) {
+						disc2File = dirEntries[j];
 						continue;
 					}
-					return &dirEntries[j];
+					return dirEntries[j];
 				}
 			}
 		}
@@ -406,28 +555,82 @@ file_handle* meta_find_disc2(file_handle *f) {
 	return disc2File;
 }
 
-static void *meta_thread_func(void *loadingBox) {
-	DrawUpdateProgressLoading(loadingBox, +1);
-	file_handle *dirEntries = getCurrentDirEntries();
-	int dirEntryCount = getCurrentDirEntryCount();
-	for (int i = 0; i < dirEntryCount; i++) {
-		if (meta_thread != LWP_GetSelf()) break;
-		if (trylockFile(&dirEntries[i])) {
-			populate_meta(&dirEntries[i]);
-			unlockFile(&dirEntries[i]);
+// Picks the next entry to populate, visible entries first then outwards from them.
+static file_handle* meta_queue_next() {
+	file_handle** dirEntries = getSortedDirEntries();
+	int dirEntryCount = getSortedDirEntryCount();
+	file_handle* f = NULL;
+	LWP_MutexLock(meta_mutex);
+	meta_view_update();
+	int visible = meta_view_end - meta_view_start;
+	while(!f) {
+		int i, pos = meta_queue_pos++;
+		if(pos < visible) {
+			i = meta_view_start + pos;
+		}
+		else {
+			pos -= visible;
+			if(meta_view_start - 1 - pos / 2 < 0 && meta_view_end + pos / 2 >= dirEntryCount) {
+				break;
+			}
+			i = (pos & 1) ? meta_view_start - 1 - pos / 2 : meta_view_end + pos / 2;
+		}
+		if(in_range(i, 0, dirEntryCount - 1) && !dirEntries[i]->meta) {
+			f = dirEntries[i];
+		}
+	}
+	LWP_MutexUnlock(meta_mutex);
+	return f;
+}
+
+static void *meta_thread_func(void *arg) {
+	int slot = (int)arg;
+	file_handle *f, *skipped[NUM_META_SKIPPED];
+	int numSkipped = 0;
+	DrawUpdateProgressLoading(meta_loading_box, +1);
+	while (!meta_threads_quit[slot]) {
+		if (!(f = meta_queue_next())) {
+			// Come back to entries that were locked when their turn came, once they're let go
+			if (!numSkipped) break;
+			f = skipped[--numSkipped];
+			if (!lockFileUntil(f, &meta_threads_quit[slot])) break;
+			if (!f->meta) populate_meta(f);
+			unlockFile(f);
+		}
+		else if (trylockFile(f)) {
+			populate_meta(f);
+			unlockFile(f);
+		}
+		else if (numSkipped < NUM_META_SKIPPED) {
+			skipped[numSkipped++] = f;
 		}
 	}
-	DrawUpdateProgressLoading(loadingBox, -1);
+	DrawUpdateProgressLoading(meta_loading_box, -1);
 	return NULL;
 }
 
 void meta_thread_start(void *loadingBox) {
-	if (devices[DEVICE_CUR]->features & FEAT_THREAD_SAFE)
-		LWP_CreateThread(&meta_thread, meta_thread_func, loadingBox, NULL, 16*1024, LWP_PRIO_NORMAL);
+	if (devices[DEVICE_CUR]->features & FEAT_THREAD_SAFE) {
+		LWP_MutexLock(meta_mutex);
+		meta_queue_pos = 0;
+		LWP_MutexUnlock(meta_mutex);
+		meta_loading_box = loadingBox;
+		for (int i = 0; i < NUM_META_THREADS; i++) {
+			meta_threads_quit[i] = false;
+			LWP_CreateThread(&meta_threads[i], meta_thread_func, (void*)i, NULL, 16*1024, LWP_PRIO_NORMAL);
+		}
+	}
 }
 
 void meta_thread_stop() {
-	lwp_t thread = meta_thread;
-	meta_thread = LWP_THREAD_NULL;
-	LWP_JoinThread(thread, NULL);
+	for (int i = 0; i < NUM_META_THREADS; i++)
+		meta_threads_quit[i] = true;
+	// Wake threads waiting on an entry someone else holds, which may be the caller
+	cancelLockFile();
+	for (int i = 0; i < NUM_META_THREADS; i++) {
+		if (meta_threads[i] != LWP_THREAD_NULL) {
+			LWP_JoinThread(meta_threads[i], NULL);
+			meta_threads[i] = LWP_THREAD_NULL;
+		}
+	}
 }
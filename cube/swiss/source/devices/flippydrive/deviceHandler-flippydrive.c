@@ -36,13 +36,8 @@ static void disable_speed_emu() {
 }
 
 file_handle initial_FlippyDrive =
-	{ "fldr:/", // directory
-	  0ULL,     // fileBase (u64)
-	  0,        // offset
-	  0,        // size
-	  IS_DIR,
-	  0,
-	  0
+	{ .name = "fldr:/",
+	  .fileAttrib = IS_DIR
 	};
 
 static device_info last_fat_info;
@@ -83,7 +78,7 @@ static uint32_t close_fd(uint32_t fd)
 	return lastStatus.result;
 }
 
-s32 deviceHandler_FlippyDrive_readDir(file_handle* file, file_handle** dir, u32 type) {
+s32 deviceHandler_FlippyDrive_readDir(file_handle* file, dir_list* dir, u32 type) {
 
 	//Open directory
 	int err = dvd_custom_open(getDevicePath(file->name), FILE_ENTRY_TYPE_DIR, IPC_FILE_FLAG_NONE);
@@ -103,61 +98,48 @@ s32 deviceHandler_FlippyDrive_readDir(file_handle* file, file_handle** dir, u32
 
 	uint_fast8_t dir_fd = lastStatus.fd;
 
-	//Allocate structures for reading
-	size_t entry_table_size = 1;
-	*dir = calloc(entry_table_size, sizeof(file_handle));
-	if(!dir)
+	//Setup parent dir
+	char name[PATHNAME_MAX];
+	concat_path(name, file->name, "..");
+	if(!addDirEntry(dir, name, IS_SPECIAL))
 	{
-		print_gecko("Unable to alloc dir array\n");
+		print_gecko("Unable to alloc dir entry\n");
 		close_fd(dir_fd);
 		return -1;
 	}
 
-	//Setup parent dir
-	concat_path((*dir)[0].name, file->name, "..");
-	(*dir)[0].fileAttrib = IS_SPECIAL;
-
-	int idx = 1;
 	GCN_ALIGNED(file_entry_t) curEntry;
-	while(idx < 4096) //Limit to a sane number of entries to avoid memory exhaustion
+	while(dir->num < 4096) //Limit to a sane number of entries to avoid memory exhaustion
 	{
 		err = dvd_custom_readdir(&curEntry, dir_fd);
 		if(err || curEntry.last_status)
 		{
 			print_gecko("error during readdir\n");
 			close_fd(dir_fd);
-			return idx;
+			return dir->num;
 		}
 
 		if(curEntry.name[0] == '\0') break; //End of entries
 
-		if(entry_table_size == idx) //Out of table entries
+		if (concat_path(name, file->name, curEntry.name) < PATHNAME_MAX)
 		{
-			entry_table_size *= 2; //Double size of table to avoid pathological n^2 reallocation
-			*dir = reallocarray(*dir, entry_table_size, sizeof(file_handle));
-			if (!dir)
+			s32 fileAttrib;
+			switch(curEntry.type)
 			{
-				print_gecko("Unable to alloc dir array\n");
-				close_fd(dir_fd);
-				return -1;
+				case FILE_ENTRY_TYPE_FILE: fileAttrib = IS_FILE; break;
+				case FILE_ENTRY_TYPE_DIR: fileAttrib = IS_DIR; break;
+				default: fileAttrib = IS_SPECIAL;
 			}
 
-			//Clear the new memory
-			memset(&(*dir)[entry_table_size / 2], 0, sizeof(file_handle) * (entry_table_size/2));
-		}
-
-		if (concat_path((*dir)[idx].name, file->name, curEntry.name) < PATHNAME_MAX)
-		{
-			(*dir)[idx].size = curEntry.size;
-			
-			switch(curEntry.type)
+			file_handle* entry = addDirEntry(dir, name, fileAttrib);
+			if(!entry)
 			{
-				case FILE_ENTRY_TYPE_FILE: (*dir)[idx].fileAttrib = IS_FILE; break;
-				case FILE_ENTRY_TYPE_DIR: (*dir)[idx].fileAttrib = IS_DIR; break;
-				default: (*dir)[idx].fileAttrib = IS_SPECIAL;
+				print_gecko("Unable to alloc dir entry\n");
+				close_fd(dir_fd);
+				freeDirList(dir);
+				return -1;
 			}
-
-			idx++;
+			entry->size = curEntry.size;
 		}
 		else
 		{
@@ -165,12 +147,12 @@ s32 deviceHandler_FlippyDrive_readDir(file_handle* file, file_handle** dir, u32
 		}
 	}
 
-	print_gecko("Read %i entries\n", idx);
+	print_gecko("Read %i entries\n", dir->num);
 
 	//Close directory (best effort)
 	close_fd(dir_fd);
 
-	return idx;
+	return dir->num;
 }
 
 s32 deviceHandler_FlippyDrive_makeDir(file_handle *file)
@@ -22,13 +22,8 @@ extern int net_initialized;
 static FSP_SESSION *fsp_session;
 
 file_handle initial_FSP =
-	{ "fsp:/",      // directory
-	  0ULL,     // fileBase (u64)
-	  0,        // offset
-	  0,        // size
-	  IS_DIR,
-	  0,
-	  0
+	{ .name = "fsp:/",
+	  .fileAttrib = IS_DIR
 	};
 
 device_info initial_FSP_info = {
@@ -41,18 +36,17 @@ device_info* deviceHandler_FSP_info(file_handle* file) {
 	return &initial_FSP_info;
 }
 
-s32 deviceHandler_FSP_readDir(file_handle* ffile, file_handle** dir, u32 type) {
+s32 deviceHandler_FSP_readDir(file_handle* ffile, dir_list* dir, u32 type) {
 
 	FSP_DIR* dp = fsp_opendir(fsp_session, getDevicePath(ffile->name));
 	if(!dp) return -1;
 	FSP_RDENTRY entry;
 	FSP_RDENTRY *result;
+	char name[PATHNAME_MAX];
 	
 	// Set everything up to read
-	int num_entries = 1, i = 1;
-	*dir = calloc(num_entries, sizeof(file_handle));
-	concat_path((*dir)[0].name, ffile->name, "..");
-	(*dir)[0].fileAttrib = IS_SPECIAL;
+	concat_path(name, ffile->name, "..");
+	if(!addDirEntry(dir, name, IS_SPECIAL)) goto fail;
 	
 	u64 usedSpace = 0LL;
 	// Read each entry of the directory
@@ -65,23 +59,22 @@ s32 deviceHandler_FSP_readDir(file_handle* ffile, file_handle** dir, u32 type) {
 			if(entry.type == FSP_RDTYPE_FILE) {
 				if(!checkExtension(entry.name)) continue;
 			}
-			// Make sure we have room for this one
-			if(i == num_entries){
-				++num_entries;
-				*dir = reallocarray(*dir, num_entries, sizeof(file_handle));
-			}
-			memset(&(*dir)[i], 0, sizeof(file_handle));
-			if(concat_path((*dir)[i].name, ffile->name, entry.name) < PATHNAME_MAX) {
-				(*dir)[i].size       = entry.size;
-				(*dir)[i].fileAttrib = (entry.type == FSP_RDTYPE_DIR) ? IS_DIR : IS_FILE;
-				usedSpace += (*dir)[i].size;
-				++i;
+			if(concat_path(name, ffile->name, entry.name) < PATHNAME_MAX) {
+				file_handle* file = addDirEntry(dir, name, (entry.type == FSP_RDTYPE_DIR) ? IS_DIR : IS_FILE);
+				if(!file) goto fail;
+				file->size = entry.size;
+				usedSpace += file->size;
 			}
 		}
 	}
 	initial_FSP_info.totalSpace = usedSpace;
 	fsp_closedir(dp);
-	return i;
+	return dir->num;
+
+fail:
+	fsp_closedir(dp);
+	freeDirList(dir);
+	return -1;
 }
 
 s64 deviceHandler_FSP_seekFile(file_handle* file, s64 where, u32 type) {
@@ -24,13 +24,8 @@ char *gcloaderVersionStr;
 static FATFS *gcloaderfs = NULL;
 
 file_handle initial_GCLoader =
-	{ "gcldr:/",       // directory
-	  0ULL,     // fileBase (u64)
-	  0,        // offset
-	  0,        // size
-	  IS_DIR,
-	  0,
-	  0
+	{ .name = "gcldr:/",
+	  .fileAttrib = IS_DIR
 	};
 
 s32 deviceHandler_GCLoader_readFile(file_handle* file, void* buffer, u32 length) {
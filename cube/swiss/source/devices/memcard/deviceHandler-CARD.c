@@ -19,22 +19,14 @@
 
 
 file_handle initial_CARDA =
-	{ "carda:/",       // directory
-	  0,
-	  0,          // offset
-	  0,          // size
-	  IS_DIR,
-	  0
-};
+	{ .name = "carda:/",
+	  .fileAttrib = IS_DIR
+	};
 
 file_handle initial_CARDB =
-	{ "cardb:/",       // directory
-	  0	,
-	  0,          // offset
-	  0,          // size
-	  IS_DIR,
-	  0
-};
+	{ .name = "cardb:/",
+	  .fileAttrib = IS_DIR
+	};
 
 static device_info initial_CARD_info[2];
 
@@ -99,10 +91,11 @@ device_info* deviceHandler_CARD_info(file_handle* file) {
 	return &initial_CARD_info[slot];
 }
 
-s32 deviceHandler_CARD_readDir(file_handle* ffile, file_handle** dir, u32 type){	
+s32 deviceHandler_CARD_readDir(file_handle* ffile, dir_list* dir, u32 type){	
 
-	int num_entries = 1, ret = 0, i = 1, slot = (!strncmp((const char*)initial_CARDB.name, ffile->name, 7));
+	int ret = 0, slot = (!strncmp((const char*)initial_CARDB.name, ffile->name, 7));
 	card_dir *memcard_dir = NULL;
+	char name[PATHNAME_MAX];
   
 	if(!card_init[slot]) { //if some error
 		ret = initialize_card(slot);
@@ -116,33 +109,31 @@ s32 deviceHandler_CARD_readDir(file_handle* ffile, file_handle** dir, u32 type){
 	memset(memcard_dir, 0, sizeof(card_dir));
  	
 	/* Convert the Memory Card "file" data to fileBrowser_files */
-	*dir = calloc(num_entries, sizeof(file_handle));
-	concat_path((*dir)[0].name, ffile->name, "..");
-	(*dir)[0].fileAttrib = IS_SPECIAL;
+	concat_path(name, ffile->name, "..");
+	if(!addDirEntry(dir, name, IS_SPECIAL)) goto fail;
 
 	int usedSpace = 0;
 	ret = CARD_FindFirst (slot, memcard_dir, true);
 	while (CARD_ERROR_NOFILE != ret) {
-		// Make sure we have room for this one
-		if(i == num_entries){
-			++num_entries;
-			*dir = reallocarray(*dir, num_entries, sizeof(file_handle));
-		}
-		memset(&(*dir)[i], 0, sizeof(file_handle));
-		concatf_path((*dir)[i].name, ffile->name, "%.*s", CARD_FILENAMELEN, memcard_dir->filename);
-		(*dir)[i].fileBase   = memcard_dir->fileno;
-		(*dir)[i].size       = memcard_dir->filelen;
-		(*dir)[i].fileAttrib = IS_FILE;
-		memcpy( (*dir)[i].other, memcard_dir, sizeof(card_dir));
-		usedSpace += (*dir)[i].size;
+		concatf_path(name, ffile->name, "%.*s", CARD_FILENAMELEN, memcard_dir->filename);
+		file_handle* file = addDirEntry(dir, name, IS_FILE);
+		if(!file) goto fail;
+		file->fileBase   = memcard_dir->fileno;
+		file->size       = memcard_dir->filelen;
+		memcpy( file->other, memcard_dir, sizeof(card_dir));
+		usedSpace += file->size;
 		ret = CARD_FindNext (memcard_dir);
-		++i;
 	}
 	free(memcard_dir);
 	
 	initial_CARD_info[slot].freeSpace = initial_CARD_info[slot].totalSpace - usedSpace;
 
-	return i;
+	return dir->num;
+
+fail:
+	free(memcard_dir);
+	freeDirList(dir);
+	return -1;
 }
 
 // Finds a file based on file->name and populates file->size if found.
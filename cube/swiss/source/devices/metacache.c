@@ -0,0 +1,298 @@
+/* metacache.c
+	- persistent file meta cache
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <ogc/lwp.h>
+#include <xxhash.h>
+#include <zlib.h>
+#include "swiss.h"
+#include "files.h"
+#include "config.h"
+#include "metacache.h"
+
+// One database file per browsed directory, kept on the config device and named
+// after the hash of the browsed device and the directory's path.
+#define META_CACHE_DIR "swiss/cache"
+#define META_CACHE_MAGIC 0x534D4332 // 'SMC2'
+#define META_CACHE_MAX_ENTRIES 4096
+
+typedef struct {
+	u32 magic;
+	u32 count;
+} meta_cache_hdr;
+
+// The payload is a deflated BNRDesc and banner pixel data. headerSum covers
+// the header at the start of the file, so a replaced file of the same size misses.
+typedef struct {
+	u64 pathHash;
+	u32 size;
+	u16 bannerSum;
+	u16 headerSum;
+	u32 dataLen;
+	u8 data[];
+} meta_cache_entry;
+
+typedef struct {
+	BNRDesc bannerDesc;
+	u8 pixelData[BNR_PIXELDATA_LEN];
+} meta_cache_payload;
+
+#define META_CACHE_ENTRY_SIZE(e) (sizeof(meta_cache_entry) + (((e)->dataLen + 7) & ~7))
+
+// Databases with new records stay in memory until metacache_flush.
+typedef struct meta_cache_dir {
+	struct meta_cache_dir *next;
+	char name[64];
+	u8 *buffer;
+	u32 bufferSize;
+	meta_cache_entry **entries;
+	int count;
+	int capacity;
+	bool dirty;
+} meta_cache_dir;
+
+static mutex_t cache_mutex = LWP_MUTEX_NULL;
+static meta_cache_dir *cache_dirs = NULL;
+static meta_cache_dir *cache_dir = NULL;
+
+__attribute((constructor))
+static void initMutex(void)
+{
+	LWP_MutexInit(&cache_mutex, false);
+}
+
+static bool in_buffer(meta_cache_dir *dir, meta_cache_entry *entry) {
+	return (u8*)entry >= dir->buffer && (u8*)entry < dir->buffer + dir->bufferSize;
+}
+
+static void metacache_free(meta_cache_dir *dir) {
+	for(int i = 0; i < dir->count; i++) {
+		if(!in_buffer(dir, dir->entries[i])) {
+			free(dir->entries[i]);
+		}
+	}
+	free(dir->entries);
+	free(dir->buffer);
+	free(dir);
+}
+
+static void metacache_reset() {
+	while(cache_dirs) {
+		meta_cache_dir *dir = cache_dirs;
+		cache_dirs = dir->next;
+		metacache_free(dir);
+	}
+	cache_dir = NULL;
+}
+
+static bool metacache_add(meta_cache_dir *dir, meta_cache_entry *entry) {
+	if(dir->count == dir->capacity) {
+		int capacity = dir->capacity ? dir->capacity * 2 : 64;
+		meta_cache_entry **entries = reallocarray(dir->entries, capacity, sizeof(meta_cache_entry*));
+		if(!entries) return false;
+		dir->entries = entries;
+		dir->capacity = capacity;
+	}
+	dir->entries[dir->count++] = entry;
+	return true;
+}
+
+static meta_cache_entry *metacache_find(meta_cache_dir *dir, u64 pathHash) {
+	// Newer entries supersede older ones for the same path
+	for(int i = dir->count - 1; i >= 0; i--) {
+		if(dir->entries[i]->pathHash == pathHash) {
+			return dir->entries[i];
+		}
+	}
+	return NULL;
+}
+
+// Reads the database for a directory in one go, mounting the config device if it isn't
+// the one being browsed. A database that can't be read starts out empty.
+static meta_cache_dir *metacache_read(const char *name) {
+	meta_cache_dir *dir = calloc(1, sizeof(meta_cache_dir));
+	if(!dir) return NULL;
+	strlcpy(dir->name, name, sizeof(dir->name));
+
+	if(config_set_device()) {
+		file_handle *cacheFile = calloc(1, sizeof(file_handle));
+		concat_path(cacheFile->name, devices[DEVICE_CONFIG]->initial->name, dir->name);
+		if(devices[DEVICE_CONFIG]->readFile(cacheFile, NULL, 0) == 0 && cacheFile->size >= sizeof(meta_cache_hdr)) {
+			dir->buffer = memalign(32, cacheFile->size);
+			if(dir->buffer) {
+				if(devices[DEVICE_CONFIG]->readFile(cacheFile, dir->buffer, cacheFile->size) == cacheFile->size) {
+					dir->bufferSize = cacheFile->size;
+				}
+			}
+		}
+		devices[DEVICE_CONFIG]->closeFile(cacheFile);
+		free(cacheFile);
+		config_unset_device();
+	}
+
+	meta_cache_hdr *hdr = (meta_cache_hdr*)dir->buffer;
+	if(dir->bufferSize && hdr->magic == META_CACHE_MAGIC) {
+		u32 offset = sizeof(meta_cache_hdr);
+		for(int i = 0; i < hdr->count; i++) {
+			meta_cache_entry *entry = (meta_cache_entry*)(dir->buffer + offset);
+			if(offset + sizeof(meta_cache_entry) > dir->bufferSize
+			|| offset + META_CACHE_ENTRY_SIZE(entry) > dir->bufferSize
+			|| !metacache_add(dir, entry)) {
+				break;
+			}
+			offset += META_CACHE_ENTRY_SIZE(entry);
+		}
+	}
+	return dir;
+}
+
+// Writes a database back out, skipping superseded entries and capping it to the most recent ones.
+static void metacache_write(meta_cache_dir *dir) {
+	u32 size = sizeof(meta_cache_hdr), count = 0;
+	for(int i = dir->count - 1; i >= 0 && count < META_CACHE_MAX_ENTRIES; i--) {
+		if(metacache_find(dir, dir->entries[i]->pathHash) == dir->entries[i]) {
+			size += META_CACHE_ENTRY_SIZE(dir->entries[i]);
+			count++;
+		}
+	}
+	u8 *buffer = memalign(32, size);
+	if(!buffer) return;
+
+	meta_cache_hdr *hdr = (meta_cache_hdr*)buffer;
+	hdr->magic = META_CACHE_MAGIC;
+	hdr->count = 0;
+	u32 offset = sizeof(meta_cache_hdr);
+	for(int i = dir->count - 1; i >= 0 && hdr->count < count; i--) {
+		if(metacache_find(dir, dir->entries[i]->pathHash) == dir->entries[i]) {
+			memcpy(buffer + offset, dir->entries[i], META_CACHE_ENTRY_SIZE(dir->entries[i]));
+			offset += META_CACHE_ENTRY_SIZE(dir->entries[i]);
+			hdr->count++;
+		}
+	}
+
+	file_handle *cacheFile = calloc(1, sizeof(file_handle));
+	concat_path(cacheFile->name, devices[DEVICE_CONFIG]->initial->name, dir->name);
+	devices[DEVICE_CONFIG]->deleteFile(cacheFile);
+	devices[DEVICE_CONFIG]->writeFile(cacheFile, buffer, offset);
+	devices[DEVICE_CONFIG]->closeFile(cacheFile);
+	free(cacheFile);
+	free(buffer);
+}
+
+// Selects the database for a directory, reading it on the first visit this session.
+// Any device can be browsed with the cache, as long as there is a config device to keep it on.
+void metacache_load(file_handle *dir) {
+	LWP_MutexLock(cache_mutex);
+	cache_dir = NULL;
+	if(devices[DEVICE_CONFIG] == NULL) {
+		LWP_MutexUnlock(cache_mutex);
+		return;
+	}
+	// Paths alone can repeat across devices, such as the root of each
+	char name[64];
+	snprintf(name, sizeof(name), META_CACHE_DIR "/%016llX.bin",
+		XXH3_64bits_withSeed(dir->name, strlen(dir->name), devices[DEVICE_CUR]->deviceUniqueId));
+
+	// Databases with nothing new to write are dropped once left
+	for(meta_cache_dir **prev = &cache_dirs; *prev; ) {
+		meta_cache_dir *cached = *prev;
+		if(!strcmp(cached->name, name)) {
+			cache_dir = cached;
+		}
+		else if(!cached->dirty) {
+			*prev = cached->next;
+			metacache_free(cached);
+			continue;
+		}
+		prev = &cached->next;
+	}
+	if(!cache_dir && (cache_dir = metacache_read(name))) {
+		cache_dir->next = cache_dirs;
+		cache_dirs = cache_dir;
+	}
+	LWP_MutexUnlock(cache_mutex);
+}
+
+// Writes out every database that had records added, then drops them all.
+// Called when leaving the device or Swiss, not on every directory change.
+void metacache_flush() {
+	LWP_MutexLock(cache_mutex);
+	meta_cache_dir *dir = cache_dirs;
+	while(dir && !dir->dirty) {
+		dir = dir->next;
+	}
+	if(dir && config_set_device()) {
+		ensure_path(DEVICE_CONFIG, "swiss", NULL);
+		ensure_path(DEVICE_CONFIG, META_CACHE_DIR, NULL);
+		for(; dir; dir = dir->next) {
+			if(dir->dirty) {
+				metacache_write(dir);
+			}
+		}
+		config_unset_device();
+	}
+	metacache_reset();
+	LWP_MutexUnlock(cache_mutex);
+}
+
+// Fills out the banner and its description from the cache, returns false on a miss.
+// headerSum is the fletcher16 of the file's header, read fresh by the caller.
+bool metacache_get(file_handle *f, file_meta *meta, u16 headerSum) {
+	bool hit = false;
+	LWP_MutexLock(cache_mutex);
+	if(cache_dir) {
+		meta_cache_entry *entry = metacache_find(cache_dir, XXH3_64bits(f->name, strlen(f->name)));
+		if(entry && entry->size == f->size && entry->headerSum == headerSum) {
+			meta_cache_payload *payload = memalign(32, sizeof(meta_cache_payload));
+			uLongf payloadLen = sizeof(meta_cache_payload);
+			if(payload && uncompress((Bytef*)payload, &payloadLen, entry->data, entry->dataLen) == Z_OK) {
+				hit = payloadLen == sizeof(meta_cache_payload);
+			}
+			if(hit) {
+				meta->bannerSum = entry->bannerSum;
+				meta->bannerSize = BNR_PIXELDATA_LEN;
+				meta->banner = memalign(32, BNR_PIXELDATA_LEN);
+				memcpy(meta->banner, payload->pixelData, BNR_PIXELDATA_LEN);
+				memcpy(&meta->bannerDesc, &payload->bannerDesc, sizeof(BNRDesc));
+			}
+			free(payload);
+		}
+	}
+	LWP_MutexUnlock(cache_mutex);
+	return hit;
+}
+
+// Records freshly populated meta so that the next visit needs only a header read.
+void metacache_put(file_handle *f, file_meta *meta, u16 headerSum) {
+	if(!meta->banner || meta->bannerSize != BNR_PIXELDATA_LEN) {
+		return;
+	}
+	LWP_MutexLock(cache_mutex);
+	if(cache_dir) {
+		meta_cache_payload *payload = memalign(32, sizeof(meta_cache_payload));
+		if(payload) {
+			memcpy(&payload->bannerDesc, &meta->bannerDesc, sizeof(BNRDesc));
+			memcpy(payload->pixelData, meta->banner, BNR_PIXELDATA_LEN);
+			uLongf dataLen = compressBound(sizeof(meta_cache_payload));
+			meta_cache_entry *entry = malloc(sizeof(meta_cache_entry) + ((dataLen + 7) & ~7));
+			if(entry && compress2(entry->data, &dataLen, (Bytef*)payload, sizeof(meta_cache_payload), Z_BEST_SPEED) == Z_OK) {
+				entry->pathHash = XXH3_64bits(f->name, strlen(f->name));
+				entry->size = f->size;
+				entry->bannerSum = meta->bannerSum;
+				entry->headerSum = headerSum;
+				entry->dataLen = dataLen;
+				if(metacache_add(cache_dir, entry)) {
+					cache_dir->dirty = true;
+					entry = NULL;
+				}
+			}
+			free(entry);
+			free(payload);
+		}
+	}
+	LWP_MutexUnlock(cache_mutex);
+}
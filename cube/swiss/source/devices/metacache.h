@@ -0,0 +1,15 @@
+/* metacache.h
+	- persistent file meta cache
+ */
+
+#ifndef METACACHE_H
+#define METACACHE_H
+
+#include <stdbool.h>
+#include "deviceHandler.h"
+
+void metacache_load(file_handle *dir);
+void metacache_flush();
+bool metacache_get(file_handle *f, file_meta *meta, u16 headerSum);
+void metacache_put(file_handle *f, file_meta *meta, u16 headerSum);
+#endif
@@ -40,12 +40,8 @@ struct qoobEntryHeader {
 char iplBlock[256] __attribute__((aligned(32)));
 
 file_handle initial_Qoob =
-	{ "qoob:/",       // directory
-	  0ULL,     // fileBase (u64)
-	  0,        // offset
-	  0,        // size
-	  IS_DIR,
-	  0
+	{ .name = "qoob:/",
+	  .fileAttrib = IS_DIR
 	};
 	
 device_info initial_Qoob_info = {
@@ -83,14 +79,14 @@ char *getQoobExtension(qoobEntryHeader* entryHeader) {
 	}
 }
 	
-s32 deviceHandler_Qoob_readDir(file_handle* ffile, file_handle** dir, u32 type) {	
+s32 deviceHandler_Qoob_readDir(file_handle* ffile, dir_list* dir, u32 type) {	
   
 	uiDrawObj_t *msgBox = DrawPublish(DrawProgressBar(true, 0, "Reading Qoob"));
 	// Set everything up to read
-	int num_entries = 1, i = 1, block = 0;
-	*dir = calloc(num_entries, sizeof(file_handle));
-	concat_path((*dir)[0].name, ffile->name, "..");
-	(*dir)[0].fileAttrib = IS_SPECIAL;
+	int block = 0;
+	char name[PATHNAME_MAX];
+	concat_path(name, ffile->name, "..");
+	if(!addDirEntry(dir, name, IS_SPECIAL)) goto fail;
 	
 	u32 usedSpace = 0;
 	
@@ -112,12 +108,6 @@ s32 deviceHandler_Qoob_readDir(file_handle* ffile, file_handle** dir, u32 type)
 			case QOOB_FILE_DOL:	
 			case QOOB_FILE_SWIS:
 			{
-				// Make sure we have room for this one
-				if(i == num_entries){
-					++num_entries;
-					*dir = reallocarray(*dir, num_entries, sizeof(file_handle));
-				}
-				memset(&(*dir)[i], 0, sizeof(file_handle));
 				memset(entryName, 0, 128);
 				
 				// The windows flasher puts .dol files as "ELF" type, support this case.
@@ -147,12 +137,12 @@ s32 deviceHandler_Qoob_readDir(file_handle* ffile, file_handle** dir, u32 type)
 						snprintf(&entryName[0], 64, "%s", entryHeader.entry_name);
 					}
 				}
-				concat_path((*dir)[i].name, ffile->name, entryName);
-				(*dir)[i].fileBase   = block;
-				(*dir)[i].size       = entryHeader.num_blocks * QOOB_BLOCK_SIZE;
-				(*dir)[i].fileAttrib = IS_FILE;
-				usedSpace += (*dir)[i].size;
-				++i;
+				concat_path(name, ffile->name, entryName);
+				file_handle* file = addDirEntry(dir, name, IS_FILE);
+				if(!file) goto fail;
+				file->fileBase   = block;
+				file->size       = entryHeader.num_blocks * QOOB_BLOCK_SIZE;
+				usedSpace += file->size;
 				
 				print_gecko("Found [%08X] entry, %08X in size\r\n", entryHeader.entry_type, entryHeader.num_blocks);
 				block += (entryHeader.num_blocks * QOOB_BLOCK_SIZE);
@@ -166,7 +156,12 @@ s32 deviceHandler_Qoob_readDir(file_handle* ffile, file_handle** dir, u32 type)
 	}
 	initial_Qoob_info.freeSpace = initial_Qoob_info.totalSpace - usedSpace;
 	DrawDispose(msgBox);
-	return i;
+	return dir->num;
+
+fail:
+	DrawDispose(msgBox);
+	freeDirList(dir);
+	return -1;
 }
 
 s64 deviceHandler_Qoob_seekFile(file_handle* file, s64 where, u32 type) {
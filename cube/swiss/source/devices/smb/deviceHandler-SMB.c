@@ -45,13 +45,8 @@ extern int net_initialized;
 int smb_initialized = 0;
 
 file_handle initial_SMB =
-	{ "smb:/", // file name
-	  0ULL,      // discoffset (u64)
-	  0,         // offset
-	  0,         // size
-	  IS_DIR,
-	  0,
-	  0
+	{ .name = "smb:/",
+	  .fileAttrib = IS_DIR
 	};
 
 device_info initial_SMB_info = {
@@ -92,7 +87,7 @@ void init_samba() {
 	}
 }
 
-s32 deviceHandler_SMB_readDir(file_handle* ffile, file_handle** dir, u32 type){	
+s32 deviceHandler_SMB_readDir(file_handle* ffile, dir_list* dir, u32 type){	
    	
 	DIR* dp = opendir( ffile->name );
 	if(!dp) return -1;
@@ -102,12 +97,11 @@ s32 deviceHandler_SMB_readDir(file_handle* ffile, file_handle** dir, u32 type){
 	#else
 	struct stat fstat;
 	#endif
+	char name[PATHNAME_MAX];
 	
 	// Set everything up to read
-	int num_entries = 1, i = 1;
-	*dir = calloc(num_entries, sizeof(file_handle));
-	concat_path((*dir)[0].name, ffile->name, "..");
-	(*dir)[0].fileAttrib = IS_SPECIAL;
+	concat_path(name, ffile->name, "..");
+	if(!addDirEntry(dir, name, IS_SPECIAL)) goto fail;
 	
 	// Read each entry of the directory
 	do {
@@ -121,27 +115,26 @@ s32 deviceHandler_SMB_readDir(file_handle* ffile, file_handle** dir, u32 type){
 			if(entry->d_type == DT_REG) {
 				if(!checkExtension(entry->d_name)) continue;
 			}
-			// Make sure we have room for this one
-			if(i == num_entries){
-				++num_entries;
-				*dir = reallocarray(*dir, num_entries, sizeof(file_handle));
-			}
-			memset(&(*dir)[i], 0, sizeof(file_handle));
-			if(concat_path((*dir)[i].name, ffile->name, entry->d_name) < PATHNAME_MAX
+			if(concat_path(name, ffile->name, entry->d_name) < PATHNAME_MAX
 				#ifndef _DIRENT_HAVE_D_STAT
-				&& !stat((*dir)[i].name, &fstat)
+				&& !stat(name, &fstat)
 				#endif
 				&& fstat.st_size <= UINT32_MAX) {
-				(*dir)[i].size       = fstat.st_size;
-				(*dir)[i].fileAttrib = S_ISDIR(fstat.st_mode) ? IS_DIR : IS_FILE;
-				++i;
+				file_handle* file = addDirEntry(dir, name, S_ISDIR(fstat.st_mode) ? IS_DIR : IS_FILE);
+				if(!file) goto fail;
+				file->size = fstat.st_size;
 			}
 		}
 	} while(entry || errno == EOVERFLOW);
 	
 	#undef fstat
 	closedir(dp);
-	return i;
+	return dir->num;
+
+fail:
+	closedir(dp);
+	freeDirList(dir);
+	return -1;
 }
 
 s64 deviceHandler_SMB_seekFile(file_handle* file, s64 where, u32 type){
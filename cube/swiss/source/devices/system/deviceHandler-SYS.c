@@ -11,6 +11,7 @@
 #include "dvd.h"
 #include "files.h"
 #include "gui/FrameBufferMagic.h"
+#include "aram/sidestep.h"
 
 s32 read_rom_ipl(file_handle* file, void* buffer, u32 length);
 s32 read_rom_ipl_clear(file_handle* file, void* buffer, u32 length);
@@ -128,16 +129,9 @@ static s32 (*write_rom[])(file_handle* file, const void* buffer, u32 length) =
 };
 
 file_handle initial_SYS =
-{
-	"sys:/",
-	0ULL,
-	0,
-	0,
-	IS_DIR,
-	0,
-	0,
-	NULL
-};
+	{ .name = "sys:/",
+	  .fileAttrib = IS_DIR
+	};
 
 device_info initial_SYS_info =
 {
@@ -150,60 +144,70 @@ device_info* deviceHandler_SYS_info(file_handle* file) {
 	return &initial_SYS_info;
 }
 
-static void descrambler(unsigned int offset, void* buffer, unsigned int length) {
+typedef struct {
+	unsigned int pos;
+	unsigned short t, u, v;
+	unsigned char x;
+} descrambler_state;
+
+static unsigned char descrambler_next(descrambler_state* s) {
 	// bootrom descrambler reversed by segher
 	// Copyright 2008 Segher Boessenkool <segher@kernel.crashing.org>
 
-	unsigned char* data = buffer;
-	unsigned int descrambled_length = 0x100;
-
 	unsigned char acc = 0;
-	unsigned char nacc = 0;
-
-	unsigned short t = 0x2953;
-	unsigned short u = 0xd9c2;
-	unsigned short v = 0x3ff1;
-
-	unsigned char x = 1;
-	unsigned int it = offset < 0x100 ? 0x100 - offset : 0;
+	int i;
 
-	while (it < length) {
-		int t0 = t & 1;
-		int t1 = (t >> 1) & 1;
-		int u0 = u & 1;
-		int u1 = (u >> 1) & 1;
-		int v0 = v & 1;
+	for (i = 0; i < 8; i++) {
+		int t0 = s->t & 1;
+		int t1 = (s->t >> 1) & 1;
+		int u0 = s->u & 1;
+		int u1 = (s->u >> 1) & 1;
+		int v0 = s->v & 1;
 
-		x ^= t1 ^ v0;
-		x ^= (u0 | u1);
-		x ^= (t0 ^ u1 ^ v0) & (t0 ^ u0);
+		s->x ^= t1 ^ v0;
+		s->x ^= (u0 | u1);
+		s->x ^= (t0 ^ u1 ^ v0) & (t0 ^ u0);
 
 		if (t0 == u0) {
-			v >>= 1;
+			s->v >>= 1;
 			if (v0)
-				v ^= 0xb3d0;
+				s->v ^= 0xb3d0;
 		}
 
 		if (t0 == 0) {
-			u >>= 1;
+			s->u >>= 1;
 			if (u0)
-				u ^= 0xfb10;
+				s->u ^= 0xfb10;
 		}
 
-		t >>= 1;
+		s->t >>= 1;
 		if (t0)
-			t ^= 0xa740;
-
-		nacc++;
-		acc = 2*acc + x;
-		if (nacc == 8) {
-			if (descrambled_length >= 0x1aff00)
-				it++;
-			else if (descrambled_length >= offset)
-				data[it++] ^= acc;
-			descrambled_length++;
-			nacc = 0;
-		}
+			s->t ^= 0xa740;
+
+		acc = 2*acc + s->x;
+	}
+
+	s->pos++;
+	return acc;
+}
+
+static void descrambler(unsigned int offset, void* buffer, unsigned int length) {
+	static const descrambler_state initial = { 0x100, 0x2953, 0xd9c2, 0x3ff1, 1 };
+	static descrambler_state state = { 0x100, 0x2953, 0xd9c2, 0x3ff1, 1 };
+
+	unsigned char* data = buffer;
+	unsigned int start = offset < 0x100 ? 0x100 : offset;
+	unsigned int end = offset + length < 0x1aff00 ? offset + length : 0x1aff00;
+
+	// The keystream only runs forwards, so sequential reads pick up where the last one ended
+	if (state.pos > start)
+		state = initial;
+
+	while (state.pos < end) {
+		unsigned int pos = state.pos;
+		unsigned char acc = descrambler_next(&state);
+		if (pos >= start)
+			data[pos - offset] ^= acc;
 	}
 }
 
@@ -379,6 +383,9 @@ bool is_rom_name(char* filename) {
 s32 deviceHandler_SYS_init(file_handle* file) {
 	s32 i;
 
+	// A wiiload transfer is staging into ARAM
+	if(ARAMStageActive()) return EBUSY;
+
 	if(!AR_CheckInit()) {
 		AR_Init(NULL, 0);
 		AR_Reset();
@@ -399,20 +406,24 @@ s32 deviceHandler_SYS_init(file_handle* file) {
 	return 0;
 }
 
-s32 deviceHandler_SYS_readDir(file_handle* ffile, file_handle** dir, u32 type) {
-	int num_entries = NUM_ROMS, i = ROM_VOID;
-	*dir = calloc(num_entries, sizeof(file_handle));
-	concat_path((*dir)[i].name, ffile->name, "..");
-	(*dir)[i].fileAttrib = IS_SPECIAL;
-
-	for(i = ROM_IPL; i < NUM_ROMS; i++) {
-		concat_path((*dir)[i].name, ffile->name, rom_names[i]);
-		(*dir)[i].fileBase   = i;
-		(*dir)[i].size       = rom_sizes[i];
-		(*dir)[i].fileAttrib = IS_FILE;
+s32 deviceHandler_SYS_readDir(file_handle* ffile, dir_list* dir, u32 type) {
+	char name[PATHNAME_MAX];
+	concat_path(name, ffile->name, "..");
+	if(!addDirEntry(dir, name, IS_SPECIAL)) goto fail;
+
+	for(int i = ROM_IPL; i < NUM_ROMS; i++) {
+		concat_path(name, ffile->name, rom_names[i]);
+		file_handle* file = addDirEntry(dir, name, IS_FILE);
+		if(!file) goto fail;
+		file->fileBase   = i;
+		file->size       = rom_sizes[i];
 	}
 
-	return num_entries;
+	return dir->num;
+
+fail:
+	freeDirList(dir);
+	return -1;
 }
 
 s64 deviceHandler_SYS_seekFile(file_handle* file, s64 where, u32 type) {
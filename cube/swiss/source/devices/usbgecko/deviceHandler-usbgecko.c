@@ -19,13 +19,8 @@
 #define NO_PC (-1)
 
 file_handle initial_USBGecko =
-	{ "./",     // directory
-	  0ULL,     // fileBase (u64)
-	  0,        // offset
-	  0,        // size
-	  IS_DIR,
-	  0,
-	  0
+	{ .name = "./",
+	  .fileAttrib = IS_DIR
 	};
 
 device_info initial_USBGecko_info = {
@@ -38,40 +33,36 @@ device_info* deviceHandler_USBGecko_info(file_handle* file) {
 	return &initial_USBGecko_info;
 }
 	
-s32 deviceHandler_USBGecko_readDir(file_handle* ffile, file_handle** dir, u32 type){	
+s32 deviceHandler_USBGecko_readDir(file_handle* ffile, dir_list* dir, u32 type){	
   
 	// Set everything up to read
-	s32 num_entries = 1, i = 1;
 	file_handle *entry = NULL;
-	*dir = calloc(num_entries, sizeof(file_handle));
-	concat_path((*dir)[0].name, ffile->name, "..");
-	(*dir)[0].fileAttrib = IS_SPECIAL;
+	char name[PATHNAME_MAX];
+	concat_path(name, ffile->name, "..");
+	if(!addDirEntry(dir, name, IS_SPECIAL)) return -1;
 	
 	uiDrawObj_t *msgBox = DrawPublish(DrawProgressBar(true, 0, "Reading directory"));
 	// Read each entry of the directory
 	s32 res = usbgecko_open_dir(ffile->name);
-	if(!res) return -1;
+	if(!res) goto fail;
 	u64 usedSpace = 0LL;
 	while( (entry = usbgecko_get_entry()) != NULL ){
 		if(entry->fileAttrib == IS_FILE) {
 			if(!checkExtension(entry->name)) continue;
 		}		
-		// Make sure we have room for this one
-		if(i == num_entries) {
-			++num_entries;
-			*dir = reallocarray(*dir, num_entries, sizeof(file_handle));
-		}
-		memset(&(*dir)[i], 0, sizeof(file_handle));
-		if(strlcpy((*dir)[i].name, entry->name, PATHNAME_MAX) < PATHNAME_MAX) {
-			(*dir)[i].size       = entry->size;
-			(*dir)[i].fileAttrib = entry->fileAttrib;
-			usedSpace += (*dir)[i].size;
-			++i;
-		}
+		file_handle* file = addDirEntry(dir, entry->name, entry->fileAttrib);
+		if(!file) goto fail;
+		file->size = entry->size;
+		usedSpace += file->size;
 	}
 	initial_USBGecko_info.totalSpace = usedSpace;
 	DrawDispose(msgBox);
-	return i;
+	return dir->num;
+
+fail:
+	DrawDispose(msgBox);
+	freeDirList(dir);
+	return -1;
 }
 
 s64 deviceHandler_USBGecko_seekFile(file_handle* file, s64 where, u32 type){
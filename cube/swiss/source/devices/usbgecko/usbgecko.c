@@ -32,6 +32,17 @@ u8 ANS_READY = 0x25;
 u8 *replybuffer = NULL; 
 file_handle filehndl;
 
+// A directory entry as the PC sends it, the file_handle layout the server was
+// written against. Note: If the contents of this change, recompile pc/usbgecko/main.c
+typedef struct {
+	char name[PATHNAME_MAX];
+	u64 fileBase;
+	u32 offset;
+	u32 size;
+	s32 fileAttrib;
+	u8 unused[148];
+} usbgecko_entry;
+
 char served_file[1024];		// The file we're currently being served by the PC
 
 typedef struct {
@@ -137,15 +148,16 @@ file_handle* usbgecko_get_entry() {
 	// Try get a reply
 	usb_recvbuffer_safe(1, get_buffer(), 1);
 	if(get_buffer()[0] == ANS_READY) {
-		usb_recvbuffer_safe(1, get_buffer(), offsetof(file_handle, lockCount));
-		if(!get_buffer()[0]) {
+		usbgecko_entry *entry = (usbgecko_entry*)get_buffer();
+		usb_recvbuffer_safe(1, entry, sizeof(usbgecko_entry));
+		if(!entry->name[0]) {
 			return NULL;
 		}
 		else {
 			memset(&filehndl, 0, sizeof(file_handle));
-			memcpy(&filehndl, get_buffer(), offsetof(file_handle, lockCount));
-			filehndl.size = bswap32(filehndl.size);
-			filehndl.fileAttrib = bswap32(filehndl.fileAttrib);
+			strlcpy(filehndl.name, entry->name, PATHNAME_MAX);
+			filehndl.size = bswap32(entry->size);
+			filehndl.fileAttrib = bswap32(entry->fileAttrib);
 			return &filehndl;
 		}
 	}
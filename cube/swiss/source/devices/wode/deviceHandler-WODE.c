@@ -24,12 +24,9 @@ char disktype[] = {'?', 'G','W','W','I' };
 s32 wodeInited = 0;
 
 file_handle initial_WODE =
-	{ "wode:/",     // directory
-	  0ULL,     // fileBase (u64)
-	  0,        // offset
-	  0,        // size
-	  IS_DIR,
-	  DRV_ERROR
+	{ .name = "wode:/",
+	  .fileAttrib = IS_DIR,
+	  .status = DRV_ERROR
 	};
 device_info initial_WODE_info = {
 	0LL,
@@ -63,7 +60,7 @@ device_info* deviceHandler_WODE_info(file_handle* file) {
 	return &initial_WODE_info;
 }
 	
-s32 deviceHandler_WODE_readDir(file_handle* ffile, file_handle** dir, u32 type){	
+s32 deviceHandler_WODE_readDir(file_handle* ffile, dir_list* dir, u32 type){	
 
 	if(!wodeInited) return 0;
 	uiDrawObj_t *msgBox = DrawPublish(DrawProgressBar(true, 0, "Reading WODE"));
@@ -73,10 +70,10 @@ s32 deviceHandler_WODE_readDir(file_handle* ffile, file_handle** dir, u32 type){
 		usleep(20000);
 	}
    
-	u32 numPartitions = 0, numIsoInPartition = 0, i,j, num_entries = 1;
-	*dir = calloc(num_entries, sizeof(file_handle));
-	concat_path((*dir)[0].name, ffile->name, "..");
-	(*dir)[0].fileAttrib = IS_SPECIAL;
+	u32 numPartitions = 0, numIsoInPartition = 0, i,j;
+	char name[PATHNAME_MAX];
+	concat_path(name, ffile->name, "..");
+	if(!addDirEntry(dir, name, IS_SPECIAL)) goto fail;
 
 	numPartitions = GetNumPartitions();
 	for(i=0;i<numPartitions;i++) {
@@ -87,21 +84,24 @@ s32 deviceHandler_WODE_readDir(file_handle* ffile, file_handle** dir, u32 type){
 			tmp.iso_partition = i;
 			tmp.iso_number = j;
 			if(tmp.iso_type==1) { //add gamecube only
-				*dir = reallocarray(*dir, num_entries + 1, sizeof(file_handle));
-				memset(&(*dir)[num_entries], 0, sizeof(file_handle));
-				concatf_path((*dir)[num_entries].name, ffile->name, "%.64s.gcm", &tmp.name[0]);
-				(*dir)[num_entries].size = DISC_SIZE;
-				(*dir)[num_entries].fileAttrib = IS_FILE;
-				memcpy(&(*dir)[num_entries].other, &tmp, sizeof(ISOInfo_t));
+				concatf_path(name, ffile->name, "%.64s.gcm", &tmp.name[0]);
+				file_handle* file = addDirEntry(dir, name, IS_FILE);
+				if(!file) goto fail;
+				file->size = DISC_SIZE;
+				memcpy(&file->other, &tmp, sizeof(ISOInfo_t));
 				print_gecko("Adding WODE entry: %s part:%08X iso:%08X region:%08X\r\n",
 					&tmp.name[0], tmp.iso_partition, tmp.iso_number, tmp.iso_region);
-				num_entries++;
 			}
 		}
 	}
-	initial_WODE_info.totalSpace = num_entries;
+	initial_WODE_info.totalSpace = dir->num;
 	DrawDispose(msgBox);
-	return num_entries;
+	return dir->num;
+
+fail:
+	DrawDispose(msgBox);
+	freeDirList(dir);
+	return -1;
 }
 
 s64 deviceHandler_WODE_seekFile(file_handle* file, s64 where, u32 type){
@@ -6,102 +6,108 @@
 #include "main.h"
 #include "dvd.h"
 #include "files.h"
+#include "filesort.h"
 #include "devices/filemeta.h"
+#include "devices/metacache.h"
 
 static file_handle** sortedDirEntries;
-static file_handle* curDirEntries;  // all the files in the current dir
-static int curDirEntryCount;		// count of files in the current dir
+static dir_list curDirEntries;  // all the files in the current dir
 
-int fileComparator(const void *a1, const void *b1)
-{
-	const file_handle* a = *(const file_handle **)a1;
-	const file_handle* b = *(const file_handle **)b1;
-	
-	if((devices[DEVICE_CUR] == &__device_dvd) && ((dvdDiscTypeInt == ISO9660_GAMECUBE_DISC) || (dvdDiscTypeInt == GAMECUBE_DISC) || (dvdDiscTypeInt == MULTIDISC_DISC)))
-	{
-		if(a->size == DISC_SIZE && a->fileBase == 0)
-			return -1;
-		if(b->size == DISC_SIZE && b->fileBase == 0)
-			return 1;
-	}
-	
-	if(a->fileAttrib != b->fileAttrib)
-		return b->fileAttrib - a->fileAttrib;
-
-	return strcasecmp(a->name, b->name);
-}
-
-file_handle** sortFiles(file_handle* dir, int num_files)
+file_handle** sortFiles(file_handle** dir, int num_files)
 {
 	file_handle** sortedDir = calloc(num_files, sizeof(file_handle*));
-	if(sortedDir) {
+	file_sort_key *keys = calloc(num_files * 2, sizeof(file_sort_key));
+	if(sortedDir && keys) {
+		bool discFirst = (devices[DEVICE_CUR] == &__device_dvd) && ((dvdDiscTypeInt == ISO9660_GAMECUBE_DISC) || (dvdDiscTypeInt == GAMECUBE_DISC) || (dvdDiscTypeInt == MULTIDISC_DISC));
+
+		// Skip the directory that all entries share, digit runs must not be split by it
+		size_t common = num_files ? strlen(dir[0]->name) : 0;
+		for(int i = 1; i < num_files && common; i++) {
+			size_t len = 0;
+			while(len < common && dir[i]->name[len] == dir[0]->name[len]) len++;
+			common = len;
+		}
+		while(common && dir[0]->name[common - 1] != '/') common--;
+
+		for(int i = 0; i < num_files; i++) {
+			u8 class = discFirst && dir[i]->size == DISC_SIZE && dir[i]->fileBase == 0 ? 0 : 255 - MIN((u32)dir[i]->fileAttrib, 254);
+			makeSortKey(&keys[i], dir[i]->name + common, class, i);
+		}
+		sortKeys(keys, keys + num_files, num_files);
 		for(int i = 0; i < num_files; i++) {
-			sortedDir[i] = &dir[i];
+			sortedDir[i] = dir[keys[i].index];
 		}
-		qsort(sortedDir, num_files, sizeof(file_handle*), fileComparator);
 	}
+	else if(sortedDir) {
+		for(int i = 0; i < num_files; i++) {
+			sortedDir[i] = dir[i];
+		}
+	}
+	free(keys);
 	return sortedDir;
 }
 
-void freeFiles() {
+static void freeDirEntries() {
 	free(sortedDirEntries);
 	sortedDirEntries = NULL;
-	if(curDirEntries) {
-		for(int i = 0; i < curDirEntryCount; i++) {
-			if(curDirEntries[i].meta) {
-				meta_free(curDirEntries[i].meta);
-				curDirEntries[i].meta = NULL;
-			}
-			devices[DEVICE_CUR]->closeFile(&curDirEntries[i]);
+	for(int i = 0; i < curDirEntries.num; i++) {
+		if(curDirEntries.entry[i]->meta) {
+			meta_free(curDirEntries.entry[i]->meta);
+			curDirEntries.entry[i]->meta = NULL;
 		}
-		free(curDirEntries);
-		curDirEntries = NULL;
-		curDirEntryCount = 0;
+		devices[DEVICE_CUR]->closeFile(curDirEntries.entry[i]);
 	}
+	freeDirList(&curDirEntries);
+}
+
+// Drops the current directory along with the meta cache, for when the device is left.
+void freeFiles() {
+	metacache_flush();
+	freeDirEntries();
 }
 
 void scanFiles() {
-	freeFiles();
+	freeDirEntries();
 	// Read the directory/device TOC
 	print_gecko("Reading directory: %s\r\n",curDir.name);
-	curDirEntryCount = devices[DEVICE_CUR]->readDir(&curDir, &curDirEntries, -1);
+	devices[DEVICE_CUR]->readDir(&curDir, &curDirEntries, -1);
 	if(!fnmatch(swissSettings.flattenDir, curDir.name, FNM_PATHNAME | FNM_CASEFOLD)) {
-		for(int i = 0; i < curDirEntryCount; i++) {
-			if(curDirEntries[i].fileAttrib == IS_DIR) {
-				file_handle* dirEntries = NULL;
-				int dirEntryCount = devices[DEVICE_CUR]->readDir(&curDirEntries[i], &dirEntries, -1);
-				if(dirEntryCount > 1) {
-					curDirEntryCount--; dirEntryCount--;
-					curDirEntries = reallocarray(curDirEntries, curDirEntryCount + dirEntryCount, sizeof(file_handle));
-					memmove(&curDirEntries[i + dirEntryCount], &curDirEntries[i + 1], (curDirEntryCount - i) * sizeof(file_handle));
-					memmove(&curDirEntries[i], &dirEntries[1], dirEntryCount * sizeof(file_handle));
-					curDirEntryCount += dirEntryCount; i--;
+		for(int i = 0; i < curDirEntries.num; i++) {
+			if(curDirEntries.entry[i]->fileAttrib == IS_DIR) {
+				dir_list dirEntries = {0};
+				int dirEntryCount = devices[DEVICE_CUR]->readDir(curDirEntries.entry[i], &dirEntries, -1);
+				// The subdirectory's ".." is left behind
+				if(dirEntryCount > 1 && spliceDirList(&curDirEntries, i, &dirEntries, 1)) {
+					i--;
+				}
+				else {
+					freeDirList(&dirEntries);
 				}
-				free(dirEntries);
 			}
 		}
 	}
-	print_gecko("Found %i entries\r\n",curDirEntryCount);
-	sortedDirEntries = sortFiles(curDirEntries, curDirEntryCount);
-	for(int i = 0; i < curDirEntryCount; i++) {
+	print_gecko("Found %i entries\r\n",curDirEntries.num);
+	metacache_load(&curDir);
+	sortedDirEntries = sortFiles(curDirEntries.entry, curDirEntries.num);
+	for(int i = 0; i < curDirEntries.num; i++) {
 		if(!strcmp(sortedDirEntries[i]->name, curFile.name)) {
 			curSelection = i;
 			break;
 		}
 	}
-	memcpy(&curFile, &curDir, sizeof(file_handle));
+	copyFileHandle(&curFile, &curDir);
 }
 
 file_handle** getSortedDirEntries() {
 	return sortedDirEntries;
 }
 
-file_handle* getCurrentDirEntries() {
-	return curDirEntries;
+dir_list* getCurrentDirEntries() {
+	return &curDirEntries;
 }
 
 int getCurrentDirEntryCount() {
-	return curDirEntryCount;
+	return curDirEntries.num;
 }
 
 size_t concat_path(char *pathName, const char *dirName, const char *baseName)
@@ -0,0 +1,221 @@
+#include <string.h>
+#include <sys/param.h>
+#include "filesort.h"
+
+#define SORT_KEY_BYTES 16		// size of file_sort_key.key
+#define SORT_RUN_MAX 16
+
+static inline int foldChar(int c)
+{
+	return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+static inline bool isDigit(int c)
+{
+	return c >= '0' && c <= '9';
+}
+
+// Case-insensitive comparison with digit runs compared by value, so that "Disc 2" < "Disc 10".
+int naturalCompare(const char *a, const char *b)
+{
+	const unsigned char *x = (const unsigned char *)a;
+	const unsigned char *y = (const unsigned char *)b;
+
+	while(*x || *y) {
+		if(isDigit(*x) && isDigit(*y)) {
+			while(*x == '0') x++;
+			while(*y == '0') y++;
+			int xlen = 0, ylen = 0;
+			while(isDigit(x[xlen])) xlen++;
+			while(isDigit(y[ylen])) ylen++;
+			if(xlen != ylen)
+				return xlen - ylen;
+			for(int i = 0; i < xlen; i++) {
+				if(x[i] != y[i])
+					return x[i] - y[i];
+			}
+			x += xlen;
+			y += ylen;
+			continue;
+		}
+		int cx = foldChar(*x), cy = foldChar(*y);
+		if(cx != cy)
+			return cx - cy;
+		x++;
+		y++;
+	}
+	return 0;
+}
+
+// Encodes the case-folded name from where the key left off, so that comparing the key
+// bytewise orders as naturalCompare does. A digit run becomes '0', its length and its
+// digits without leading zeros, which sorts against any other character as a digit
+// would. A name component can't hold a run too long for the length byte.
+static void encodeKey(file_sort_key *key)
+{
+	const unsigned char *x = (const unsigned char *)key->name + key->rest;
+	u8 bytes[SORT_KEY_BYTES] = {0};
+	int n = 0;
+
+	while(*x && n < SORT_KEY_BYTES) {
+		if(isDigit(*x)) {
+			const unsigned char *run = x;
+			while(*x == '0') x++;
+			int len = 0;
+			while(isDigit(x[len])) len++;
+			bytes[n++] = '0';
+			if(n < SORT_KEY_BYTES) bytes[n++] = len;
+			// A run cut short is compared again in full when the keys are equal
+			if(n + len > SORT_KEY_BYTES) {
+				memcpy(bytes + n, x, SORT_KEY_BYTES - n);
+				n = SORT_KEY_BYTES;
+				x = run;
+				break;
+			}
+			memcpy(bytes + n, x, len);
+			n += len;
+			x += len;
+			continue;
+		}
+		bytes[n++] = foldChar(*x++);
+	}
+
+	key->key[0] = key->key[1] = 0;
+	for(int i = 0; i < SORT_KEY_BYTES; i++) {
+		key->key[i / 8] = key->key[i / 8] << 8 | bytes[i];
+	}
+	key->rest = (const char *)x - key->name;
+}
+
+void makeSortKey(file_sort_key *key, const char *name, u8 class, u32 index)
+{
+	key->name = name;
+	key->index = index;
+	key->rest = 0;
+	key->class = class;
+	encodeKey(key);
+}
+
+// Orders keys that the encoded bytes don't tell apart.
+static int compareRest(const file_sort_key *a, const file_sort_key *b)
+{
+	int ret = naturalCompare(a->name + a->rest, b->name + b->rest);
+	if(!ret) ret = strcmp(a->name, b->name);
+	if(!ret) ret = a->index < b->index ? -1 : 1;
+	return ret;
+}
+
+static int compareKeys(const file_sort_key *a, const file_sort_key *b)
+{
+	if(a->class != b->class)
+		return a->class < b->class ? -1 : 1;
+	if(a->key[0] != b->key[0])
+		return a->key[0] < b->key[0] ? -1 : 1;
+	if(a->key[1] != b->key[1])
+		return a->key[1] < b->key[1] ? -1 : 1;
+	return compareRest(a, b);
+}
+
+// The class, then the key bytes, most significant first
+static inline u8 keyByte(const file_sort_key *key, int byte)
+{
+	if(byte == 0)
+		return key->class;
+	byte--;
+	return key->key[byte / 8] >> (56 - 8 * (byte % 8));
+}
+
+static void insertionSort(file_sort_key *keys, int count)
+{
+	for(int i = 1; i < count; i++) {
+		file_sort_key key = keys[i];
+		int j = i;
+		while(j > 0 && compareKeys(&key, &keys[j - 1]) < 0) {
+			keys[j] = keys[j - 1];
+			j--;
+		}
+		keys[j] = key;
+	}
+}
+
+// Bottom-up merge sort, for when the keys can't tell a long run apart.
+static void mergeSort(file_sort_key *keys, file_sort_key *temp, int count)
+{
+	file_sort_key *from = keys, *to = temp;
+
+	for(int width = 1; width < count; width *= 2) {
+		for(int lo = 0; lo < count; lo += 2 * width) {
+			int mid = MIN(lo + width, count);
+			int hi = MIN(lo + 2 * width, count);
+			int i = lo, j = mid, k = lo;
+			while(i < mid && j < hi)
+				to[k++] = compareRest(&from[j], &from[i]) < 0 ? from[j++] : from[i++];
+			while(i < mid) to[k++] = from[i++];
+			while(j < hi) to[k++] = from[j++];
+		}
+		file_sort_key *swap = from; from = to; to = swap;
+	}
+	if(from != keys)
+		memcpy(keys, from, count * sizeof(file_sort_key));
+}
+
+// MSD radix sort from the given key byte on, a byte that all keys share costs one
+// counting pass. Small buckets are sorted by comparison, and long runs of equal keys
+// are keyed again on what follows in their names.
+static void radixSort(file_sort_key *keys, file_sort_key *temp, int count, int byte)
+{
+	// Not needed once the keys are distributed, so the buckets below can share it
+	static u32 offsets[256];
+
+	while(count > SORT_RUN_MAX) {
+		if(byte == SORT_KEY_BYTES + 1) {
+			u16 rest = keys[0].rest;
+
+			// Equal keys leave off at the same point in each name, the first tells if there is more
+			if(keys[0].name[rest]) {
+				for(int i = 0; i < count; i++) {
+					encodeKey(&keys[i]);
+				}
+			}
+			if(keys[0].rest == rest) {
+				mergeSort(keys, temp, count);
+				return;
+			}
+			byte = 1;
+		}
+
+		memset(offsets, 0, sizeof(offsets));
+		for(int i = 0; i < count; i++) {
+			offsets[keyByte(&keys[i], byte)]++;
+		}
+		if(offsets[keyByte(&keys[0], byte)] == (u32)count) {
+			byte++;
+			continue;
+		}
+
+		u32 sum = 0;
+		for(int i = 0; i < 256; i++) {
+			u32 size = offsets[i];
+			offsets[i] = sum;
+			sum += size;
+		}
+		for(int i = 0; i < count; i++) {
+			temp[offsets[keyByte(&keys[i], byte)]++] = keys[i];
+		}
+		memcpy(keys, temp, count * sizeof(file_sort_key));
+
+		for(int lo = 0, hi; lo < count; lo = hi) {
+			u8 value = keyByte(&keys[lo], byte);
+			for(hi = lo + 1; hi < count && keyByte(&keys[hi], byte) == value; hi++);
+			radixSort(keys + lo, temp + lo, hi - lo, byte + 1);
+		}
+		return;
+	}
+
+	insertionSort(keys, count);
+}
+
+void sortKeys(file_sort_key *keys, file_sort_key *temp, int count)
+{
+	radixSort(keys, temp, count, 0);
+}
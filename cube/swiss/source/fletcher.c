@@ -0,0 +1,66 @@
+/* 
+ * Copyright (c) 2020-2023, Extrems <extrems@extremscorner.org>
+ * 
+ * This file is part of Swiss.
+ * 
+ * Swiss is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * Swiss is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * with Swiss.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "fletcher.h"
+
+// The modulo is deferred until the sums could overflow, which is after 5802 bytes.
+static void fletcher_sums(const uint8_t *data, size_t size, uint32_t mod, uint32_t sum[2])
+{
+	uint32_t a = 0, b = 0;
+
+	while (size) {
+		size_t block = size < 5802 ? size : 5802;
+		size -= block;
+
+		for (; block >= 4; block -= 4, data += 4) {
+			b += 4 * a + 4 * data[0] + 3 * data[1] + 2 * data[2] + data[3];
+			a += data[0] + data[1] + data[2] + data[3];
+		}
+		while (block--) {
+			a += *data++;
+			b += a;
+		}
+
+		a %= mod;
+		b %= mod;
+	}
+
+	sum[0] = a;
+	sum[1] = b;
+}
+
+uint8_t fletcher8(const void *buffer, size_t size)
+{
+	uint32_t sum[2];
+
+	fletcher_sums(buffer, size, 0xF, sum);
+
+	return sum[1] << 4 | sum[0];
+}
+
+uint16_t fletcher16(const void *buffer, size_t size)
+{
+	uint32_t sum[2];
+
+	fletcher_sums(buffer, size, 0xFF, sum);
+
+	return sum[1] << 8 | sum[0];
+}
@@ -764,32 +764,31 @@ u64 calc_fst_entries_size(char *FST) {
 }
 
 // Returns the number of filesToPatch and fills out the filesToPatch array passed in (pre-allocated)
-int read_fst(file_handle *file, file_handle** dir, u64 *usedSpace) {
+int read_fst(file_handle *file, dir_list* dir, u64 *usedSpace) {
 
 	print_gecko("Read dir for directory: %s\r\n",file->name);
 	char	filename[PATHNAME_MAX];
-	int		numFiles = 1, idx = 0;
+	file_handle *entry;
 	int		isRoot = file->fileBase == 0;
 	
 	DiskHeader *diskHeader = get_gcm_header(file);
 	if(!diskHeader) return -1;
 	
 	char *FST = get_fst(file, diskHeader->FSTOffset, diskHeader->FSTSize);
-	if(!FST) return -1;
+	if(!FST) {
+		free(diskHeader);
+		return -1;
+	}
 	
 	// Get the space taken up by this disc
 	if(usedSpace) *usedSpace = calc_fst_entries_size(FST);
 	
 	if(isRoot) {
 		// Add the disc itself as a "file"
-		*dir = calloc(numFiles, sizeof(file_handle));
-		concatf_path((*dir)[idx].name, file->name, "%.64s.gcm", diskHeader->GameName);
-		(*dir)[idx].fileBase = 0;
-		(*dir)[idx].offset = 0;
-		(*dir)[idx].size = DISC_SIZE;
-		(*dir)[idx].fileAttrib = IS_FILE;
-		(*dir)[idx].meta = 0;
-		idx++;
+		concatf_path(filename, file->name, "%.64s.gcm", diskHeader->GameName);
+		entry = addDirEntry(dir, filename, IS_FILE);
+		if(!entry) goto fail;
+		entry->size = DISC_SIZE;
 	}
 	
 	u32 entries=*(unsigned int*)&FST[8];
@@ -806,14 +805,10 @@ int read_fst(file_handle *file, file_handle** dir, u64 *usedSpace) {
 	
 	if(!isRoot) {
 		// Add a special ".." dir which will take us back up a dir
-		*dir = calloc(numFiles, sizeof(file_handle));
-		concat_path((*dir)[idx].name, file->name, "..");
-		(*dir)[idx].fileBase = *(u32*)&FST[(parent_dir_offset*0x0C)+4];
-		(*dir)[idx].offset = 0;
-		(*dir)[idx].size = 0;
-		(*dir)[idx].fileAttrib = IS_SPECIAL;
-		(*dir)[idx].meta = 0;
-		idx++;
+		concat_path(filename, file->name, "..");
+		entry = addDirEntry(dir, filename, IS_SPECIAL);
+		if(!entry) goto fail;
+		entry->fileBase = *(u32*)&FST[(parent_dir_offset*0x0C)+4];
 	}
 	//print_gecko("Found DIR [%03i]:%s\r\n",parent_dir_offset,isRoot ? "ROOT":filename);
 	
@@ -832,18 +827,10 @@ int read_fst(file_handle *file, file_handle** dir, u64 *usedSpace) {
 		if(FST[offset]) {
 			if(file_offset == parent_dir_offset) {
 				//print_gecko("Adding: [%03i]%s:%s offset %08X length %08X\r\n",i,!FST[offset] ? "File" : "Dir",filename,file_offset,size);
-				if(idx == numFiles){
-					++numFiles;
-					*dir = reallocarray(*dir, numFiles, sizeof(file_handle));
-				}
-				memset(&(*dir)[idx], 0, sizeof(file_handle));
-				strcpy((*dir)[idx].name, filename);
-				(*dir)[idx].fileBase = i;
-				(*dir)[idx].offset = 0;
-				(*dir)[idx].size = size;
-				(*dir)[idx].fileAttrib = IS_DIR;
-				(*dir)[idx].meta = 0;
-				idx++;
+				entry = addDirEntry(dir, filename, IS_DIR);
+				if(!entry) goto fail;
+				entry->fileBase = i;
+				entry->size = size;
 				// Skip the entries that sit in this dir
 				i = size-1;
 			}
@@ -851,22 +838,20 @@ int read_fst(file_handle *file, file_handle** dir, u64 *usedSpace) {
 		else {
 			// File, add it.
 			//print_gecko("Adding: [%03i]%s:%s offset %08X length %08X\r\n",i,!FST[offset] ? "File" : "Dir",filename,file_offset,size);
-			if(idx == numFiles){
-				++numFiles;
-				*dir = reallocarray(*dir, numFiles, sizeof(file_handle));
-			}
-			memset(&(*dir)[idx], 0, sizeof(file_handle));
-			strcpy((*dir)[idx].name, filename);
-			(*dir)[idx].fileBase = file_offset;
-			(*dir)[idx].offset = 0;
-			(*dir)[idx].size = size;
-			(*dir)[idx].fileAttrib = IS_FILE;
-			(*dir)[idx].meta = 0;
-			idx++;
+			entry = addDirEntry(dir, filename, IS_FILE);
+			if(!entry) goto fail;
+			entry->fileBase = file_offset;
+			entry->size = size;
 		}
 	}
 	
 	free(FST);
 	free(diskHeader);
-	return numFiles;
+	return dir->num;
+
+fail:
+	free(FST);
+	free(diskHeader);
+	freeDirList(dir);
+	return -1;
 }
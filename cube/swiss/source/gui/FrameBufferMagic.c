@@ -88,6 +88,9 @@ static char fbTextBuffer[256];
 static char  video_thread_stack[VIDEO_STACK_SIZE];
 static lwp_t video_thread = LWP_THREAD_NULL;
 static mutex_t _videomutex = LWP_MUTEX_NULL;
+static cond_t _videocond = LWP_COND_NULL;
+// The GPU may still be reading what the last frame's objects point at
+static bool _videobusy = false;
 
 enum VideoEventType
 {
@@ -217,24 +220,30 @@ typedef struct uiDrawObjQueue {
 } uiDrawObjQueue_t;
 
 static uiDrawObjQueue_t *videoEventQueue = NULL;
+static uiDrawObjQueue_t *videoEventQueueTail = NULL;
 static uiDrawObj_t *buttonPanel = NULL;
 
+// Display lists are recorded here first, then copied out at their real size
+#define DISPLAY_LIST_SCRATCH_SIZE (64*1024)
+static u8 displayListScratch[DISPLAY_LIST_SCRATCH_SIZE] __attribute__((aligned(32)));
+// Lists dropped while the GPU may still be reading them, freed at the start of the next frame.
+// They are at least 32 bytes, the first word links them.
+static void *retiredDisplayLists = NULL;
+
 // Add root level uiDrawObj_t
 static uiDrawObj_t* addVideoEvent(uiDrawObj_t *event) {
 	// First entry, make it root
 	if(videoEventQueue == NULL) {
 		videoEventQueue = calloc(1, sizeof(uiDrawObjQueue_t));
 		videoEventQueue->event = event;
+		videoEventQueueTail = videoEventQueue;
 		//print_gecko("Added first event %08X (type %s)\r\n", (u32)videoEventQueue, typeStrings[event->type]);
 		return event;
 	}
 	
-	uiDrawObjQueue_t *current = videoEventQueue;
-    while (current->next != NULL) {
-        current = current->next;
-    }
-    current->next = calloc(1, sizeof(uiDrawObjQueue_t));
-	current->next->event = event;
+	videoEventQueueTail->next = calloc(1, sizeof(uiDrawObjQueue_t));
+	videoEventQueueTail = videoEventQueueTail->next;
+	videoEventQueueTail->event = event;
 	event->disposed = false;
 	//print_gecko("Added a new event %08X (type %s)\r\n", (u32)event, typeStrings[event->type]);
 	return event;
@@ -290,35 +299,30 @@ static void clearNestedEvent(uiDrawObj_t *event) {
 	}
 	if(event) {
 		//printf("Clear event\r\n");
+		free(event->displayList);
 		memset(event, 0, sizeof(uiDrawObj_t));
 		free(event);
 	}
 }
 
-static void disposeEvent(uiDrawObj_t *event) {
-	if(videoEventQueue == NULL) {
-		return;
+// Drops the recorded display list so the next frame draws from data again.
+static void invalidateDisplayList(uiDrawObj_t *event) {
+	if(event->displayList) {
+		*(void**)event->displayList = retiredDisplayLists;
+		retiredDisplayLists = event->displayList;
 	}
+	event->displayList = NULL;
+	event->displayListSize = 0;
+	event->drawCount = 0;
+}
 
-	// See if this is in our root event queue
-	uiDrawObjQueue_t *current = videoEventQueue->next;
-	uiDrawObjQueue_t *previous = videoEventQueue;
-	// First node is what we're after.
-	while (current != NULL) {
-		if(current->event == event) {
-			//print_gecko("Disposing event %08X\r\n", (u32)current);
-			clearNestedEvent(current->event);
-			previous->next = current->next;
-			free(current);
-		}
-		else {
-			previous = current;
-		}
-		current = previous->next;
+static void invalidateDisplayLists(uiDrawObj_t *event) {
+	for(; event != NULL; event = event->child) {
+		invalidateDisplayList(event);
+		if(event->child == event) break;
 	}
 }
 
-
 static void init_textures() 
 {
 	TPL_OpenTPLFromMemory(&imagesTPL, (void *)images_tpl, images_tpl_size);
@@ -1305,7 +1309,7 @@ uiDrawObj_t* DrawFileBrowserButton(int x1, int y1, int x2, int y2, const char *m
 	eventData->displayName = strdup(message);
 	eventData->mode = mode;
 	eventData->file = calloc(1, sizeof(file_handle));
-	memcpy(eventData->file, file, sizeof(file_handle));
+	copyFileHandle(eventData->file, file);
 	if(eventData->file->meta) {
 		eventData->file->meta = calloc(1, sizeof(file_meta));
 		memcpy(eventData->file->meta, file->meta, sizeof(file_meta));
@@ -1530,6 +1534,7 @@ void DrawUpdateProgressBar(uiDrawObj_t *evt, int percent) {
 	LWP_MutexLock(_videomutex);
 	drawProgressEvent_t *data = (drawProgressEvent_t*)evt->data;
 	data->percent = percent;
+	invalidateDisplayList(evt);
 	LWP_MutexUnlock(_videomutex);
 }
 
@@ -1540,6 +1545,7 @@ void DrawUpdateProgressBarDetail(uiDrawObj_t *evt, int percent, int speed, int t
 	data->speed = speed;
 	data->timestart = timestart;
 	data->timeremain = timeremain;
+	invalidateDisplayList(evt);
 	LWP_MutexUnlock(_videomutex);
 }
 
@@ -1547,13 +1553,17 @@ void DrawUpdateProgressLoading(uiDrawObj_t *evt, int increment) {
 	LWP_MutexLock(_videomutex);
 	drawProgressEvent_t *data = (drawProgressEvent_t*)evt->data;
 	data->speed += increment;
+	invalidateDisplayList(evt);
 	LWP_MutexUnlock(_videomutex);
 }
 
 void DrawUpdateMenuButtons(int selection) {
 	LWP_MutexLock(_videomutex);
 	drawMenuButtonsEvent_t *data = (drawMenuButtonsEvent_t*)buttonPanel->data;
-	data->selection = selection;
+	if(data->selection != selection) {
+		data->selection = selection;
+		invalidateDisplayList(buttonPanel);
+	}
 	LWP_MutexUnlock(_videomutex);
 }
 
@@ -1561,6 +1571,7 @@ void DrawUpdateFileBrowserButton(uiDrawObj_t *evt, int mode) {
 	LWP_MutexLock(_videomutex);
 	drawFileBrowserButtonEvent_t *data = (drawFileBrowserButtonEvent_t*)evt->data;
 	data->mode = mode;
+	invalidateDisplayList(evt);
 	LWP_MutexUnlock(_videomutex);
 }
 
@@ -2069,9 +2080,7 @@ void DrawGetTextEntry(int mode, const char *label, void *src, int size) {
 }
 
 
-static void videoDrawEvent(uiDrawObj_t *videoEvent) {
-	//print_gecko("Draw event: %08X (type %s)\r\n", (u32)videoEvent, typeStrings[videoEvent->type]);
-	drawInit();
+static void videoDrawEventNow(uiDrawObj_t *videoEvent) {
 	switch(videoEvent->type) {
 		case EV_TEXOBJ:
 			_DrawTexObj(videoEvent);
@@ -2115,6 +2124,68 @@ static void videoDrawEvent(uiDrawObj_t *videoEvent) {
 		default:
 			break;
 	}
+}
+
+// Objects that look the same every frame until a DrawUpdate* call changes them.
+static bool isStaticEvent(uiDrawObj_t *videoEvent) {
+	switch(videoEvent->type) {
+		case EV_IMAGE:
+		case EV_SELECTABLEBUTTON:
+		case EV_EMPTYBOX:
+		case EV_TRANSPARENTBOX:
+		case EV_VERTSCROLLBAR:
+		case EV_MENUBUTTONS:
+			return true;
+		case EV_STYLEDLABEL:
+			return !((drawStyledLabelEvent_t*)videoEvent->data)->fadingDirection;
+		default:
+			return false;
+	}
+}
+
+// Records what the object draws, returns false if it didn't fit. The list sets up
+// the state it draws with itself rather than relying on what the GPU was left in.
+static bool recordDisplayList(uiDrawObj_t *videoEvent) {
+	DCInvalidateRange(displayListScratch, DISPLAY_LIST_SCRATCH_SIZE);
+	GX_BeginDispList(displayListScratch, DISPLAY_LIST_SCRATCH_SIZE);
+	drawInit();
+	videoDrawEventNow(videoEvent);
+	u32 size = GX_EndDispList();
+	if(!size) {
+		return false;
+	}
+	videoEvent->displayList = memalign(32, size);
+	if(!videoEvent->displayList) {
+		return false;
+	}
+	DCInvalidateRange(displayListScratch, size);
+	memcpy(videoEvent->displayList, displayListScratch, size);
+	DCFlushRange(videoEvent->displayList, size);
+	videoEvent->displayListSize = size;
+	return true;
+}
+
+static void videoDrawEvent(uiDrawObj_t *videoEvent) {
+	//print_gecko("Draw event: %08X (type %s)\r\n", (u32)videoEvent, typeStrings[videoEvent->type]);
+	// Objects that only live for a frame aren't worth recording, wait until one is drawn again
+	if(!videoEvent->displayList && videoEvent->drawCount >= 1 && isStaticEvent(videoEvent)) {
+		if(!recordDisplayList(videoEvent)) {
+			videoEvent->drawCount = -1;
+		}
+	}
+	if(videoEvent->displayList) {
+		GX_CallDispList(videoEvent->displayList, videoEvent->displayListSize);
+		// libogc's shadow registers still hold what they did before the list was recorded,
+		// reset them along with the GPU for whatever is drawn next
+		drawInit();
+	}
+	else {
+		drawInit();
+		videoDrawEventNow(videoEvent);
+		if(videoEvent->drawCount >= 0) {
+			videoEvent->drawCount++;
+		}
+	}
 	if(videoEvent->child != NULL) {
 		videoDrawEvent(videoEvent->child);
 	}
@@ -2140,26 +2211,30 @@ static void *videoUpdate(void *videoEventQueue) {
 		whichfb ^= 1;
 		//frames++;
 		LWP_MutexLock(_videomutex);
-		// Mark events recursively as disposed
-		uiDrawObjQueue_t *videoEventQueueEntry = (uiDrawObjQueue_t*)videoEventQueue;
+		// The GPU is done with the last frame, free what was dropped from it
+		while(retiredDisplayLists != NULL) {
+			void *next = *(void**)retiredDisplayLists;
+			free(retiredDisplayLists);
+			retiredDisplayLists = next;
+		}
+		// Free events marked for disposal along with their children, the root event is never disposed
+		uiDrawObjQueue_t *previous = (uiDrawObjQueue_t*)videoEventQueue;
+		uiDrawObjQueue_t *videoEventQueueEntry = previous->next;
 		while(videoEventQueueEntry != NULL) {
 			uiDrawObj_t *videoEvent = videoEventQueueEntry->event;
 			if(videoEvent->disposed) {
 				markDisposed(videoEvent);
+				clearNestedEvent(videoEvent);
+				previous->next = videoEventQueueEntry->next;
+				if(videoEventQueueTail == videoEventQueueEntry) {
+					videoEventQueueTail = previous;
+				}
+				free(videoEventQueueEntry);
 			}
-			videoEventQueueEntry = videoEventQueueEntry->next;
-		}
-		// Free events
-		videoEventQueueEntry = (uiDrawObjQueue_t*)videoEventQueue;
-		while(videoEventQueueEntry != NULL) {
-			uiDrawObj_t *videoEvent = videoEventQueueEntry->event;
-			// Remove any video events marked for disposal
-			if(videoEvent->disposed) {
-				disposeEvent(videoEvent);
-				videoEventQueueEntry = (uiDrawObjQueue_t*)videoEventQueue;
-				continue;
+			else {
+				previous = videoEventQueueEntry;
 			}
-			videoEventQueueEntry = videoEventQueueEntry->next;
+			videoEventQueueEntry = previous->next;
 		}
 		
 		// Draw out every event
@@ -2173,8 +2248,15 @@ static void *videoUpdate(void *videoEventQueue) {
 		//Copy EFB->XFB
 		GX_SetCopyClear((GXColor){0, 0, 0, 0xFF}, GX_MAX_Z24);
 		GX_CopyDisp(xfb[whichfb],GX_TRUE);
-		GX_DrawDone();
+		GX_SetDrawDone();
+		_videobusy = true;
+		LWP_MutexUnlock(_videomutex);
 
+		// Wait for the GPU without holding up threads that update the objects
+		GX_WaitDrawDone();
+		LWP_MutexLock(_videomutex);
+		_videobusy = false;
+		LWP_CondBroadcast(_videocond);
 		LWP_MutexUnlock(_videomutex);
 		VIDEO_SetNextFramebuffer(xfb[whichfb]);
 		VIDEO_SetBlack(getDisableVideo());
@@ -2207,10 +2289,20 @@ void DrawAddChild(uiDrawObj_t *parent, uiDrawObj_t *child)
 	LWP_MutexUnlock(_videomutex);
 }
 
+// Waits for the GPU to finish the last frame, called with _videomutex held.
+static void videoWaitIdle()
+{
+	while(_videobusy) {
+		LWP_CondWait(_videocond, _videomutex);
+	}
+}
+
 void DrawDispose(uiDrawObj_t *evt)
 {
 	LWP_MutexLock(_videomutex);
 	evt->disposed = true;
+	// It's no longer drawn from the next frame on, but what it points at may be freed on return
+	videoWaitIdle();
 	LWP_MutexUnlock(_videomutex);
 }
 
@@ -2223,6 +2315,7 @@ void DrawInit() {
 	DrawAddChild(container, buttonPanel);
 	DrawPublish(container);
 	LWP_MutexInit(&_videomutex, 0);
+	LWP_CondInit(&_videocond);
 	LWP_CreateThread(&video_thread, videoUpdate, videoEventQueue, video_thread_stack, VIDEO_STACK_SIZE, VIDEO_PRIORITY);
 }
 
@@ -2285,6 +2378,12 @@ void DrawLoadBackdrop() {
 					break;
 			}
 			GX_InitTexObjUserData(&backdropIndTexObj, NULL);
+			// Recorded lists point at the old texture
+			LWP_MutexLock(_videomutex);
+			for(uiDrawObjQueue_t *entry = videoEventQueue; entry != NULL; entry = entry->next) {
+				invalidateDisplayLists(entry->event);
+			}
+			LWP_MutexUnlock(_videomutex);
 		}
 		else {
 			TPL_CloseTPLFile(&backdropTPL);
@@ -2304,12 +2403,16 @@ void DrawShutdown() {
 	lwp_t thread = video_thread;
 	video_thread = LWP_THREAD_NULL;
 	LWP_JoinThread(thread, NULL);
+	LWP_CondDestroy(_videocond);
+	_videocond = LWP_COND_NULL;
+	_videobusy = false;
 	GX_SetCurrentGXThread();
 }
 
 void DrawVideoMode(GXRModeObj *videoMode)
 {
 	LWP_MutexLock(_videomutex);
+	videoWaitIdle();
 	if(getVideoMode() != videoMode) {
 		setVideoMode(videoMode);
 	}
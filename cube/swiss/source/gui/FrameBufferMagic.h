@@ -45,6 +45,9 @@ typedef struct uiDrawObj {
 	void *data;
 	struct uiDrawObj *child;
 	bool disposed;
+	void *displayList;		// recorded GX commands, replayed instead of drawing from data
+	u32 displayListSize;
+	int drawCount;			// frames drawn without a display list, -1 if it can't have one
 } uiDrawObj_t;
 
 enum TextureId
@@ -13,6 +13,7 @@
 #include <ogcsys.h>
 #include <string.h>
 #include "IPLFontWrite.h"
+#include "yay0.h"
 
 extern void __SYS_ReadROM(void *buf,u32 len,u32 offset);
 extern void usleep(int s);
@@ -20,11 +21,24 @@ extern void usleep(int s);
 #define FONT_TEX_SIZE_I4 ((512*512)>>1)
 #define FONT_SIZE_ANSI (288 + 131072)
 #define STRHEIGHT_OFFSET 0
+#define GLYPH_BATCH_SIZE 64
 
 typedef struct {
 	u16 s[256], t[256], font_size[256], fheight;
 } CHAR_INFO;
 
+// Glyphs of a string are queued and sent as one quad list rather than one GX_Begin each
+typedef struct {
+	struct {
+		s16 x, y;
+		u8 c;
+		GXColor color;
+	} glyphs[GLYPH_BATCH_SIZE];
+	int count;
+	float scale;
+	bool rotateVertical;
+} GLYPH_BATCH;
+
 static unsigned char fontFont[ 0x40000 ] __attribute__((aligned(32)));
 
 u16 frameWidth;
@@ -34,98 +48,6 @@ GXColor defaultColor = (GXColor) {255,255,255,255};
 GXColor disabledColor = (GXColor) {175,175,182,255};
 GXColor deSelectedColor = (GXColor) {80,80,73,255};
 
-/****************************************************************************
- * YAY0 Decoding
- ****************************************************************************/
-/* Yay0 decompression */
-void decodeYay0(unsigned char *s, unsigned char *d)
-{
-	int i, j, k, p, q, cnt;
-
-	i = *(unsigned long *)(s + 4);	  // size of decoded data
-	j = *(unsigned long *)(s + 8);	  // link table
-	k = *(unsigned long *)(s + 12);	 // byte chunks and count modifiers
-
-	q = 0;					// current offset in dest buffer
-	cnt = 0;				// mask bit counter
-	p = 16;					// current offset in mask table
-
-	unsigned long r22 = 0, r5;
-	
-	do
-	{
-		// if all bits are done, get next mask
-		if(cnt == 0)
-		{
-			// read word from mask data block
-			r22 = *(unsigned long *)(s + p);
-			p += 4;
-			cnt = 32;   // bit counter
-		}
-		// if next bit is set, chunk is non-linked
-		if(r22 & 0x80000000)
-		{
-			// get next byte
-			*(unsigned char *)(d + q) = *(unsigned char *)(s + k);
-			k++, q++;
-		}
-		// do copy, otherwise
-		else
-		{
-			// read 16-bit from link table
-			int r26 = *(unsigned short *)(s + j);
-			j += 2;
-			// 'offset'
-			int r25 = q - (r26 & 0xfff);
-			// 'count'
-			int r30 = r26 >> 12;
-			if(r30 == 0)
-			{
-				// get 'count' modifier
-				r5 = *(unsigned char *)(s + k);
-				k++;
-				r30 = r5 + 18;
-			}
-			else r30 += 2;
-			// do block copy
-			unsigned char *pt = ((unsigned char*)d) + r25;
-			int i;
-			for(i=0; i<r30; i++)
-			{
-				*(unsigned char *)(d + q) = *(unsigned char *)(pt - 1);
-				q++, pt++;
-			}
-		}
-		// next bit in mask
-		r22 <<= 1;
-		cnt--;
-
-	} while(q < i);
-}
-
-void convertI2toI4(void *dst, void *src, int xres, int yres)
-{
-	// I4 has 8x8 tiles
-	int x, y;
-	unsigned char *d = (unsigned char*)dst;
-	unsigned char *s = (unsigned char*)src;
-
-	for (y = 0; y < yres; y += 8)
-		for (x = 0; x < xres; x += 8)
-		{
-			int iy, ix;
-			for (iy = 0; iy < 8; ++iy, s+=2)
-			{
-				for (ix = 0; ix < 2; ++ix)
-				{
-					int v = s[ix];
-					*d++ = (((v>>6)&3)<<6) | (((v>>6)&3)<<4) | (((v>>4)&3)<<2) | ((v>>4)&3);
-					*d++ = (((v>>2)&3)<<6) | (((v>>2)&3)<<4) | (((v)&3)<<2) | ((v)&3);
-				}
-			}
-		}
-}
-
 void init_font(void)
 {
 	void* fontArea = memalign(32,FONT_SIZE_ANSI);
@@ -224,6 +146,48 @@ void drawFontInit(void)
 	GX_SetCullMode (GX_CULL_NONE);
 }
 
+static void flushGlyphs(GLYPH_BATCH *batch)
+{
+	if(!batch->count) return;
+	GX_Begin(GX_QUADS, GX_VTXFMT1, batch->count * 4);
+	for (int j=0; j<batch->count; j++) {
+		unsigned char c = batch->glyphs[j].c;
+		int x = batch->glyphs[j].x;
+		int y = batch->glyphs[j].y;
+		GXColor color = batch->glyphs[j].color;
+		int i;
+		for (i=0; i<4; i++) {
+			int s = (i & 1) ^ ((i & 2) >> 1) ? fontChars.font_size[c] : 1;
+			int t = (i & 2) ? fontChars.fheight : 1;
+			int s0 = fontChars.s[c] + s;
+			int t0 = fontChars.t[c] + t;
+			s = (int) s * batch->scale;
+			t = (int) t * batch->scale;
+			if(batch->rotateVertical) {
+				GX_Position2s16(x + t, y - s);
+			} else {
+				GX_Position2s16(x + s, y + t);
+			}
+			GX_Color4u8(color.r, color.g, color.b, color.a);
+			GX_TexCoord2s16(s0, t0);
+		}
+	}
+	GX_End();
+	batch->count = 0;
+}
+
+static void queueGlyph(GLYPH_BATCH *batch, unsigned char c, int x, int y, GXColor color)
+{
+	if(batch->count == GLYPH_BATCH_SIZE) {
+		flushGlyphs(batch);
+	}
+	batch->glyphs[batch->count].x = x;
+	batch->glyphs[batch->count].y = y;
+	batch->glyphs[batch->count].c = c;
+	batch->glyphs[batch->count].color = color;
+	batch->count++;
+}
+
 void drawString(int x, int y, char *string, float scale, bool centered, GXColor fontColor)
 {
 	if(string == NULL) {
@@ -245,28 +209,17 @@ void drawString(int x, int y, char *string, float scale, bool centered, GXColor
 		y = (int) y - strHeight/2;
 	}
 
+	GLYPH_BATCH batch = { .count = 0, .scale = scale, .rotateVertical = false };
 	while (*string)
 	{
 		unsigned char c = *string;
 		if(c == '\n') break;
-		int i;
-		GX_Begin(GX_QUADS, GX_VTXFMT1, 4);
-		for (i=0; i<4; i++) {
-			int s = (i & 1) ^ ((i & 2) >> 1) ? fontChars.font_size[c] : 1;
-			int t = (i & 2) ? fontChars.fheight : 1;
-			int s0 = fontChars.s[c] + s;
-			int t0 = fontChars.t[c] + t;
-			s = (int) s * scale;
-			t = (int) t * scale;
-			GX_Position2s16(x + s, y + t);
-			GX_Color4u8(fontColor.r, fontColor.g, fontColor.b, fontColor.a);
-			GX_TexCoord2s16(s0, t0);
-		}
-		GX_End();
+		queueGlyph(&batch, c, x, y, fontColor);
 
 		x += (int) fontChars.font_size[c] * scale;
 		string++;
 	}
+	flushGlyphs(&batch);
 }
 
 void drawStringWithCaret(int x, int y, char *string, float scale, bool centered, GXColor fontColor, int caretPosition, GXColor caretColor)
@@ -290,6 +243,7 @@ void drawStringWithCaret(int x, int y, char *string, float scale, bool centered,
 		y = (int) y - strHeight/2;
 	}
 
+	GLYPH_BATCH batch = { .count = 0, .scale = scale, .rotateVertical = false };
 	int pos = 0;
 	while (*string || pos <= caretPosition)
 	{
@@ -298,29 +252,14 @@ void drawStringWithCaret(int x, int y, char *string, float scale, bool centered,
 			c = '|';
 		}
 		if(c == '\n') break;
-		int i;
-		GX_Begin(GX_QUADS, GX_VTXFMT1, 4);
-		for (i=0; i<4; i++) {
-			int s = (i & 1) ^ ((i & 2) >> 1) ? fontChars.font_size[c] : 1;
-			int t = (i & 2) ? fontChars.fheight : 1;
-			int s0 = fontChars.s[c] + s;
-			int t0 = fontChars.t[c] + t;
-			s = (int) s * scale;
-			t = (int) t * scale;
-			GX_Position2s16(x + s, y + t);
-			if(pos == caretPosition)
-				GX_Color4u8(caretColor.r, caretColor.g, caretColor.b, caretColor.a);
-			else
-				GX_Color4u8(fontColor.r, fontColor.g, fontColor.b, fontColor.a);
-			GX_TexCoord2s16(s0, t0);
-		}
-		GX_End();
+		queueGlyph(&batch, c, x, y, pos == caretPosition ? caretColor : fontColor);
 
 		x += (int) fontChars.font_size[c] * scale;
 		if(pos != caretPosition)
 			string++;
 		pos++;
 	}
+	flushGlyphs(&batch);
 }
 
 int GetCharsThatFitInWidth(char *string, int max, float scale)
@@ -369,6 +308,7 @@ void drawStringEllipsis(int x, int y, char *string, float scale, bool centered,
 	int len = strlen(string);
 	int chars_to_draw = GetCharsThatFitInWidth(string, maxSize-12, scale);
 	int dots_to_write = 0;
+	GLYPH_BATCH batch = { .count = 0, .scale = scale, .rotateVertical = rotateVertical };
 	while (*string || dots_to_write)
 	{
 		unsigned char c = *string;
@@ -380,25 +320,7 @@ void drawStringEllipsis(int x, int y, char *string, float scale, bool centered,
 			}
 		}
 		if(c == '\n') break;
-
-		int i;
-		GX_Begin(GX_QUADS, GX_VTXFMT1, 4);
-		for (i=0; i<4; i++) {
-			int s = (i & 1) ^ ((i & 2) >> 1) ? fontChars.font_size[c] : 1;
-			int t = (i & 2) ? fontChars.fheight : 1;
-			int s0 = fontChars.s[c] + s;
-			int t0 = fontChars.t[c] + t;
-			s = (int) s * scale;
-			t = (int) t * scale;
-			if(rotateVertical) {
-				GX_Position2s16(x + t, y - s);
-			} else {
-				GX_Position2s16(x + s, y + t);
-			}
-			GX_Color4u8(fontColor.r, fontColor.g, fontColor.b, fontColor.a);
-			GX_TexCoord2s16(s0, t0);
-		}
-		GX_End();
+		queueGlyph(&batch, c, x, y, fontColor);
 
 		if(rotateVertical) {
 			y -= (int) fontChars.font_size[c] * scale;
@@ -418,6 +340,7 @@ void drawStringEllipsis(int x, int y, char *string, float scale, bool centered,
 			}
 		}
 	}
+	flushGlyphs(&batch);
 }
 
 int GetFontHeight(float scale)
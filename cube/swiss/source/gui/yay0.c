@@ -0,0 +1,80 @@
+#include <string.h>
+#include "yay0.h"
+
+/****************************************************************************
+ * YAY0 Decoding
+ ****************************************************************************/
+/* Yay0 decompression */
+void decodeYay0(unsigned char *s, unsigned char *d)
+{
+	u32 size = *(u32 *)(s + 4);				// size of decoded data
+	u16 *link = (u16 *)(s + *(u32 *)(s + 8));	// link table
+	u8 *chunk = s + *(u32 *)(s + 12);			// byte chunks and count modifiers
+	u32 *mask = (u32 *)(s + 16);				// mask table
+
+	u8 *out = d, *end = d + size;
+	u32 bits = 0;
+	int cnt = 0;
+
+	while (out < end)
+	{
+		// if all bits are done, get next mask
+		if (cnt == 0)
+		{
+			bits = *mask++;
+			cnt = 32;
+		}
+		// a run of set bits is a run of non-linked bytes, copy them together
+		if (bits & 0x80000000)
+		{
+			int run = ~bits ? __builtin_clz(~bits) : 32;
+			if (run > cnt) run = cnt;
+			if (run > end - out) run = end - out;
+			memcpy(out, chunk, run);
+			out += run;
+			chunk += run;
+			bits = run < 32 ? bits << run : 0;
+			cnt -= run;
+		}
+		// do copy, otherwise
+		else
+		{
+			u16 code = *link++;
+			u8 *src = out - (code & 0xfff) - 1;
+			int count = code >> 12;
+			count = count ? count + 2 : *chunk++ + 18;
+			// overlapping copies repeat the last bytes written
+			if (out - src >= count)
+			{
+				memcpy(out, src, count);
+				out += count;
+			}
+			else
+			{
+				while (count--) *out++ = *src++;
+			}
+			bits <<= 1;
+			cnt--;
+		}
+	}
+}
+
+void convertI2toI4(void *dst, void *src, int xres, int yres)
+{
+	// Each 2-bit intensity becomes a 4-bit one by repeating it
+	static const u8 expand[16] = {
+		0x00, 0x05, 0x0A, 0x0F, 0x50, 0x55, 0x5A, 0x5F,
+		0xA0, 0xA5, 0xAA, 0xAF, 0xF0, 0xF5, 0xFA, 0xFF
+	};
+	// I4 has 8x8 tiles, as does I2, so the tile order is the same
+	unsigned char *d = (unsigned char*)dst;
+	unsigned char *s = (unsigned char*)src;
+	int n = (xres * yres) >> 2;
+
+	while (n--)
+	{
+		int v = *s++;
+		*d++ = expand[v >> 4];
+		*d++ = expand[v & 15];
+	}
+}
@@ -0,0 +1,8 @@
+#ifndef YAY0_H
+#define YAY0_H
+#include <gctypes.h>
+
+void decodeYay0(unsigned char *s, unsigned char *d);
+void convertI2toI4(void *dst, void *src, int xres, int yres);
+
+#endif
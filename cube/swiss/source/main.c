@@ -190,7 +190,7 @@ int main(int argc, char *argv[])
 			if(devices[DEVICE_CUR]->features & FEAT_AUTOLOAD_DOL) {
 				load_auto_dol();
 			}
-			memcpy(&curDir, devices[DEVICE_CUR]->initial, sizeof(file_handle));
+			copyFileHandle(&curDir, devices[DEVICE_CUR]->initial);
 			needsDeviceChange = 0;
 			DrawLoadBackdrop();
 		}
@@ -1,6 +1,8 @@
 #include <gccore.h>
+#include <malloc.h>
 #include <stdlib.h>
 #include <mp3player.h>
+#include <ogc/lwp.h>
 #include "main.h"
 #include "util.h"
 #include "swiss.h"
@@ -11,10 +13,198 @@
 static int useShuffle = 0;
 static int volume = 192;
 
+// Read-ahead so that the decoder is served from memory rather than waiting on the device.
+// Two chunks are kept around the play position, or the current chunk and the start of the next track.
+#define MP3_READAHEAD_SIZE (64*1024)
+#define MP3_READAHEAD_CHUNKS 2
+
+enum {
+	CHUNK_FREE = 0,
+	CHUNK_LOADING,
+	CHUNK_VALID
+};
+
+typedef struct {
+	file_handle *file;
+	u32 offset;
+	s32 length;
+	int state;
+	u8 *data;
+} mp3_chunk;
+
+static struct {
+	file_handle *file;		// track being played
+	file_handle *next;		// track expected to play after it
+	u32 position;			// decoder position in the track
+	bool quit;
+	mp3_chunk chunks[MP3_READAHEAD_CHUNKS];
+	lwp_t thread;
+	mutex_t mutex;
+	cond_t cond;
+} mp3 = { .thread = LWP_THREAD_NULL, .mutex = LWP_MUTEX_NULL, .cond = LWP_COND_NULL };
+
+static mp3_chunk *mp3_find_chunk(file_handle *file, u32 offset, bool loading) {
+	for(int i = 0; i < MP3_READAHEAD_CHUNKS; i++) {
+		mp3_chunk *chunk = &mp3.chunks[i];
+		if(chunk->file == file && chunk->offset == offset
+		&& (chunk->state == CHUNK_VALID || (loading && chunk->state == CHUNK_LOADING))) {
+			return chunk;
+		}
+	}
+	return NULL;
+}
+
+// Picks the chunk that should be loaded next, returns false if everything wanted is loaded.
+static bool mp3_wanted_chunk(file_handle **file, u32 *offset) {
+	u32 current = mp3.position - mp3.position % MP3_READAHEAD_SIZE;
+	file_handle *files[MP3_READAHEAD_CHUNKS];
+	u32 offsets[MP3_READAHEAD_CHUNKS];
+
+	for(int i = 0; i < MP3_READAHEAD_CHUNKS; i++) {
+		if(mp3.file && current + i * MP3_READAHEAD_SIZE < mp3.file->size) {
+			files[i] = mp3.file;
+			offsets[i] = current + i * MP3_READAHEAD_SIZE;
+		}
+		else {
+			files[i] = mp3.next;
+			offsets[i] = 0;
+		}
+	}
+	for(int i = 0; i < MP3_READAHEAD_CHUNKS; i++) {
+		if(files[i] && !mp3_find_chunk(files[i], offsets[i], true)) {
+			*file = files[i];
+			*offset = offsets[i];
+			// Reuse a chunk that isn't wanted any more
+			for(int j = 0; j < MP3_READAHEAD_CHUNKS; j++) {
+				mp3_chunk *chunk = &mp3.chunks[j];
+				bool wanted = false;
+				for(int k = 0; k < MP3_READAHEAD_CHUNKS; k++) {
+					wanted |= chunk->state != CHUNK_FREE && chunk->file == files[k] && chunk->offset == offsets[k];
+				}
+				if(!wanted && chunk->state != CHUNK_LOADING) {
+					chunk->file = *file;
+					chunk->offset = *offset;
+					chunk->state = CHUNK_LOADING;
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+static void *mp3_thread_func(void *arg) {
+	LWP_MutexLock(mp3.mutex);
+	while(!mp3.quit) {
+		file_handle *file;
+		u32 offset;
+		if(!mp3_wanted_chunk(&file, &offset)) {
+			LWP_CondWait(mp3.cond, mp3.mutex);
+			continue;
+		}
+		mp3_chunk *chunk = mp3_find_chunk(file, offset, true);
+		LWP_MutexUnlock(mp3.mutex);
+
+		devices[DEVICE_CUR]->seekFile(file, offset, DEVICE_HANDLER_SEEK_SET);
+		s32 length = devices[DEVICE_CUR]->readFile(file, chunk->data, MIN(MP3_READAHEAD_SIZE, file->size - offset));
+
+		LWP_MutexLock(mp3.mutex);
+		chunk->length = length;
+		chunk->state = CHUNK_VALID;
+		LWP_CondBroadcast(mp3.cond);
+	}
+	LWP_MutexUnlock(mp3.mutex);
+	return NULL;
+}
+
+static bool mp3_readahead_start() {
+	for(int i = 0; i < MP3_READAHEAD_CHUNKS; i++) {
+		mp3.chunks[i].state = CHUNK_FREE;
+		mp3.chunks[i].data = memalign(32, MP3_READAHEAD_SIZE);
+		if(!mp3.chunks[i].data) {
+			return false;
+		}
+	}
+	mp3.file = mp3.next = NULL;
+	mp3.position = 0;
+	mp3.quit = false;
+	LWP_MutexInit(&mp3.mutex, false);
+	LWP_CondInit(&mp3.cond);
+	return LWP_CreateThread(&mp3.thread, mp3_thread_func, NULL, NULL, 0, LWP_PRIO_NORMAL) == 0;
+}
+
+static void mp3_readahead_stop() {
+	if(mp3.thread != LWP_THREAD_NULL) {
+		LWP_MutexLock(mp3.mutex);
+		mp3.quit = true;
+		LWP_CondBroadcast(mp3.cond);
+		LWP_MutexUnlock(mp3.mutex);
+		LWP_JoinThread(mp3.thread, NULL);
+		mp3.thread = LWP_THREAD_NULL;
+	}
+	if(mp3.cond != LWP_COND_NULL) {
+		LWP_CondDestroy(mp3.cond);
+		mp3.cond = LWP_COND_NULL;
+	}
+	if(mp3.mutex != LWP_MUTEX_NULL) {
+		LWP_MutexDestroy(mp3.mutex);
+		mp3.mutex = LWP_MUTEX_NULL;
+	}
+	for(int i = 0; i < MP3_READAHEAD_CHUNKS; i++) {
+		free(mp3.chunks[i].data);
+		mp3.chunks[i].data = NULL;
+	}
+}
+
+// Moves the decoder to a track and position, the read-ahead follows it.
+static void mp3_seek(file_handle *file, file_handle *next, u32 position) {
+	if(mp3.thread != LWP_THREAD_NULL) {
+		LWP_MutexLock(mp3.mutex);
+		mp3.file = file;
+		mp3.next = next;
+		mp3.position = position;
+		LWP_CondBroadcast(mp3.cond);
+		LWP_MutexUnlock(mp3.mutex);
+	}
+	else {
+		mp3.file = file;
+		mp3.position = position;
+	}
+}
+
 s32 mp3Reader(void *cbdata, void *dst, s32 size) {
 	file_handle *file = cbdata;
-	devices[DEVICE_CUR]->seekFile(file,file->offset,DEVICE_HANDLER_SEEK_SET);
-	int ret = devices[DEVICE_CUR]->readFile(file,dst,size);
+	s32 ret;
+
+	if(mp3.thread == LWP_THREAD_NULL) {
+		devices[DEVICE_CUR]->seekFile(file,mp3.position,DEVICE_HANDLER_SEEK_SET);
+		ret = devices[DEVICE_CUR]->readFile(file,dst,size);
+		if(ret > 0) mp3.position += ret;
+		return ret;
+	}
+
+	LWP_MutexLock(mp3.mutex);
+	while(true) {
+		if(mp3.position >= file->size) {
+			ret = 0;
+			break;
+		}
+		mp3_chunk *chunk = mp3_find_chunk(file, mp3.position - mp3.position % MP3_READAHEAD_SIZE, false);
+		if(chunk) {
+			if(chunk->length <= (s32)(mp3.position - chunk->offset)) {
+				ret = chunk->length < 0 ? chunk->length : 0;
+				break;
+			}
+			ret = MIN(size, chunk->offset + chunk->length - mp3.position);
+			memcpy(dst, chunk->data + (mp3.position - chunk->offset), ret);
+			mp3.position += ret;
+			LWP_CondBroadcast(mp3.cond);
+			break;
+		}
+		LWP_CondBroadcast(mp3.cond);
+		LWP_CondWait(mp3.cond, mp3.mutex);
+	}
+	LWP_MutexUnlock(mp3.mutex);
 	return ret;
 }
 
@@ -27,7 +217,7 @@ uiDrawObj_t* updatescreen_mp3(file_handle *file, int state, int numFiles, int cu
 	DrawAddChild(player, DrawStyledLabel(640/2, 160, txtbuffer, scale, true, defaultColor));
 	memset(txtbuffer, 0, 256);
 	sprintf(txtbuffer, "------------------------------");
-	float percentPlayed = (float)(((float)file->offset / (float)file->size) * 30);
+	float percentPlayed = (float)(((float)mp3.position / (float)file->size) * 30);
 	txtbuffer[(int)percentPlayed] = '*';
 	DrawAddChild(player, DrawStyledLabel(640/2, 210, txtbuffer, 1.0f, true, defaultColor));
 	DrawAddChild(player, DrawStyledLabel(640/2, 300, "(<-) Rewind (->) Forward (X) Vol+ (Y) Vol-", 1.0f, true, defaultColor));
@@ -37,9 +227,9 @@ uiDrawObj_t* updatescreen_mp3(file_handle *file, int state, int numFiles, int cu
 	return player;
 }
 
-int play_mp3(file_handle *file, int numFiles, int curMP3) {
+int play_mp3(file_handle *file, file_handle *next, int numFiles, int curMP3) {
 	int ret = PLAYER_NEXT;
-	file->offset = 0;
+	mp3_seek(file, next, 0);
 	MP3Player_PlayFile(file, &mp3Reader, NULL);
 	uiDrawObj_t* player = NULL;
 	while(MP3Player_IsPlaying() || ret == PLAYER_PAUSE ) {
@@ -79,8 +269,8 @@ int play_mp3(file_handle *file, int numFiles, int curMP3) {
 		}
 		else if(buttons & PAD_BUTTON_RIGHT) {		// Fwd
 			MP3Player_Stop();
-			if(file->offset+0x8000 < file->size) {
-				file->offset += 0x8000;
+			if(mp3.position+0x8000 < file->size) {
+				mp3_seek(file, next, mp3.position + 0x8000);
 				MP3Player_PlayFile(file, &mp3Reader, NULL);
 			}
 			else {
@@ -90,8 +280,7 @@ int play_mp3(file_handle *file, int numFiles, int curMP3) {
 		}
 		else if(buttons & PAD_BUTTON_LEFT) {		// Rewind
 			MP3Player_Stop();
-			if(file->offset-0x10000 > 0) file->offset -= 0x10000;
-			else file->offset = 0;
+			mp3_seek(file, next, mp3.position > 0x10000 ? mp3.position - 0x10000 : 0);
 			MP3Player_PlayFile(file, &mp3Reader, NULL);
 		}
 		else if(buttons & PAD_TRIGGER_Z) {		// Toggle Shuffle
@@ -116,6 +305,9 @@ void mp3_player(file_handle** allFiles, int numFiles, file_handle* curFile) {
 	// Initialise the audio subsystem
 	MP3Player_Init();
 	MP3Player_Volume(volume);
+	if(!mp3_readahead_start()) {
+		mp3_readahead_stop();
+	}
 	
 	// Find all the .mp3 files in the set of allFiles, and also where our file is.
 	int curMP3 = 0, i = 0;
@@ -127,15 +319,22 @@ void mp3_player(file_handle** allFiles, int numFiles, file_handle* curFile) {
 		}
 	}
 	int first = 1;
+	int shuffleNext = rand() % numFiles;
 	
 	for(i = curMP3; i < numFiles; i++) {
 		int ret = PLAYER_NEXT;
 		if(!first && useShuffle) {
-			i = (rand() % numFiles);
+			i = shuffleNext;
+		}
+		// Pick the following track now so that its start can be read ahead
+		shuffleNext = rand() % numFiles;
+		int next = useShuffle ? shuffleNext : i + 1;
+		while(!useShuffle && next < numFiles && !endsWith(allFiles[next]->name,".mp3")) {
+			next++;
 		}
 		// if it's .mp3
 		if(endsWith(allFiles[i]->name,".mp3")) {
-			ret = play_mp3(allFiles[i], numFiles, i);
+			ret = play_mp3(allFiles[i], next < numFiles && endsWith(allFiles[next]->name,".mp3") ? allFiles[next] : NULL, numFiles, i);
 		}
 		if(ret == PLAYER_STOP) {
 			break;
@@ -147,5 +346,6 @@ void mp3_player(file_handle** allFiles, int numFiles, file_handle* curFile) {
 	}
 	
 	MP3Player_Stop();
+	mp3_readahead_stop();
 }
 
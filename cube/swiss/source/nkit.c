@@ -2302,32 +2302,6 @@ static const struct {
 #define TOTAL_COUNT (VALID_COUNT + 50)
 };
 
-uint8_t fletcher8(const void *buffer, size_t size)
-{
-	const uint8_t *data = buffer;
-	uint8_t sum[2] = {0};
-
-	for (int i = 0; i < size; i++) {
-		sum[0] = (sum[0] + *data++) % 0xF;
-		sum[1] = (sum[1] +  sum[0]) % 0xF;
-	}
-
-	return sum[1] << 4 | sum[0];
-}
-
-uint16_t fletcher16(const void *buffer, size_t size)
-{
-	const uint8_t *data = buffer;
-	uint8_t sum[2] = {0};
-
-	for (int i = 0; i < size; i++) {
-		sum[0] = (sum[0] + *data++) % 0xFF;
-		sum[1] = (sum[1] +  sum[0]) % 0xFF;
-	}
-
-	return sum[1] << 8 | sum[0];
-}
-
 bool is_datel_disc(const DiskHeader *header)
 {
 	return !memcmp(header, &DATEL, offsetof(DiskHeader, DVDMagicWord));
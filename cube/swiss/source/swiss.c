@@ -52,6 +52,7 @@
 #include "devices/deviceHandler.h"
 #include "devices/filelock.h"
 #include "devices/filemeta.h"
+#include "devices/metacache.h"
 #include "dolparameters.h"
 #include "reservedarea.h"
 
@@ -301,7 +302,7 @@ void drawFiles(file_handle** directory, int num_files, uiDrawObj_t *containerPan
 		}
 		for(i = current_view_start,j = 0; i<current_view_end; ++i,++j) {
 			lockFile(directory[i]);
-			populate_meta(directory[i]);
+			populate_visible_meta(directory[i]);
 			uiDrawObj_t *browserButton = DrawFileBrowserButton(150, fileListBase+(j*40),
 									getVideoMode()->fbWidth-30, fileListBase+(j*40)+40,
 									getRelativePath(directory[i]->name, curDir.name),
@@ -329,7 +330,7 @@ uiDrawObj_t* renderFileBrowser(file_handle** directory, int num_files, uiDrawObj
 {
 	memset(txtbuffer,0,sizeof(txtbuffer));
 	if(num_files<=0) {
-		memcpy(&curDir, devices[DEVICE_CUR]->initial, sizeof(file_handle));
+		copyFileHandle(&curDir, devices[DEVICE_CUR]->initial);
 		needsRefresh=1;
 		return filePanel;
 	}
@@ -373,17 +374,17 @@ uiDrawObj_t* renderFileBrowser(file_handle** directory, int num_files, uiDrawObj
 			lockFile(directory[curSelection]);
 			//go into a folder or select a file
 			if(directory[curSelection]->fileAttrib==IS_DIR) {
-				memcpy(&curDir, directory[curSelection], sizeof(file_handle));
+				copyFileHandle(&curDir, directory[curSelection]);
 				needsRefresh=1;
 			}
 			else if(directory[curSelection]->fileAttrib==IS_SPECIAL) {
-				memcpy(&curFile, &curDir, sizeof(file_handle));
+				copyFileHandle(&curFile, &curDir);
 				curDir.fileBase = directory[curSelection]->fileBase;
 				needsDeviceChange = upToParent(&curDir);
 				needsRefresh=1;
 			}
 			else if(directory[curSelection]->fileAttrib==IS_FILE) {
-				memcpy(&curFile, directory[curSelection], sizeof(file_handle));
+				copyFileHandle(&curFile, directory[curSelection]);
 				if(canLoadFileType(&curFile.name[0])) {
 					meta_thread_stop();
 					load_file();
@@ -392,13 +393,13 @@ uiDrawObj_t* renderFileBrowser(file_handle** directory, int num_files, uiDrawObj
 					meta_thread_stop();
 					needsRefresh = manage_file() ? 1:0;
 				}
-				memcpy(directory[curSelection], &curFile, sizeof(file_handle));
+				updateDirEntry(directory[curSelection], &curFile);
 			}
 			unlockFile(directory[curSelection]);
 			break;
 		}
 		if(padsButtonsHeld() & PAD_BUTTON_X) {
-			memcpy(&curFile, &curDir, sizeof(file_handle));
+			copyFileHandle(&curFile, &curDir);
 			curDir.fileBase = directory[0]->fileBase;
 			needsDeviceChange = upToParent(&curDir);
 			needsRefresh=1;
@@ -408,10 +409,10 @@ uiDrawObj_t* renderFileBrowser(file_handle** directory, int num_files, uiDrawObj
 		if((padsButtonsHeld() & PAD_TRIGGER_Z) && swissSettings.enableFileManagement) {
 			lockFile(directory[curSelection]);
 			if(directory[curSelection]->fileAttrib == IS_FILE || directory[curSelection]->fileAttrib == IS_DIR) {
-				memcpy(&curFile, directory[curSelection], sizeof(file_handle));
+				copyFileHandle(&curFile, directory[curSelection]);
 				meta_thread_stop();
 				needsRefresh = manage_file() ? 1:0;
-				memcpy(directory[curSelection], &curFile, sizeof(file_handle));
+				updateDirEntry(directory[curSelection], &curFile);
 				while(padsButtonsHeld() & PAD_BUTTON_B) VIDEO_WaitVSync();
 				if(needsRefresh) {
 					// If we return from doing something with a file, refresh the device in the same dir we were at
@@ -517,7 +518,7 @@ void drawFilesCarousel(file_handle** directory, int num_files, uiDrawObj_t *cont
 		// Left spineart entries
 		for(i = current_view_start; i < curSelection; i++) {
 			lockFile(directory[i]);
-			populate_meta(directory[i]);
+			populate_visible_meta(directory[i]);
 			browserObject = DrawFileCarouselEntry(left_x_base + ((sub_entry_width*(i-curSelection))), y_base + 10,
 									left_x_base + ((sub_entry_width*(i-curSelection))+sub_entry_width), y_base + 10 + sub_entry_height,
 									getRelativePath(directory[i]->name, curDir.name),
@@ -529,7 +530,7 @@ void drawFilesCarousel(file_handle** directory, int num_files, uiDrawObj_t *cont
 		
 		// Main entry
 		lockFile(directory[curSelection]);
-		populate_meta(directory[curSelection]);
+		populate_visible_meta(directory[curSelection]);
 		browserObject = DrawFileCarouselEntry(((getVideoMode()->fbWidth / 2) - (main_entry_width / 2)), y_base,
 								((getVideoMode()->fbWidth / 2) + (main_entry_width / 2)), y_base + main_entry_height,
 								getRelativePath(directory[curSelection]->name, curDir.name),
@@ -541,7 +542,7 @@ void drawFilesCarousel(file_handle** directory, int num_files, uiDrawObj_t *cont
 		// Right spineart entries
 		for(i = curSelection+1; i < current_view_end; i++) {
 			lockFile(directory[i]);
-			populate_meta(directory[i]);
+			populate_visible_meta(directory[i]);
 			browserObject = DrawFileCarouselEntry(right_x_base + ((sub_entry_width*(i-curSelection-1))), y_base + 10,
 									right_x_base + ((sub_entry_width*(i-curSelection-1))+sub_entry_width), y_base + 10 + sub_entry_height,
 									getRelativePath(directory[i]->name, curDir.name),
@@ -558,7 +559,7 @@ uiDrawObj_t* renderFileCarousel(file_handle** directory, int num_files, uiDrawOb
 {
 	memset(txtbuffer,0,sizeof(txtbuffer));
 	if(num_files<=0) {
-		memcpy(&curDir, devices[DEVICE_CUR]->initial, sizeof(file_handle));
+		copyFileHandle(&curDir, devices[DEVICE_CUR]->initial);
 		needsRefresh=1;
 		return filePanel;
 	}
@@ -605,17 +606,17 @@ uiDrawObj_t* renderFileCarousel(file_handle** directory, int num_files, uiDrawOb
 			lockFile(directory[curSelection]);
 			//go into a folder or select a file
 			if(directory[curSelection]->fileAttrib==IS_DIR) {
-				memcpy(&curDir, directory[curSelection], sizeof(file_handle));
+				copyFileHandle(&curDir, directory[curSelection]);
 				needsRefresh=1;
 			}
 			else if(directory[curSelection]->fileAttrib==IS_SPECIAL){
-				memcpy(&curFile, &curDir, sizeof(file_handle));
+				copyFileHandle(&curFile, &curDir);
 				curDir.fileBase = directory[curSelection]->fileBase;
 				needsDeviceChange = upToParent(&curDir);
 				needsRefresh=1;
 			}
 			else if(directory[curSelection]->fileAttrib==IS_FILE){
-				memcpy(&curFile, directory[curSelection], sizeof(file_handle));
+				copyFileHandle(&curFile, directory[curSelection]);
 				if(canLoadFileType(&curFile.name[0])) {
 					meta_thread_stop();
 					load_file();
@@ -624,13 +625,13 @@ uiDrawObj_t* renderFileCarousel(file_handle** directory, int num_files, uiDrawOb
 					meta_thread_stop();
 					needsRefresh = manage_file() ? 1:0;
 				}
-				memcpy(directory[curSelection], &curFile, sizeof(file_handle));
+				updateDirEntry(directory[curSelection], &curFile);
 			}
 			unlockFile(directory[curSelection]);
 			break;
 		}
 		if(padsButtonsHeld() & PAD_BUTTON_X) {
-			memcpy(&curFile, &curDir, sizeof(file_handle));
+			copyFileHandle(&curFile, &curDir);
 			curDir.fileBase = directory[0]->fileBase;
 			needsDeviceChange = upToParent(&curDir);
 			needsRefresh=1;
@@ -640,10 +641,10 @@ uiDrawObj_t* renderFileCarousel(file_handle** directory, int num_files, uiDrawOb
 		if((padsButtonsHeld() & PAD_TRIGGER_Z) && swissSettings.enableFileManagement) {
 			lockFile(directory[curSelection]);
 			if(directory[curSelection]->fileAttrib == IS_FILE || directory[curSelection]->fileAttrib == IS_DIR) {
-				memcpy(&curFile, directory[curSelection], sizeof(file_handle));
+				copyFileHandle(&curFile, directory[curSelection]);
 				meta_thread_stop();
 				needsRefresh = manage_file() ? 1:0;
-				memcpy(directory[curSelection], &curFile, sizeof(file_handle));
+				updateDirEntry(directory[curSelection], &curFile);
 				while(padsButtonsHeld() & PAD_BUTTON_B) VIDEO_WaitVSync();
 				if(needsRefresh) {
 					// If we return from doing something with a file, refresh the device in the same dir we were at
@@ -715,7 +716,7 @@ void drawFilesFullwidth(file_handle** directory, int num_files, uiDrawObj_t *con
 		}
 		for(i = current_view_start,j = 0; i<current_view_end; ++i,++j) {
 			lockFile(directory[i]);
-			populate_meta(directory[i]);
+			populate_visible_meta(directory[i]);
 			uiDrawObj_t *browserButton = DrawFileBrowserButtonMeta(30, fileListBase+(j*40),
 									getVideoMode()->fbWidth-30, fileListBase+(j*40)+40,
 									getRelativePath(directory[i]->name, curDir.name),
@@ -732,7 +733,7 @@ uiDrawObj_t* renderFileFullwidth(file_handle** directory, int num_files, uiDrawO
 {
 	memset(txtbuffer,0,sizeof(txtbuffer));
 	if(num_files<=0) {
-		memcpy(&curDir, devices[DEVICE_CUR]->initial, sizeof(file_handle));
+		copyFileHandle(&curDir, devices[DEVICE_CUR]->initial);
 		needsRefresh=1;
 		return filePanel;
 	}
@@ -779,17 +780,17 @@ uiDrawObj_t* renderFileFullwidth(file_handle** directory, int num_files, uiDrawO
 			lockFile(directory[curSelection]);
 			//go into a folder or select a file
 			if(directory[curSelection]->fileAttrib==IS_DIR) {
-				memcpy(&curDir, directory[curSelection], sizeof(file_handle));
+				copyFileHandle(&curDir, directory[curSelection]);
 				needsRefresh=1;
 			}
 			else if(directory[curSelection]->fileAttrib==IS_SPECIAL) {
-				memcpy(&curFile, &curDir, sizeof(file_handle));
+				copyFileHandle(&curFile, &curDir);
 				curDir.fileBase = directory[curSelection]->fileBase;
 				needsDeviceChange = upToParent(&curDir);
 				needsRefresh=1;
 			}
 			else if(directory[curSelection]->fileAttrib==IS_FILE) {
-				memcpy(&curFile, directory[curSelection], sizeof(file_handle));
+				copyFileHandle(&curFile, directory[curSelection]);
 				if(canLoadFileType(&curFile.name[0])) {
 					meta_thread_stop();
 					load_file();
@@ -798,13 +799,13 @@ uiDrawObj_t* renderFileFullwidth(file_handle** directory, int num_files, uiDrawO
 					meta_thread_stop();
 					needsRefresh = manage_file() ? 1:0;
 				}
-				memcpy(directory[curSelection], &curFile, sizeof(file_handle));
+				updateDirEntry(directory[curSelection], &curFile);
 			}
 			unlockFile(directory[curSelection]);
 			break;
 		}
 		if(padsButtonsHeld() & PAD_BUTTON_X) {
-			memcpy(&curFile, &curDir, sizeof(file_handle));
+			copyFileHandle(&curFile, &curDir);
 			curDir.fileBase = directory[0]->fileBase;
 			needsDeviceChange = upToParent(&curDir);
 			needsRefresh=1;
@@ -814,10 +815,10 @@ uiDrawObj_t* renderFileFullwidth(file_handle** directory, int num_files, uiDrawO
 		if((padsButtonsHeld() & PAD_TRIGGER_Z) && swissSettings.enableFileManagement) {
 			lockFile(directory[curSelection]);
 			if(directory[curSelection]->fileAttrib == IS_FILE || directory[curSelection]->fileAttrib == IS_DIR) {
-				memcpy(&curFile, directory[curSelection], sizeof(file_handle));
+				copyFileHandle(&curFile, directory[curSelection]);
 				meta_thread_stop();
 				needsRefresh = manage_file() ? 1:0;
-				memcpy(directory[curSelection], &curFile, sizeof(file_handle));
+				updateDirEntry(directory[curSelection], &curFile);
 				while(padsButtonsHeld() & PAD_BUTTON_B) VIDEO_WaitVSync();
 				if(needsRefresh) {
 					// If we return from doing something with a file, refresh the device in the same dir we were at
@@ -868,9 +869,9 @@ uiDrawObj_t* renderFileFullwidth(file_handle** directory, int num_files, uiDrawO
 bool select_dest_dir(file_handle* initial, file_handle* selection)
 {
 	file_handle **directory = NULL;
-	file_handle *curDirEntries = NULL;
+	dir_list curDirEntries = {0};
 	file_handle curDir;
-	memcpy(&curDir, initial, sizeof(file_entry));
+	copyFileHandle(&curDir, initial);
 	int i = 0, j = 0, max = 0, refresh = 1, num_files =0, idx = 0;
 	
 	bool cancelled = false;
@@ -882,9 +883,9 @@ bool select_dest_dir(file_handle* initial, file_handle* selection)
 		// Read the directory
 		if(refresh) {
 			free(directory);
-			free(curDirEntries);
+			freeDirList(&curDirEntries);
 			num_files = devices[DEVICE_DEST]->readDir(&curDir, &curDirEntries, IS_DIR);
-			directory = sortFiles(curDirEntries, num_files);
+			directory = sortFiles(curDirEntries.entry, curDirEntries.num);
 			refresh = idx = 0;
 			scrollBarTabHeight = (int)((float)scrollBarHeight/(float)num_files);
 		}
@@ -909,7 +910,7 @@ bool select_dest_dir(file_handle* initial, file_handle* selection)
 		if((padsButtonsHeld() & PAD_BUTTON_A))	{
 			//go into a folder or select a file
 			if(directory[idx]->fileAttrib==IS_DIR) {
-				memcpy(&curDir, directory[idx], sizeof(file_handle));
+				copyFileHandle(&curDir, directory[idx]);
 				refresh=1;
 			}
 			else if(directory[idx]->fileAttrib==IS_SPECIAL){
@@ -922,7 +923,7 @@ bool select_dest_dir(file_handle* initial, file_handle* selection)
 			usleep(50000 - abs(padsStickY()*256));
 		}
 		if(padsButtonsHeld() & PAD_BUTTON_X)	{
-			memcpy(selection, &curDir, sizeof(file_handle));
+			copyFileHandle(selection, &curDir);
 			break;
 		}
 		if(padsButtonsHeld() & PAD_BUTTON_B)	{
@@ -933,7 +934,7 @@ bool select_dest_dir(file_handle* initial, file_handle* selection)
 			{ VIDEO_WaitVSync (); }
 	}
 	DrawDispose(destDirBox);
-	free(curDirEntries);
+	freeDirList(&curDirEntries);
 	free(directory);
 	return cancelled;
 }
@@ -1327,6 +1328,7 @@ void boot_dol()
 	}
 	gameID_set(NULL, hash);
 	DrawDispose(progBar);
+	metacache_flush();
 	
 	if(devices[DEVICE_CONFIG] != NULL) {
 		// Update the recent list.
@@ -1723,6 +1725,9 @@ bool manage_file() {
 			// Read from one file and write to the new directory
 			u32 bulkWrite = isSrcCard || isDestCard || devices[DEVICE_DEST] == &__device_qoob;
 			u32 curOffset = curFile.offset, cancelled = 0, chunkSize = bulkWrite ? curFile.size - curOffset : (256*1024);
+			// Checksum ROM dumps while copying so they can be verified without reading them back
+			bool checksum = devices[DEVICE_CUR] == &__device_sys;
+			u32 crc = 0;
 			char *readBuffer = (char*)memalign(32,chunkSize);
 			sprintf(txtbuffer, "Copying to: %s",getRelativeName(destFile->name));
 			uiDrawObj_t* progBar = DrawProgressBar(false, 0, txtbuffer);
@@ -1770,6 +1775,9 @@ bool manage_file() {
 						return true;
 					}
 				}
+				if(checksum) {
+					crc = crc32(crc, (const Bytef*)readBuffer, amountToCopy);
+				}
 				ret = devices[DEVICE_DEST]->writeFile(destFile, readBuffer, amountToCopy);
 				if(ret != amountToCopy) {
 					DrawDispose(progBar);
@@ -1815,6 +1823,10 @@ bool manage_file() {
 					needsRefresh=1;
 					msgBox = DrawMessageBox(D_INFO,"Move Complete!");
 				}
+				else if(checksum) {
+					sprintf(txtbuffer, "Copy Complete.\nCRC32: %08X\nPress A to continue", crc);
+					msgBox = DrawMessageBox(D_INFO,txtbuffer);
+				}
 				else {
 					msgBox = DrawMessageBox(D_INFO,"Copy Complete.\nPress A to continue");
 				}
@@ -2024,6 +2036,7 @@ void load_game() {
 		free(config);
 		return;
 	}
+	metacache_flush();
 	
 	if(devices[DEVICE_CONFIG] != NULL) {
 		// Update the recent list.
@@ -2689,7 +2702,7 @@ void menu_loop()
 		DrawUpdateMenuButtons((curMenuLocation == ON_OPTIONS) ? curMenuSelection : MENU_NOSELECT);
 		select_device(DEVICE_CUR);
 		if(devices[DEVICE_CUR] != NULL) {
-			memcpy(&curDir, devices[DEVICE_CUR]->initial, sizeof(file_handle));
+			copyFileHandle(&curDir, devices[DEVICE_CUR]->initial);
 			uiDrawObj_t *msgBox = DrawPublish(DrawProgressBar(true, 0, "Setting up device"));
 			// If the user selected a device, make sure it's ready before we browse the filesystem
 			s32 ret = devices[DEVICE_CUR]->init( devices[DEVICE_CUR]->initial );
@@ -2720,7 +2733,7 @@ void menu_loop()
 			curMenuLocation=ON_OPTIONS;
 			curSelection=0; curMenuSelection=0;
 			scanFiles();
-			if(getCurrentDirEntryCount()<1) { devices[DEVICE_CUR]->deinit(devices[DEVICE_CUR]->initial); needsDeviceChange=1; break;}
+			if(getCurrentDirEntryCount()<1) { freeFiles(); devices[DEVICE_CUR]->deinit(devices[DEVICE_CUR]->initial); needsDeviceChange=1; break;}
 			needsRefresh = 0;
 			curMenuLocation = ON_FILLIST;
 			DrawUpdateMenuButtons((curMenuLocation == ON_OPTIONS) ? curMenuSelection : MENU_NOSELECT);
@@ -2762,7 +2775,7 @@ void menu_loop()
 						break;
 					case MENU_REFRESH:
 						if(devices[DEVICE_CUR] != NULL) {
-							memcpy(&curDir, devices[DEVICE_CUR]->initial, sizeof(file_handle));
+							copyFileHandle(&curDir, devices[DEVICE_CUR]->initial);
 							if(devices[DEVICE_CUR] == &__device_wkf) { 
 								wkfReinit(); devices[DEVICE_CUR]->deinit(devices[DEVICE_CUR]->initial);
 							}
@@ -2770,6 +2783,7 @@ void menu_loop()
 						needsRefresh=1;
 						break;
 					case MENU_EXIT:
+						metacache_flush();
 						DrawShutdown();
 						exit(0);
 						__builtin_unreachable();
@@ -131,7 +131,7 @@ char *autoboot_dols[] = { "/boot3.dol", "/boot2.dol" }; // Keep this list sorted
 void load_auto_dol() {
 	u8 rev_buf[sizeof(GITREVISION) - 1]; // Don't include the NUL termination in the comparison
 
-	memcpy(&curDir, devices[DEVICE_CUR]->initial, sizeof(file_handle));
+	copyFileHandle(&curDir, devices[DEVICE_CUR]->initial);
 	scanFiles();
 	file_handle** dirEntries = getSortedDirEntries();
 	int dirEntryCount = getSortedDirEntryCount();
@@ -146,9 +146,9 @@ void load_auto_dol() {
 				if (memcmp(GITREVISION, rev_buf, sizeof(rev_buf)) != 0) {
 					// Emulate some of the menu's behavior to satisfy boot_dol
 					curSelection = i;
-					memcpy(&curFile, dirEntries[i], sizeof(file_handle));
+					copyFileHandle(&curFile, dirEntries[i]);
 					boot_dol();
-					memcpy(dirEntries[i], &curFile, sizeof(file_handle));
+					updateDirEntry(dirEntries[i], &curFile);
 				}
 
 				// If we've made it this far, we've already found an autoboot DOL,
@@ -225,7 +225,7 @@ int find_existing_entry(char *entry, bool load) {
 			}
 			// Attempt to read the directory the recent file lives in (required for 2 disc games)
 			devices[DEVICE_CUR] = entryDevice;
-			memcpy(&curDir, devices[DEVICE_CUR]->initial, sizeof(file_handle));
+			copyFileHandle(&curDir, devices[DEVICE_CUR]->initial);
 			getParentPath(entry, curDir.name);
 			while(!fnmatch(swissSettings.flattenDir, curDir.name, FNM_PATHNAME | FNM_CASEFOLD | FNM_LEADING_DIR)
 				&& fnmatch(swissSettings.flattenDir, curDir.name, FNM_PATHNAME | FNM_CASEFOLD) == FNM_NOMATCH)
@@ -247,12 +247,12 @@ int find_existing_entry(char *entry, bool load) {
 					curSelection = i;
 					if(dirEntries[i]->fileAttrib == IS_FILE && load) {
 						populate_meta(dirEntries[i]);
-						memcpy(&curFile, dirEntries[i], sizeof(file_handle));
+						copyFileHandle(&curFile, dirEntries[i]);
 						load_file();
-						memcpy(dirEntries[i], &curFile, sizeof(file_handle));
+						updateDirEntry(dirEntries[i], &curFile);
 					}
 					else if(dirEntries[i]->fileAttrib == IS_DIR) {
-						memcpy(&curDir, dirEntries[i], sizeof(file_handle));
+						copyFileHandle(&curDir, dirEntries[i]);
 						needsRefresh = 1;
 					}
 					return 0;
@@ -268,15 +268,18 @@ int find_existing_entry(char *entry, bool load) {
 bool deleteFileOrDir(file_handle* entry) {
 	if(entry->fileAttrib == IS_DIR) {
 		print_gecko("Entering dir for deletion: %s\r\n", entry);
-		file_handle* dirEntries = NULL;
-		int dirEntryCount = devices[DEVICE_CUR]->readDir(entry, &dirEntries, -1);
+		dir_list dirEntries = {0};
+		if(devices[DEVICE_CUR]->readDir(entry, &dirEntries, -1) < 0) {
+			return false;
+		}
 		int i;
-		for(i = 0; i < dirEntryCount; i++) {
-			if(!deleteFileOrDir(&dirEntries[i])) {
+		for(i = 0; i < dirEntries.num; i++) {
+			if(!deleteFileOrDir(dirEntries.entry[i])) {
+				freeDirList(&dirEntries);
 				return false;
 			}
 		}
-		if(dirEntries) free(dirEntries);
+		freeDirList(&dirEntries);
 		print_gecko("Finally, deleting empty directory: %s\r\n", entry);
 		return !devices[DEVICE_CUR]->deleteFile(entry);
 	}
@@ -37,6 +37,30 @@ typedef struct {
 	uint32_t inflate_size;
 } ATTRIBUTE_PACKED wiiload_header_t;
 
+typedef struct {
+	uint32_t offset;
+	uint32_t address;
+	uint32_t length;
+} wiiload_segment_t;
+
+// Sections are staged to ARAM as soon as they are inflated, only the start
+// of the image is kept around to identify it.
+typedef struct {
+	enum {
+		WIILOAD_HEAD,
+		WIILOAD_ELF,
+		WIILOAD_DOL,
+		WIILOAD_BIN,
+	} type;
+	uint32_t size;
+	uint32_t pos;
+	uint32_t entry;
+	int count;
+	wiiload_segment_t *segment;
+	uint8_t head[4096];
+	uint8_t window[4096];
+} wiiload_stream_t;
+
 static lwp_t thread = LWP_THREAD_NULL;
 
 static struct {
@@ -82,40 +106,147 @@ static int tcp_read(int sd, void *buf, size_t size)
 	return pos;
 }
 
-static void *wiiload_read(int sd, size_t insize, size_t outsize)
+static bool wiiload_begin(wiiload_stream_t *stream, size_t size)
+{
+	if (!memcmp(stream->head, ELFMAG, SELFMAG)) {
+		Elf32_Ehdr *ehdr = (Elf32_Ehdr *)stream->head;
+		Elf32_Phdr *phdr = (Elf32_Phdr *)(stream->head + ehdr->e_phoff);
+
+		if (size < sizeof(*ehdr) || !valid_elf_image(ehdr))
+			return false;
+		if (ehdr->e_phoff + ehdr->e_phnum * sizeof(*phdr) > size)
+			return false;
+		if (!(stream->segment = calloc(ehdr->e_phnum, sizeof(wiiload_segment_t))))
+			return false;
+
+		for (int i = 0; i < ehdr->e_phnum; i++) {
+			if (phdr[i].p_type == PT_LOAD) {
+				stream->segment[stream->count].offset  = phdr[i].p_offset;
+				stream->segment[stream->count].address = phdr[i].p_vaddr;
+				stream->segment[stream->count].length  = phdr[i].p_filesz;
+				stream->count++;
+			}
+		}
+
+		stream->type = WIILOAD_ELF;
+		stream->entry = ehdr->e_entry;
+		return ELFStageBegin(ehdr, phdr);
+	}
+
+	if (size >= DOLHDRLENGTH && !branchResolve((u32 *)stream->head, PATCH_BIN, 0)) {
+		DOLHEADER *dolhdr = (DOLHEADER *)stream->head;
+
+		if (DOLStageBegin(dolhdr)) {
+			if (!(stream->segment = calloc(MAXTEXTSECTION + MAXDATASECTION, sizeof(wiiload_segment_t))))
+				return false;
+
+			for (int i = 0; i < MAXTEXTSECTION; i++) {
+				if (dolhdr->textAddress[i] && dolhdr->textLength[i]) {
+					stream->segment[stream->count].offset  = dolhdr->textOffset[i];
+					stream->segment[stream->count].address = dolhdr->textAddress[i];
+					stream->segment[stream->count].length  = dolhdr->textLength[i];
+					stream->count++;
+				}
+			}
+			for (int i = 0; i < MAXDATASECTION; i++) {
+				if (dolhdr->dataAddress[i] && dolhdr->dataLength[i]) {
+					stream->segment[stream->count].offset  = dolhdr->dataOffset[i];
+					stream->segment[stream->count].address = dolhdr->dataAddress[i];
+					stream->segment[stream->count].length  = dolhdr->dataLength[i];
+					stream->count++;
+				}
+			}
+
+			stream->type = WIILOAD_DOL;
+			stream->entry = dolhdr->entryPoint;
+			return true;
+		}
+	}
+
+	// Anything else is staged as is, the arguments decide where it goes
+	if (!(stream->segment = calloc(1, sizeof(wiiload_segment_t))))
+		return false;
+
+	stream->segment[0].length = stream->size;
+	stream->count = 1;
+	stream->type = WIILOAD_BIN;
+	return BINStageBegin(stream->size);
+}
+
+static void wiiload_stage(wiiload_stream_t *stream, uint8_t *buf, uint32_t pos, uint32_t len)
+{
+	for (int i = 0; i < stream->count; i++) {
+		wiiload_segment_t *segment = &stream->segment[i];
+		uint32_t start = MAX(pos, segment->offset);
+		uint32_t end = MIN(pos + len, segment->offset + segment->length);
+
+		if (start < end)
+			ARAMStage(buf + (start - pos), segment->address + (start - segment->offset), end - start);
+	}
+}
+
+static bool wiiload_push(wiiload_stream_t *stream, uint8_t *buf, uint32_t len)
+{
+	if (len > stream->size - stream->pos)
+		return false;
+
+	if (stream->type == WIILOAD_HEAD) {
+		uint32_t size = MIN(stream->size, sizeof(stream->head));
+		uint32_t count = MIN(len, size - stream->pos);
+
+		memcpy(stream->head + stream->pos, buf, count);
+		stream->pos += count;
+		buf += count;
+		len -= count;
+
+		if (stream->pos < size)
+			return true;
+		if (!wiiload_begin(stream, size))
+			return false;
+
+		wiiload_stage(stream, stream->head, 0, size);
+	}
+
+	wiiload_stage(stream, buf, stream->pos, len);
+	stream->pos += len;
+	return true;
+}
+
+static bool wiiload_read(int sd, wiiload_stream_t *stream, size_t insize)
 {
 	Byte inbuf[4096];
 	z_stream zstream = {0};
 	int ret, pos = 0;
 
-	void *outbuf = malloc(outsize);
-
-	if (!outbuf)
-		goto fail;
 	if (inflateInit(&zstream) < 0)
-		goto fail;
-
-	zstream.next_out  = outbuf;
-	zstream.avail_out = outsize;
+		return false;
 
 	while (pos < insize) {
 		ret = tcp_read(sd, inbuf, MIN(insize - pos, sizeof(inbuf)));
-		if (ret < 0) goto fail;
+		if (ret < 1) goto fail;
 		else pos += ret;
 
 		zstream.next_in  = inbuf;
 		zstream.avail_in = ret;
-		ret = inflate(&zstream, Z_NO_FLUSH);
-		if (ret < 0) goto fail;
+
+		// Inflate and stage what has arrived so far before reading more
+		do {
+			zstream.next_out  = stream->window;
+			zstream.avail_out = sizeof(stream->window);
+			ret = inflate(&zstream, Z_NO_FLUSH);
+			if (ret < 0 && ret != Z_BUF_ERROR) goto fail;
+
+			if (!wiiload_push(stream, stream->window, sizeof(stream->window) - zstream.avail_out))
+				goto fail;
+		} while (ret == Z_OK && zstream.avail_out == 0);
 	}
 
 	inflateEnd(&zstream);
-	return outbuf;
+	return stream->type != WIILOAD_HEAD && stream->pos == stream->size;
 
 fail:
 	inflateEnd(&zstream);
-	free(outbuf);
-	return NULL;
+	return false;
 }
 
 static void *wiiload_read_args(int sd, size_t size)
@@ -145,22 +276,43 @@ static void wiiload_handler(int sd)
 	if (header.version != 5)
 		return;
 
-	void *buffer = wiiload_read(sd, header.deflate_size, header.inflate_size);
+	// Refused while the ARAM or System device is mounted
+	if (!ARAMStageClaim())
+		return;
+
+	wiiload_stream_t *stream = calloc(1, sizeof(*stream));
+
+	if (!stream) {
+		ARAMStageRelease();
+		return;
+	}
+
+	stream->size = header.inflate_size;
+
+	bool staged = wiiload_read(sd, stream, header.deflate_size);
 	void *args = wiiload_read_args(sd, header.args_size);
 
-	if (buffer) {
-		if (!memcmp(buffer, ELFMAG, SELFMAG))
-			ELFtoARAM(buffer, args, header.args_size);
-		else if (!strncasecmp(args, "SDLOADER.BIN", header.args_size))
-			BINtoARAM(buffer, header.inflate_size, 0x81700000, 0x81700000);
-		else if (branchResolve(buffer, PATCH_BIN, 0))
-			BINtoARAM(buffer, header.inflate_size, 0x80003100, 0x80003100);
-		else
-			DOLtoARAM(buffer, args, header.args_size);
+	if (staged) {
+		switch (stream->type) {
+			case WIILOAD_ELF:
+			case WIILOAD_DOL:
+				ARAMStageRun(stream->entry, args, header.args_size);
+				break;
+			case WIILOAD_BIN:
+				if (!strncasecmp(args, "SDLOADER.BIN", header.args_size))
+					BINStageRun(0x81700000, 0x81700000);
+				else if (branchResolve((u32 *)stream->head, PATCH_BIN, 0))
+					BINStageRun(0x80003100, 0x80003100);
+				break;
+			default:
+				break;
+		}
 	}
 
+	ARAMStageRelease();
 	free(args);
-	free(buffer);
+	free(stream->segment);
+	free(stream);
 }
 
 static void *thread_func(void *arg)
@@ -0,0 +1,67 @@
+/* host.h
+	- host stand-in for deviceHandler.h
+ */
+
+// Included ahead of every source file, this stands in for deviceHandler.h so
+// that dirlist.c can be built for the host unchanged. The file handle keeps
+// the field order of the real one, pointers are wider on the host.
+
+#ifndef HOST_H
+#define HOST_H
+
+#define DEVICE_HANDLER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef volatile uint32_t vu32;
+
+#define PATHNAME_MAX 1024
+
+enum {
+	IS_FILE = 0,
+	IS_DIR,
+	IS_SPECIAL
+};
+
+typedef struct file_handle file_handle;
+
+struct file_handle {
+	uint64_t fileBase;
+	u32 offset;
+	u32 size;
+	s32 fileAttrib;
+	s32 status;
+	void *fp;
+	void *ffsFp;
+	void *meta;
+	u8 other[128];
+	void *uiObj;
+	vu32 lockCount;
+	u32 thread;
+	char name[PATHNAME_MAX];
+};
+
+typedef struct dir_chunk dir_chunk;
+
+typedef struct {
+	file_handle **entry;
+	int num;
+	int capacity;
+	dir_chunk *chunks;
+} dir_list;
+
+extern file_handle* addDirEntry(dir_list *dir, const char *name, s32 fileAttrib);
+extern bool spliceDirList(dir_list *dir, int index, dir_list *from, int first);
+extern bool isDirEntry(dir_list *dir, file_handle *file);
+extern void freeDirList(dir_list *dir);
+extern void copyFileHandle(file_handle *dst, const file_handle *src);
+extern void updateDirEntry(file_handle *entry, const file_handle *file);
+
+#endif
@@ -0,0 +1,428 @@
+/* main.c
+	- lists a FAT directory of 10k files into directory listings
+ */
+
+// A FAT volume is formatted in memory with 10k files named as a game library
+// would have them, all in one directory. It is listed as
+// deviceHandler_FAT_readDir does, once into file handles laid out as before,
+// whole and side by side in an array grown by doubling as reserveDirEntry did,
+// and once into a dir_list through dirlist.c. Both have to hold every file.
+// The peak heap use and best time of each are reported. Then every allocation
+// of a smaller listing is made to fail in turn, and the listing has to stop
+// with an error and give back everything it took. Heap use is counted by
+// wrapping the allocator, a block that is grown counts at both sizes until it
+// has been copied over, as it would on the console.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <malloc.h>
+#include <time.h>
+#include <sys/param.h>
+#include "ff.h"
+#include "diskio.h"
+
+#define VOLUME       "sda:"
+#define PATH         VOLUME "/games"
+#define DISK_SECTORS 0x40000
+#define FILES        10000
+#define SMALL        200
+#define RUNS         5
+
+// The previous layout, as reference
+typedef struct {
+	char name[PATHNAME_MAX];
+	uint64_t fileBase;
+	u32 offset;
+	u32 size;
+	s32 fileAttrib;
+	s32 status;
+	void *fp;
+	void *ffsFp;
+	void *meta;
+	u8 other[128];
+	void *uiObj;
+	vu32 lockCount;
+	u32 thread;
+} file_handle_old;
+
+static u8 *disk;
+static FATFS fs;
+
+static struct {
+	size_t live;
+	size_t peak;
+	int allocations;
+	int failAt;
+} heap;
+
+// Disk
+
+DSTATUS disk_initialize(BYTE pdrv)
+{
+	return 0;
+}
+
+DSTATUS disk_status(BYTE pdrv)
+{
+	return 0;
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count)
+{
+	memcpy(buff, disk + sector * 512, count * 512);
+	return RES_OK;
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count)
+{
+	memcpy(disk + sector * 512, buff, count * 512);
+	return RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
+{
+	switch (cmd) {
+		case GET_SECTOR_COUNT:
+			*(LBA_t *)buff = DISK_SECTORS;
+			return RES_OK;
+		case GET_SECTOR_SIZE:
+			*(WORD *)buff = 512;
+			return RES_OK;
+		case GET_BLOCK_SIZE:
+			*(DWORD *)buff = 1;
+			return RES_OK;
+		case CTRL_SYNC:
+			return RES_OK;
+	}
+	return RES_PARERR;
+}
+
+DWORD get_fattime(void)
+{
+	return (DWORD)(2024 - 1980) << 25 | 1 << 21 | 1 << 16;
+}
+
+int ff_mutex_create(int vol)
+{
+	return 1;
+}
+
+void ff_mutex_delete(int vol)
+{
+}
+
+int ff_mutex_take(int vol)
+{
+	return 1;
+}
+
+void ff_mutex_give(int vol)
+{
+}
+
+// Heap
+
+void *__real_malloc(size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static bool failing(void)
+{
+	return heap.failAt >= 0 && heap.allocations++ == heap.failAt;
+}
+
+static void grown(size_t size)
+{
+	heap.live += size;
+	if (heap.live > heap.peak)
+		heap.peak = heap.live;
+}
+
+void *__wrap_malloc(size_t size)
+{
+	if (failing())
+		return NULL;
+	void *ptr = __real_malloc(size);
+	if (ptr)
+		grown(malloc_usable_size(ptr));
+	return ptr;
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+	if (size && nmemb > SIZE_MAX / size)
+		return NULL;
+	void *ptr = __wrap_malloc(nmemb * size);
+	if (ptr)
+		memset(ptr, 0, nmemb * size);
+	return ptr;
+}
+
+void __wrap_free(void *ptr)
+{
+	if (ptr)
+		heap.live -= malloc_usable_size(ptr);
+	__real_free(ptr);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+	if (!ptr)
+		return __wrap_malloc(size);
+	if (failing())
+		return NULL;
+	size_t old = malloc_usable_size(ptr);
+	void *grew = __real_realloc(ptr, size);
+	if (grew) {
+		grown(malloc_usable_size(grew));
+		heap.live -= old;
+	}
+	return grew;
+}
+
+void *__wrap_reallocarray(void *ptr, size_t nmemb, size_t size)
+{
+	if (size && nmemb > SIZE_MAX / size)
+		return NULL;
+	return __wrap_realloc(ptr, nmemb * size);
+}
+
+// Volume
+
+static const char *words[] = {
+	"Zelda", "Mario Kart", "Pikmin", "Metroid Prime", "Star Fox", "F-Zero GX",
+	"Super Smash Bros. Melee", "Animal Crossing", "Luigi's Mansion", "Paper Mario",
+	"Wave Race", "1080 Avalanche", "Tales of Symphonia", "Resident Evil", "Ikaruga"
+};
+
+#define WORD (words[rand() % (sizeof(words) / sizeof(*words))])
+
+static void file_name(char *name, int i)
+{
+	static const char *regions[] = {"USA", "Europe", "Japan", "USA, Europe"};
+
+	srand(i);
+	snprintf(name, PATHNAME_MAX, "%s %s - %s (%s) [%05d]%s", WORD, WORD, WORD,
+		regions[rand() % 4], i, rand() % 4 ? ".iso" : rand() % 2 ? " (Disc 2).iso" : ".nkit.iso");
+}
+
+static bool build(void)
+{
+	static u8 work[FF_MAX_SS];
+	char name[PATHNAME_MAX];
+	FIL fp;
+
+	memset(disk, 0, DISK_SECTORS * 512);
+	if (f_mkfs(VOLUME, &(MKFS_PARM){.fmt = FM_FAT | FM_SFD}, work, sizeof(work)) != FR_OK)
+		return false;
+	if (f_mount(&fs, VOLUME, 1) != FR_OK || f_mkdir(PATH) != FR_OK)
+		return false;
+
+	for (int i = 0; i < FILES; i++) {
+		snprintf(name, sizeof(name), "%s/", PATH);
+		file_name(name + strlen(name), i);
+		if (f_open(&fp, name, FA_CREATE_NEW | FA_WRITE) != FR_OK)
+			return false;
+		f_lseek(&fp, i * 37 % 4096);
+		f_close(&fp);
+	}
+	return true;
+}
+
+// Listing
+
+static void reserveDirEntry(file_handle_old **dir, int *numEntries, int num)
+{
+	if (num >= *numEntries) {
+		*numEntries = MAX(*numEntries * 2, num + 1);
+		*dir = reallocarray(*dir, *numEntries, sizeof(file_handle_old));
+	}
+}
+
+static void trimDirEntries(file_handle_old **dir, int num)
+{
+	file_handle_old *trimmed = reallocarray(*dir, MAX(num, 1), sizeof(file_handle_old));
+	if (trimmed) *dir = trimmed;
+}
+
+// As deviceHandler_FAT_readDir did it
+static int readDirOld(const char *path, file_handle_old **dir)
+{
+	DIRF dp;
+	FILINFO entry;
+
+	if (f_opendir(&dp, path) != FR_OK)
+		return -1;
+	int num_entries = 1, i = 1;
+	*dir = calloc(num_entries, sizeof(file_handle_old));
+	snprintf((*dir)[0].name, PATHNAME_MAX, "%s/..", path);
+	(*dir)[0].fileAttrib = IS_SPECIAL;
+
+	while (f_readdir(&dp, &entry) == FR_OK && entry.fname[0] != '\0') {
+		reserveDirEntry(dir, &num_entries, i);
+		memset(&(*dir)[i], 0, sizeof(file_handle_old));
+		if (snprintf((*dir)[i].name, PATHNAME_MAX, "%s/%s", path, entry.fname) < PATHNAME_MAX) {
+			(*dir)[i].size       = entry.fsize;
+			(*dir)[i].fileAttrib = (entry.fattrib & AM_DIR) ? IS_DIR : IS_FILE;
+			++i;
+		}
+	}
+	f_closedir(&dp);
+	trimDirEntries(dir, i);
+	return i;
+}
+
+// As deviceHandler_FAT_readDir does it
+static int readDir(const char *path, dir_list *dir)
+{
+	DIRF dp;
+	FILINFO entry;
+	char name[PATHNAME_MAX];
+
+	if (f_opendir(&dp, path) != FR_OK)
+		return -1;
+	snprintf(name, sizeof(name), "%s/..", path);
+	if (!addDirEntry(dir, name, IS_SPECIAL))
+		goto fail;
+
+	while (f_readdir(&dp, &entry) == FR_OK && entry.fname[0] != '\0') {
+		if (snprintf(name, sizeof(name), "%s/%s", path, entry.fname) < PATHNAME_MAX) {
+			file_handle *file = addDirEntry(dir, name, (entry.fattrib & AM_DIR) ? IS_DIR : IS_FILE);
+			if (!file)
+				goto fail;
+			file->size = entry.fsize;
+		}
+	}
+	f_closedir(&dp);
+	return dir->num;
+
+fail:
+	f_closedir(&dp);
+	freeDirList(dir);
+	return -1;
+}
+
+// Every file has to be listed once, with its size, after the parent
+static bool check(int count, const char *(*name_of)(int), u32 (*size_of)(int), int files)
+{
+	static bool seen[FILES];
+	char name[PATHNAME_MAX];
+
+	if (count != files + 1 || strcmp(name_of(0), PATH "/.."))
+		return false;
+	memset(seen, 0, sizeof(seen));
+	for (int i = 1; i < count; i++) {
+		int index;
+		const char *bracket = strrchr(name_of(i), '[');
+		if (!bracket || sscanf(bracket, "[%d]", &index) != 1 || index < 0 || index >= files || seen[index])
+			return false;
+		snprintf(name, sizeof(name), "%s/", PATH);
+		file_name(name + strlen(name), index);
+		if (strcmp(name, name_of(i)) || size_of(i) != (u32)(index * 37 % 4096))
+			return false;
+		seen[index] = true;
+	}
+	return true;
+}
+
+static file_handle_old *oldDir;
+static dir_list newDir;
+
+static const char *oldName(int i) { return oldDir[i].name; }
+static u32 oldSize(int i) { return oldDir[i].size; }
+static const char *newName(int i) { return newDir.entry[i]->name; }
+static u32 newSize(int i) { return newDir.entry[i]->size; }
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static bool list(int files)
+{
+	double timeOld = 1e9, timeNew = 1e9;
+	size_t peakOld = 0, peakNew = 0;
+	bool ok = true;
+
+	for (int run = 0; run < RUNS; run++) {
+		heap.peak = heap.live;
+		size_t base = heap.live;
+		double start = now();
+		int count = readDirOld(PATH, &oldDir);
+		timeOld = MIN(timeOld, now() - start);
+		peakOld = heap.peak - base;
+		ok &= check(count, oldName, oldSize, files);
+		free(oldDir);
+
+		heap.peak = heap.live;
+		start = now();
+		count = readDir(PATH, &newDir);
+		timeNew = MIN(timeNew, now() - start);
+		peakNew = heap.peak - base;
+		ok &= check(count, newName, newSize, files);
+		freeDirList(&newDir);
+		ok &= heap.live == base;
+	}
+
+	printf("%5d files: peak %6.2fMB, %4zu bytes per entry, %6.2fms, previously %6.2fMB, %4zu bytes per entry, %6.2fms: %s\n",
+		files, peakNew / 1048576., peakNew / (files + 1), timeNew * 1e3,
+		peakOld / 1048576., peakOld / (files + 1), timeOld * 1e3, ok ? "ok" : "FAILED");
+	return ok;
+}
+
+// Fails each allocation of a listing in turn, until one gets through
+static bool outOfMemory(void)
+{
+	size_t base = heap.live;
+	int failures = 0, points;
+
+	for (points = 0;; points++) {
+		heap.allocations = 0;
+		heap.failAt = points;
+		int count = readDir(PATH, &newDir);
+		heap.failAt = -1;
+		if (count >= 0) {
+			failures += !check(count, newName, newSize, SMALL);
+			freeDirList(&newDir);
+			break;
+		}
+		failures += newDir.num || newDir.entry || newDir.chunks || heap.live != base;
+	}
+
+	printf("%d files, out of memory at each of %d allocations: %s\n", SMALL, points, failures ? "FAILED" : "ok");
+	return !failures;
+}
+
+int main(int argc, char *argv[])
+{
+	bool passed = true;
+
+	heap.failAt = -1;
+	disk = calloc(DISK_SECTORS, 512);
+	if (!disk)
+		return 1;
+
+	if (!build())
+		return 1;
+	passed &= list(FILES);
+
+	// Down to the first SMALL files
+	for (int i = SMALL; i < FILES; i++) {
+		char name[PATHNAME_MAX];
+		snprintf(name, sizeof(name), "%s/", PATH);
+		file_name(name + strlen(name), i);
+		if (f_unlink(name) != FR_OK)
+			return 1;
+	}
+	passed &= list(SMALL);
+	passed &= outOfMemory();
+
+	f_unmount(VOLUME);
+	free(disk);
+	return !passed;
+}
@@ -0,0 +1,433 @@
+/* main.c
+	- replays a DI trace captured from the patches against a disc image
+ */
+
+// Build the patches with "make DI_TRACE=1" and log the USB Gecko output of a
+// game session to a file. This reads the records back, pushes every read and
+// seek through the same block device read path (blockdevice.c), read speed
+// model (emulator_dvd.c, DVDMath.c) and frag lookup (frag.c) the patches use,
+// reading the data from the disc image, and reports what the console measured
+// next to what the model decided.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "emulator.h"
+#include "frag.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+#define TRACE_RECORD_SIZE 32
+#define TRACE_MAX_FILES   256
+
+// As sent by di_trace, big endian with 4 bytes of padding before the time
+typedef struct {
+	uint32_t type;
+	uint32_t args[4];
+	OSTime time;
+} trace_record;
+
+typedef struct {
+	bool valid;
+	bool replayed;
+	OSTime issued;
+	uint32_t command;
+	uint32_t offset;
+	uint32_t length;
+	int lookups, misses;
+	int host_lookups, host_misses;
+	bool scheduled, host_scheduled;
+	uint32_t schedule[4], host_schedule[4];
+} di_command;
+
+static struct {
+	int reads, seeks, others, errors, unmatched;
+	uint64_t bytes, short_reads, stalled;
+	uint64_t latency_total, latency_max;
+	uint64_t model_total, model_max;
+	int compared, mismatched;
+	uint64_t drift_total, drift_max;
+	int lookups, misses, host_lookups, host_misses;
+	int file_lookups[TRACE_MAX_FILES], file_misses[TRACE_MAX_FILES];
+	int skipped;
+} stats;
+
+static di_command current;
+static int image_fd = -1;
+static bool verbose;
+static bool transferred;
+static OSTick tolerance = OSMicrosecondsToTicks(100);
+
+OSAlarm read_alarm;
+
+// The patches read the disc through the frag list, here a single frag
+// spanning the whole image stands in for the device. Anything past the end
+// of the image reads as zeros so that the transfer still completes.
+bool do_read_write_async(void *buffer, uint32_t length, uint32_t offset, uint64_t sector, bool write, frag_callback callback)
+{
+	if (write)
+		return false;
+
+	ssize_t ret = pread(image_fd, buffer, length, offset);
+	if (ret < 0)
+		ret = 0;
+	if ((size_t)ret < length) {
+		memset(buffer + ret, 0, length - ret);
+		stats.short_reads++;
+	}
+	stats.bytes += ret;
+
+	callback(buffer, length);
+	return true;
+}
+
+void di_complete_transfer()
+{
+	transferred = true;
+}
+
+void ipl_set_config(uint8_t config)
+{
+}
+
+void di_trace(uint32_t type, uint32_t arg0, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+{
+	switch (type) {
+		case DI_TRACE_SCHEDULE:
+			current.host_scheduled = true;
+			current.host_schedule[0] = arg0;
+			current.host_schedule[1] = arg1;
+			current.host_schedule[2] = arg2;
+			current.host_schedule[3] = arg3;
+			break;
+		case DI_TRACE_FRAG:
+			current.host_lookups++;
+			if (arg3 == (uint32_t)-1)
+				current.host_misses++;
+			break;
+	}
+}
+
+static double ticks_to_ms(uint64_t ticks)
+{
+	return OSTicksToMicroseconds(ticks) / 1000.0;
+}
+
+static uint32_t get_be32(const uint8_t *p)
+{
+	return (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+static bool parse_record(const uint8_t *p, trace_record *record)
+{
+	record->type = get_be32(p);
+
+	switch (record->type) {
+		case DI_TRACE_COMMAND:
+		case DI_TRACE_COMPLETE:
+		case DI_TRACE_SCHEDULE:
+		case DI_TRACE_FRAG:
+			break;
+		default:
+			return false;
+	}
+
+	for (int i = 0; i < 4; i++)
+		record->args[i] = get_be32(p + 4 + i * 4);
+
+	record->time = (OSTime)get_be32(p + 24) << 32 | get_be32(p + 28);
+	return true;
+}
+
+static void start_command(const trace_record *record)
+{
+	memset(&current, 0, sizeof(current));
+	current.valid   = true;
+	current.issued  = record->time;
+	current.command = record->args[0] >> 24;
+	current.offset  = record->args[1] << 2;
+	current.length  = record->args[3];
+
+	switch (current.command) {
+		case DI_CMD_READ:
+			stats.reads++;
+			break;
+		case DI_CMD_SEEK:
+			stats.seeks++;
+			current.length = 0;
+			break;
+		default:
+			stats.others++;
+			current.replayed = true;
+			break;
+	}
+}
+
+// Runs a read or seek through the model, at the time the console did if the
+// trace shows it, so that the read buffer and disc rotation line up.
+static void replay_read(OSTime time)
+{
+	if (current.replayed)
+		return;
+	current.replayed = true;
+
+	if (current.length > HOST_RAM_SIZE) {
+		stats.stalled++;
+		return;
+	}
+
+	host_time = time;
+	transferred = false;
+	perform_read(0, current.length, current.offset);
+	host_run_alarms();
+
+	if (!transferred)
+		stats.stalled++;
+}
+
+static void compare_schedule(void)
+{
+	if (!current.scheduled || !current.host_scheduled)
+		return;
+
+	OSTick drift = abs(OSDiffTick(current.schedule[3], current.host_schedule[3]));
+
+	stats.compared++;
+	stats.drift_total += drift;
+	if (drift > stats.drift_max)
+		stats.drift_max = drift;
+
+	if (current.schedule[0] != current.host_schedule[0] ||
+		current.schedule[1] != current.host_schedule[1] ||
+		abs(OSDiffTick(current.schedule[2], current.host_schedule[2])) > tolerance ||
+		drift > tolerance) {
+		stats.mismatched++;
+
+		if (verbose)
+			printf("  schedule mismatch: buffer %08X-%08X, %.3f/%.3f ms on the console, "
+				"buffer %08X-%08X, %.3f/%.3f ms replayed\n",
+				current.schedule[0], current.schedule[1],
+				ticks_to_ms(current.schedule[2]), ticks_to_ms(current.schedule[3]),
+				current.host_schedule[0], current.host_schedule[1],
+				ticks_to_ms(current.host_schedule[2]), ticks_to_ms(current.host_schedule[3]));
+	}
+}
+
+static void complete_command(const trace_record *record, OSTime start)
+{
+	if (!current.valid) {
+		stats.unmatched++;
+		return;
+	}
+
+	replay_read(current.issued);
+
+	uint64_t latency = record->time - current.issued;
+	uint64_t model = current.host_scheduled ? current.host_schedule[3] : 0;
+
+	if (record->args[1])
+		stats.errors++;
+
+	stats.latency_total += latency;
+	if (latency > stats.latency_max)
+		stats.latency_max = latency;
+	stats.model_total += model;
+	if (model > stats.model_max)
+		stats.model_max = model;
+
+	stats.lookups      += current.lookups;
+	stats.misses       += current.misses;
+	stats.host_lookups += current.host_lookups;
+	stats.host_misses  += current.host_misses;
+
+	if (verbose)
+		printf("%12.3f ms  %02X %08X %8X  latency %8.3f ms  model %8.3f ms  frags %d/%d, %d/%d replayed%s\n",
+			ticks_to_ms(current.issued - start), current.command, current.offset, current.length,
+			ticks_to_ms(latency), ticks_to_ms(model),
+			current.lookups, current.misses, current.host_lookups, current.host_misses,
+			record->args[1] ? "  error" : "");
+
+	compare_schedule();
+	current.valid = false;
+}
+
+static void replay(const uint8_t *trace, size_t size)
+{
+	trace_record record;
+	OSTime start = 0;
+	bool started = false;
+
+	for (size_t i = 0; i + TRACE_RECORD_SIZE <= size; ) {
+		// Anything else logged to the USB Gecko is skipped over
+		if (!parse_record(trace + i, &record)) {
+			stats.skipped++;
+			i++;
+			continue;
+		}
+		i += TRACE_RECORD_SIZE;
+
+		if (!started) {
+			start = record.time;
+			started = true;
+		}
+
+		switch (record.type) {
+			case DI_TRACE_COMMAND:
+				if (current.valid) {
+					replay_read(current.issued);
+					stats.unmatched++;
+				}
+				start_command(&record);
+				break;
+			case DI_TRACE_SCHEDULE:
+				if (current.valid) {
+					replay_read(record.time);
+					current.scheduled = true;
+					memcpy(current.schedule, record.args, sizeof(record.args));
+				}
+				break;
+			case DI_TRACE_FRAG:
+				if (record.args[0] < TRACE_MAX_FILES) {
+					stats.file_lookups[record.args[0]]++;
+					if (record.args[3] == (uint32_t)-1)
+						stats.file_misses[record.args[0]]++;
+				}
+				if (current.valid) {
+					current.lookups++;
+					if (record.args[3] == (uint32_t)-1)
+						current.misses++;
+				}
+				break;
+			case DI_TRACE_COMPLETE:
+				complete_command(&record, start);
+				break;
+		}
+	}
+
+	if (current.valid) {
+		replay_read(current.issued);
+		stats.unmatched++;
+	}
+}
+
+static void report(void)
+{
+	int completed = stats.reads + stats.seeks + stats.others - stats.unmatched;
+
+	printf("commands:     %d reads, %d seeks, %d other, %d errors, %d unmatched\n",
+		stats.reads, stats.seeks, stats.others, stats.errors, stats.unmatched);
+	printf("image:        %llu bytes read, %llu short reads, %llu stalled\n",
+		(unsigned long long)stats.bytes, (unsigned long long)stats.short_reads,
+		(unsigned long long)stats.stalled);
+
+	if (completed > 0) {
+		printf("latency:      %.3f ms mean, %.3f ms max\n",
+			ticks_to_ms(stats.latency_total / completed), ticks_to_ms(stats.latency_max));
+		printf("model:        %.3f ms mean, %.3f ms max\n",
+			ticks_to_ms(stats.model_total / completed), ticks_to_ms(stats.model_max));
+	}
+
+	if (stats.compared > 0)
+		printf("schedule:     %d compared, %d outside %.3f ms, %.3f ms mean drift, %.3f ms max\n",
+			stats.compared, stats.mismatched, ticks_to_ms(tolerance),
+			ticks_to_ms(stats.drift_total / stats.compared), ticks_to_ms(stats.drift_max));
+	else
+		printf("schedule:     no read speed decisions in the trace\n");
+
+	printf("frag lookups: %d (%d missed) on the console, %d (%d missed) replayed\n",
+		stats.lookups, stats.misses, stats.host_lookups, stats.host_misses);
+
+	for (int i = 0; i < TRACE_MAX_FILES; i++)
+		if (stats.file_lookups[i])
+			printf("  file %3d:   %d lookups, %d missed\n", i, stats.file_lookups[i], stats.file_misses[i]);
+
+	if (stats.skipped)
+		printf("skipped %d bytes of other output\n", stats.skipped);
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "usage: %s [-v] [-d disc] [-r speed] [-t usec] <trace> <image>\n", name);
+	fprintf(stderr, "  -v        print every command\n");
+	fprintf(stderr, "  -d disc   disc number the trace was read from (default 1)\n");
+	fprintf(stderr, "  -r speed  emulated read speed setting (default 2)\n");
+	fprintf(stderr, "  -t usec   schedule tolerance (default 100)\n");
+}
+
+int main(int argc, char *argv[])
+{
+	int opt;
+	int disc = 1;
+	int speed = 2;
+
+	while ((opt = getopt(argc, argv, "vd:r:t:")) != -1) {
+		switch (opt) {
+			case 'v': verbose = true; break;
+			case 'd': disc = atoi(optarg); break;
+			case 'r': speed = atoi(optarg); break;
+			case 't': tolerance = OSMicrosecondsToTicks(atoi(optarg)); break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if (argc - optind != 2 || disc < 1 || disc > 2) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	FILE *fp = fopen(argv[optind], "rb");
+	if (!fp) {
+		perror(argv[optind]);
+		return 1;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	size_t size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	uint8_t *trace = malloc(size ? size : 1);
+	if (!trace || fread(trace, 1, size, fp) != size) {
+		fprintf(stderr, "%s: read failed\n", argv[optind]);
+		return 1;
+	}
+	fclose(fp);
+
+	image_fd = open(argv[optind + 1], O_RDONLY | O_BINARY);
+	if (image_fd < 0) {
+		perror(argv[optind + 1]);
+		return 1;
+	}
+
+	struct stat st;
+	fstat(image_fd, &st);
+
+	static frag_t frags[2];
+	frags[0].offset = 0;
+	frags[0].size   = st.st_size;
+	frags[0].file   = disc - 1;
+	host_frag_list = frags;
+
+	*VAR_CURRENT_DISC = disc - 1;
+	*VAR_EMU_READ_SPEED = speed;
+
+	if (pread(image_fd, VAR_AREA, sizeof(DVDDiskID), 0) != sizeof(DVDDiskID)) {
+		fprintf(stderr, "%s: not a disc image\n", argv[optind + 1]);
+		return 1;
+	}
+
+	replay(trace, size);
+	report();
+
+	free(trace);
+	close(image_fd);
+	return 0;
+}
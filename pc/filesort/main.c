@@ -0,0 +1,210 @@
+/* main.c
+	- times sortFiles' key sort against the qsort it replaced
+ */
+
+// Directory listings of 10k synthetic entries are sorted both by the old
+// fileComparator over file handles laid out as in deviceHandler.h, and by
+// building a key per entry and sorting the keys as sortFiles does. The keyed
+// order has to match a plain comparison sort by class, natural name order,
+// exact name and directory position.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <sys/param.h>
+#include "filesort.h"
+
+#define PATHNAME_MAX 1024
+#define DISC_SIZE    1459978240
+#define ENTRIES      10000
+#define RUNS         25
+
+enum {
+	IS_FILE = 0,
+	IS_DIR,
+	IS_SPECIAL
+};
+
+// Same layout as in deviceHandler.h, so that the old comparator strides through memory alike
+typedef struct {
+	uint64_t fileBase;
+	u32 offset;
+	u32 size;
+	s32 fileAttrib;
+	s32 status;
+	void *fp;
+	void *ffsFp;
+	void *meta;
+	u8 other[128];
+	void *uiObj;
+	volatile u32 lockCount;
+	u32 thread;
+	char name[PATHNAME_MAX];
+} file_handle;
+
+static bool discFirst;
+
+static int fileComparator(const void *a1, const void *b1)
+{
+	const file_handle* a = *(const file_handle **)a1;
+	const file_handle* b = *(const file_handle **)b1;
+
+	if(discFirst)
+	{
+		if(a->size == DISC_SIZE && a->fileBase == 0)
+			return -1;
+		if(b->size == DISC_SIZE && b->fileBase == 0)
+			return 1;
+	}
+
+	if(a->fileAttrib != b->fileAttrib)
+		return b->fileAttrib - a->fileAttrib;
+
+	return strcasecmp(a->name, b->name);
+}
+
+static file_handle *dir;
+static file_handle **sorted;
+static file_sort_key *keys;
+
+static void sortOld(int count)
+{
+	for(int i = 0; i < count; i++)
+		sorted[i] = &dir[i];
+	qsort(sorted, count, sizeof(*sorted), fileComparator);
+}
+
+static u8 classOf(const file_handle *file)
+{
+	return discFirst && file->size == DISC_SIZE && file->fileBase == 0 ? 0 : 255 - MIN((u32)file->fileAttrib, 254);
+}
+
+// As sortFiles does it
+static void sortNew(int count)
+{
+	size_t common = count ? strlen(dir[0].name) : 0;
+	for(int i = 1; i < count && common; i++) {
+		size_t len = 0;
+		while(len < common && dir[i].name[len] == dir[0].name[len]) len++;
+		common = len;
+	}
+	while(common && dir[0].name[common - 1] != '/') common--;
+
+	for(int i = 0; i < count; i++)
+		makeSortKey(&keys[i], dir[i].name + common, classOf(&dir[i]), i);
+
+	sortKeys(keys, keys + count, count);
+	for(int i = 0; i < count; i++)
+		sorted[i] = &dir[keys[i].index];
+}
+
+static int compareReference(const void *a1, const void *b1)
+{
+	const file_handle *a = *(const file_handle **)a1;
+	const file_handle *b = *(const file_handle **)b1;
+
+	if(classOf(a) != classOf(b))
+		return classOf(a) < classOf(b) ? -1 : 1;
+
+	int ret = naturalCompare(a->name, b->name);
+	if(!ret) ret = strcmp(a->name, b->name);
+	if(!ret) ret = a < b ? -1 : 1;
+	return ret;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double best(void (*sort)(int), int count)
+{
+	double best = 1e9;
+
+	for(int run = 0; run < RUNS; run++) {
+		double start = now();
+		sort(count);
+		double time = now() - start;
+		if(time < best) best = time;
+	}
+	return best * 1e3;
+}
+
+static const char *words[] = {
+	"Zelda", "zelda", "Mario Kart", "Disc ", "Game_", "a-b", "Pikmin ", "Metroid",
+	"Star Fox", "F-Zero", "Super Smash Bros.", "Animal Crossing", "Luigi's Mansion",
+	"Paper Mario", "Wave Race", "1080", "Tales of Symphonia", "Resident Evil", "Ikaruga"
+};
+
+#define WORD (words[rand() % (sizeof(words) / sizeof(*words))])
+
+// Few names, told apart by numbers late in the name
+static void numbered(file_handle *file, int i)
+{
+	snprintf(file->name, PATHNAME_MAX, "sd:/games/%s%d%s%d", WORD, rand() % 200, rand() % 3 ? " (Disc 2).iso" : ".gcm", i);
+}
+
+// Titles as a game library would have them
+static void titles(file_handle *file, int i)
+{
+	static const char *regions[] = {"USA", "Europe", "Japan", "USA, Europe"};
+	snprintf(file->name, PATHNAME_MAX, "sd:/games/%s %s - %s (%s)%s", WORD, WORD, WORD,
+		regions[rand() % 4], rand() % 4 ? ".iso" : rand() % 2 ? " (Disc 2).iso" : ".nkit.iso");
+}
+
+// One long digit run, with and without leading zeros
+static void serials(file_handle *file, int i)
+{
+	snprintf(file->name, PATHNAME_MAX, "sd:/dump/%0*d%s", rand() % 12, rand() % 100000, rand() % 2 ? ".raw" : ".RAW");
+}
+
+static bool run(const char *name, void (*make)(file_handle *, int))
+{
+	static file_handle *reference[ENTRIES];
+	bool passed;
+
+	srand(1);
+	memset(dir, 0, ENTRIES * sizeof(*dir));
+	for(int i = 0; i < ENTRIES; i++) {
+		make(&dir[i], i);
+		dir[i].fileAttrib = rand() % 10 ? IS_FILE : IS_DIR;
+		dir[i].size = rand() % 100 ? rand() : DISC_SIZE;
+	}
+
+	double timeOld = best(sortOld, ENTRIES);
+	double timeNew = best(sortNew, ENTRIES);
+
+	for(int i = 0; i < ENTRIES; i++)
+		reference[i] = &dir[i];
+	qsort(reference, ENTRIES, sizeof(*reference), compareReference);
+	sortNew(ENTRIES);
+	passed = !memcmp(reference, sorted, sizeof(reference));
+
+	printf("%-10s %d entries: qsort %.2fms, keys %.2fms, order %s\n",
+		name, ENTRIES, timeOld, timeNew, passed ? "ok" : "FAILED");
+	return passed;
+}
+
+int main(int argc, char *argv[])
+{
+	bool passed = true;
+
+	dir = calloc(ENTRIES, sizeof(*dir));
+	sorted = calloc(ENTRIES, sizeof(*sorted));
+	keys = calloc(ENTRIES * 2, sizeof(*keys));
+	if(!dir || !sorted || !keys)
+		return 1;
+
+	for(int disc = 0; disc < 2; disc++) {
+		discFirst = disc;
+		passed &= run("numbered", numbered);
+		passed &= run("titles", titles);
+		passed &= run("serials", serials);
+	}
+
+	return !passed;
+}
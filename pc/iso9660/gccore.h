@@ -0,0 +1,22 @@
+/* gccore.h
+	- host stand-in for the libogc types dvd.h needs
+ */
+
+#ifndef __GCCORE_H__
+#define __GCCORE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t   s8;
+typedef int16_t  s16;
+typedef int32_t  s32;
+typedef int64_t  s64;
+
+typedef struct _dvddiskid dvddiskid;
+
+#endif
@@ -0,0 +1,258 @@
+/* main.c
+	- browses ISO9660 images in memory through the DVD directory reader
+ */
+
+// A plain ISO9660 image and one with a Joliet descriptor are built with 40
+// directories under the root, from a few entries to several sectors each, more
+// than the directory cache holds. The root and then each directory are listed
+// three times over through iso9660.c, as the file browser does, and every
+// listing has to match what was written. Drive requests are counted next to
+// the sectors they moved.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "dvd.h"
+
+#define SECTOR       2048
+#define ROOT_SECTOR  20
+#define DIRS         40
+#define FILE_SECTOR  5000
+#define IMAGE_SIZE   (FILE_SECTOR * SECTOR)
+
+typedef struct {
+	int sector;
+	int size;
+	int entries;
+} directory;
+
+static unsigned char *image;
+static directory dirs[DIRS];
+static int rootSize;
+static bool joliet;
+
+static struct {
+	int requests;
+	int sectors;
+} test;
+
+int read_sector(void* buffer, int numSectors, u32 sector)
+{
+	test.requests++;
+	test.sectors += numSectors;
+	if ((sector + numSectors) * SECTOR > IMAGE_SIZE)
+		return -1;
+	memcpy(buffer, image + sector * SECTOR, numSectors * SECTOR);
+	return numSectors * SECTOR;
+}
+
+static void put_both32(unsigned char *p, u32 value)
+{
+	for (int i = 0; i < 4; i++) {
+		p[i] = value >> (8 * i);
+		p[7 - i] = value >> (8 * i);
+	}
+}
+
+static void put_both16(unsigned char *p, u16 value)
+{
+	p[0] = p[3] = value;
+	p[1] = p[2] = value >> 8;
+}
+
+static int entries_of(int dir)
+{
+	return dir % 3 ? 4 + dir % 5 : 200 + dir * 16;
+}
+
+static void file_name(char *name, int dir, int file)
+{
+	if (dir < 0)
+		sprintf(name, "DIR%02d", file);
+	else
+		sprintf(name, "F%02d_%03d.BIN", dir, file);
+}
+
+// Writes a directory record and returns its length, or only measures it with no buffer
+static int record(unsigned char *p, u32 sector, u32 size, int flags, const char *name)
+{
+	unsigned char id[128];
+	int nl;
+
+	if (name[0] < ' ') {
+		id[0] = name[0];
+		nl = 1;
+	} else if (joliet) {
+		nl = 0;
+		for (const char *c = name; *c; c++) {
+			id[nl++] = 0;
+			id[nl++] = *c;
+		}
+		if (!(flags & 2)) {
+			memcpy(id + nl, "\0;\0" "1", 4);
+			nl += 4;
+		}
+	} else {
+		nl = sprintf((char *)id, flags & 2 ? "%s" : "%s;1", name);
+	}
+
+	int length = 33 + nl + !(nl & 1);
+	if (p) {
+		memset(p, 0, length);
+		p[0] = length;
+		put_both32(p + 2, sector);
+		put_both32(p + 10, size);
+		p[25] = flags;
+		put_both16(p + 28, 1);
+		p[32] = nl;
+		memcpy(p + 33, id, nl);
+	}
+	return length;
+}
+
+// Lays out or writes a directory extent, records don't cross sectors. Returns its size.
+static int write_directory(unsigned char *p, int self, int selfSize, int parent, int parentSize, int dir)
+{
+	int count = dir < 0 ? DIRS + 1 : entries_of(dir);
+	int offset = 0;
+
+	for (int i = -2; i < count; i++) {
+		char name[32];
+		u32 sector, size;
+		int flags = 0;
+
+		if (i == -2) {
+			strcpy(name, "\0");
+			sector = self, size = selfSize, flags = 2;
+		} else if (i == -1) {
+			strcpy(name, "\1");
+			sector = parent, size = parentSize, flags = 2;
+		} else if (dir < 0 && i < DIRS) {
+			file_name(name, dir, i);
+			sector = dirs[i].sector, size = dirs[i].size, flags = 2;
+		} else if (dir < 0) {
+			strcpy(name, "README.TXT");
+			sector = FILE_SECTOR, size = 5;
+		} else {
+			file_name(name, dir, i);
+			sector = FILE_SECTOR + i, size = 1000 + i;
+		}
+
+		int length = record(NULL, 0, 0, flags, name);
+		if (offset % SECTOR + length > SECTOR)
+			offset += SECTOR - offset % SECTOR;
+		if (p)
+			record(p + offset, sector, size, flags, name);
+		offset += length;
+	}
+	return (offset + SECTOR - 1) / SECTOR * SECTOR;
+}
+
+static void build(void)
+{
+	int sector;
+
+	memset(image, 0, IMAGE_SIZE);
+
+	rootSize = write_directory(NULL, 0, 0, 0, 0, -1);
+	sector = ROOT_SECTOR + rootSize / SECTOR;
+	for (int i = 0; i < DIRS; i++) {
+		dirs[i].sector = sector;
+		dirs[i].size = write_directory(NULL, 0, 0, 0, 0, i);
+		dirs[i].entries = entries_of(i);
+		sector += dirs[i].size / SECTOR;
+	}
+
+	write_directory(image + ROOT_SECTOR * SECTOR, ROOT_SECTOR, rootSize, ROOT_SECTOR, rootSize, -1);
+	for (int i = 0; i < DIRS; i++)
+		write_directory(image + dirs[i].sector * SECTOR, dirs[i].sector, dirs[i].size, ROOT_SECTOR, rootSize, i);
+
+	unsigned char *descriptor = image + 16 * SECTOR;
+	memcpy(descriptor, joliet ? "\2CD001\1" : "\1CD001\1", 8);
+	record(descriptor + 156, ROOT_SECTOR, rootSize, 2, "\0");
+	memcpy(descriptor + SECTOR, "\xFF" "CD001\1", 7);
+}
+
+static bool check_entry(int index, const char *name, int sector, int size, int flags)
+{
+	file_entry *entry = &DVDToc->file[index];
+
+	return !strcmp(entry->name, name) && entry->sector == sector && entry->size == size && entry->flags == flags;
+}
+
+static bool check_root(int count)
+{
+	char name[32];
+
+	if (count != DIRS + 1)
+		return false;
+	for (int i = 0; i < DIRS; i++) {
+		file_name(name, -1, i);
+		strcat(name, "/");
+		if (!check_entry(i, name, dirs[i].sector, dirs[i].size, 2))
+			return false;
+	}
+	return check_entry(DIRS, "README.TXT", FILE_SECTOR, 5, 0);
+}
+
+// The parent comes first with no name, then the files
+static bool check_directory(int dir, int count)
+{
+	char name[32];
+
+	if (count != dirs[dir].entries + 1 || !check_entry(0, "", ROOT_SECTOR, rootSize, 2))
+		return false;
+	for (int i = 0; i < dirs[dir].entries; i++) {
+		file_name(name, dir, i);
+		if (!check_entry(i + 1, name, FILE_SECTOR + i, 1000 + i, 0))
+			return false;
+	}
+	return true;
+}
+
+static bool browse(const char *name)
+{
+	int failures = 0, listings = 0, directorySectors = rootSize / SECTOR;
+
+	for (int i = 0; i < DIRS; i++)
+		directorySectors += dirs[i].size / SECTOR;
+
+	dvd_clear_dircache();
+	memset(&test, 0, sizeof(test));
+
+	for (int pass = 0; pass < 3; pass++) {
+		failures += !check_root(dvd_read_directoryentries(0, 0));
+		for (int i = 0; i < DIRS; i++) {
+			failures += !check_directory(i, dvd_read_directoryentries((u64)dirs[i].sector * SECTOR, dirs[i].size));
+			failures += !check_root(dvd_read_directoryentries(0, 0));
+			listings += 2;
+		}
+		listings++;
+	}
+
+	printf("%-8s %d listings of %d directory sectors: %d requests for %d sectors: %s\n",
+		name, listings, directorySectors, test.requests, test.sectors, failures ? "FAILED" : "ok");
+	return !failures;
+}
+
+int main(int argc, char *argv[])
+{
+	bool passed = true;
+
+	image = calloc(1, IMAGE_SIZE);
+	if (!image)
+		return 1;
+
+	joliet = false;
+	build();
+	passed &= browse("ISO9660");
+
+	joliet = true;
+	build();
+	passed &= browse("Joliet");
+
+	dvd_clear_dircache();
+	free(image);
+	return !passed;
+}
@@ -0,0 +1,226 @@
+/* audio.c
+	- measures the streaming audio resampler against the averaging it replaced
+ */
+
+// Stereo tones at 48kHz are queued in a FIFO the size of the one the emulator
+// sets aside for streaming audio, and mixed down to 32kHz by mix_samples in
+// blocks as the AI hands them out, with silence underneath at full volume.
+// The same is done by the previous mix_samples, which took every other sample
+// as is and averaged the next two. Tones in the passband are fitted back out
+// of the output, and what is left is the noise and distortion they came with.
+// Tones past 16kHz have no place at 32kHz, so whatever is left of them is
+// aliasing. Both mixers are timed per sample on the host, and at 32kHz the
+// output has to match the input it was given.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "audio.h"
+#include "fifo.h"
+
+#define FIFO_SIZE   7168
+#define BLOCK       160
+#define BLOCKS      400
+#define SETTLE      64
+#define AMPLITUDE   16000
+#define RUNS        200
+
+static uint8_t fifo_buffer[FIFO_SIZE];
+static sample_t silence[BLOCK];
+static sample_t output[BLOCK * BLOCKS];
+
+static inline int_fast16_t clamp(int32_t x)
+{
+	return x < -0x8000 ? -0x8000 : x > 0x7FFF ? 0x7FFF : x;
+}
+
+static void pop_sample(fifo_t *fifo, sample_t *sample)
+{
+	if (fifo_size(fifo) < (int)sizeof(sample_t)) return;
+	*sample = *(sample_t *)fifo->read_ptr;
+
+	fifo->read_ptr += sizeof(sample_t);
+	if (fifo->read_ptr == fifo->end_ptr)
+		fifo->read_ptr = fifo->start_ptr;
+	fifo->used -= sizeof(sample_t);
+}
+
+// The previous mix_samples, as reference
+static void mix_old(volatile sample_t *out, volatile sample_t *in, fifo_t *fifo, resampler_t *resampler, int count, bool _3to2, uint8_t volume_l, uint8_t volume_r)
+{
+	for (int i = 0; i < count; i++) {
+		sample_t sample = {0};
+		pop_sample(fifo, &sample);
+		int_fast16_t r = sample.r;
+		int_fast16_t l = sample.l;
+
+		if (i & _3to2) {
+			pop_sample(fifo, &sample);
+			r = (r + sample.r) >> 1;
+			l = (l + sample.l) >> 1;
+		}
+
+		sample = in[i];
+		r = (r * volume_r >> 8) + sample.r;
+		l = (l * volume_l >> 8) + sample.l;
+
+		sample.r = clamp(r);
+		sample.l = clamp(l);
+		out[i] = sample;
+	}
+}
+
+typedef void (*mixer)(volatile sample_t *, volatile sample_t *, fifo_t *, resampler_t *, int, bool, uint8_t, uint8_t);
+
+// The left channel carries the tone, the right its phase opposite at half the level
+static sample_t tone(double freq, int n)
+{
+	double x = AMPLITUDE * sin(2 * M_PI * freq * n / 48000);
+	return (sample_t){.r = lrint(-x / 2), .l = lrint(x)};
+}
+
+// Mixes a tone at 48kHz down to 32kHz into output, returns the number of samples
+static int mix(mixer mix_samples, double freq, bool _3to2)
+{
+	static resampler_t resampler;
+	fifo_t fifo;
+	int in = 0, out = 0;
+
+	fifo_init(&fifo, fifo_buffer, FIFO_SIZE);
+	resampler_reset(&resampler);
+
+	for (int block = 0; block < BLOCKS; block++) {
+		while (fifo_space(&fifo) >= (int)sizeof(sample_t)) {
+			sample_t sample = tone(freq, in++);
+			fifo_write(&fifo, &sample, sizeof(sample));
+		}
+		mix_samples(output + out, silence, &fifo, &resampler, BLOCK, _3to2, 0xFF, 0xFF);
+		out += BLOCK;
+	}
+	return out;
+}
+
+// Fits a tone at freq to the left channel past the settling time, and returns
+// the power of what the fit leaves over that of the tone in dB
+static double residual(int count, double freq, double *gain)
+{
+	double ss = 0, sc = 0, cc = 0, sy = 0, cy = 0, mean = 0, total = 0;
+	double w = 2 * M_PI * freq / 32000;
+	int n = count - SETTLE;
+
+	for (int i = SETTLE; i < count; i++)
+		mean += output[i].l;
+	mean /= n;
+
+	for (int i = SETTLE; i < count; i++) {
+		double s = sin(w * i), c = cos(w * i), y = output[i].l - mean;
+		ss += s * s, sc += s * c, cc += c * c;
+		sy += s * y, cy += c * y;
+		total += y * y;
+	}
+
+	double det = ss * cc - sc * sc;
+	double a = (sy * cc - cy * sc) / det;
+	double b = (cy * ss - sy * sc) / det;
+	double left = 0;
+
+	for (int i = SETTLE; i < count; i++) {
+		double e = output[i].l - mean - a * sin(w * i) - b * cos(w * i);
+		left += e * e;
+	}
+	*gain = sqrt(a * a + b * b) / AMPLITUDE;
+	return 10 * log10(left / (total - left));
+}
+
+// Power left in the output over that of the tone in dB
+static double leakage(int count)
+{
+	double mean = 0, total = 0;
+	int n = count - SETTLE;
+
+	for (int i = SETTLE; i < count; i++)
+		mean += output[i].l;
+	mean /= n;
+	for (int i = SETTLE; i < count; i++)
+		total += (output[i].l - mean) * (output[i].l - mean);
+	return 10 * log10(total / n / (AMPLITUDE * AMPLITUDE / 2.));
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Best time per output sample in ns, with the FIFO kept full
+static double time_mixer(mixer mix_samples)
+{
+	static resampler_t resampler;
+	static sample_t input[FIFO_SIZE / sizeof(sample_t)];
+	double best = 1e9;
+	fifo_t fifo;
+
+	for (int i = 0; i < FIFO_SIZE / (int)sizeof(sample_t); i++)
+		input[i] = tone(1000, i);
+	fifo_init(&fifo, fifo_buffer, FIFO_SIZE);
+	resampler_reset(&resampler);
+
+	for (int run = 0; run < RUNS; run++) {
+		fifo_reset(&fifo);
+		fifo_write(&fifo, input, BLOCK * 3 / 2 * sizeof(sample_t));
+		double start = now();
+		mix_samples(output, silence, &fifo, &resampler, BLOCK, true, 0xFF, 0xFF);
+		double time = now() - start;
+		if (time < best) best = time;
+	}
+	return best * 1e9 / BLOCK;
+}
+
+int main(int argc, char *argv[])
+{
+	static const double passband[] = {1000, 2000, 4000, 6000, 7000, 9000, 10000, 12000, 14000};
+	static const double stopband[] = {18000, 20000, 21000, 22000, 23000, 23500};
+	bool passed = true;
+
+	printf("passband, signal to noise and distortion, and gain:\n");
+	for (size_t i = 0; i < sizeof(passband) / sizeof(*passband); i++) {
+		double freq = passband[i], gainNew, gainOld;
+		double snrNew = -residual(mix(mix_samples, freq, true), freq, &gainNew);
+		double snrOld = -residual(mix(mix_old, freq, true), freq, &gainOld);
+		// Flat to 10kHz, and images held 40dB down to 12kHz
+		bool ok = (freq > 10000 || fabs(20 * log10(gainNew / 0xFF * 0x100)) < 0.1) && (freq > 12000 || snrNew >= 40);
+		printf("%5.0fHz: %5.1fdB %+5.2fdB, previously %5.1fdB %+5.2fdB: %s\n", freq,
+			snrNew, 20 * log10(gainNew / 0xFF * 0x100), snrOld, 20 * log10(gainOld / 0xFF * 0x100), ok ? "ok" : "FAILED");
+		passed &= ok;
+	}
+
+	printf("stopband, aliasing left below 16kHz:\n");
+	for (size_t i = 0; i < sizeof(stopband) / sizeof(*stopband); i++) {
+		double freq = stopband[i];
+		double aliasNew = leakage(mix(mix_samples, freq, true));
+		double aliasOld = leakage(mix(mix_old, freq, true));
+		bool ok = freq < 20000 || aliasNew <= -40;
+		printf("%5.0fHz: %5.1fdB, previously %5.1fdB: %s\n", freq, aliasNew, aliasOld, ok ? "ok" : "FAILED");
+		passed &= ok;
+	}
+
+	// At 32kHz the samples go straight through
+	int count = mix(mix_samples, 1000, false);
+	static sample_t reference[BLOCK * BLOCKS];
+	memcpy(reference, output, sizeof(reference));
+	mix(mix_old, 1000, false);
+	bool ok = count == BLOCK * BLOCKS && !memcmp(reference, output, sizeof(reference));
+	printf("32kHz passthrough: %s\n", ok ? "ok" : "FAILED");
+	passed &= ok;
+
+	double timeNew = time_mixer(mix_samples);
+	double timeOld = time_mixer(mix_old);
+	printf("48kHz to 32kHz: %.2fns per sample, previously %.2fns\n", timeNew, timeOld);
+
+	return !passed;
+}
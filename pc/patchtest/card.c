@@ -0,0 +1,326 @@
+/* card.c
+	- drives the memory card emulation against a card image in memory
+ */
+
+// The card library's commands are issued over EXI as a game would, with the
+// card file fragmented every 4KB and written through a queue that only moves
+// when the test lets it. After each case the image has to match what was
+// written, and the number of writes reaching the device is counted.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "dolphin/exi.h"
+#include "emulator.h"
+#include "emulator_card.h"
+#include "frag.h"
+
+#define CARD_SIZE  0x200000
+#define FRAG_SIZE  0x1000
+#define QUEUE_SIZE 8
+
+#define ARENA_ADDRESS 0x200000
+#define ARENA_SIZE    0x4000
+#define DMA_ADDRESS   0x100000
+
+static uint8_t image[2][CARD_SIZE];
+static uint8_t expected[2][CARD_SIZE];
+
+static struct {
+	int file;
+	void *buffer;
+	uint32_t length;
+	uint32_t offset;
+	bool write;
+	frag_callback callback;
+} queue[QUEUE_SIZE];
+
+static struct {
+	int queued;
+	int pages;
+	int completed[2];
+	int interrupts[2];
+	int writes;
+	int sync_writes;
+	int failures;
+} test;
+
+void exi0_complete_transfer()
+{
+	test.completed[0]++;
+}
+
+void exi1_complete_transfer()
+{
+	test.completed[1]++;
+}
+
+void exi_interrupt(unsigned chan)
+{
+	test.interrupts[chan]++;
+}
+
+static uint32_t frag_length(uint32_t length, uint32_t offset)
+{
+	return MIN(length, FRAG_SIZE - offset % FRAG_SIZE);
+}
+
+bool frag_read_write_async(int file, void *buffer, uint32_t length, uint32_t offset, bool write, frag_callback callback)
+{
+	if (test.queued == QUEUE_SIZE || offset >= CARD_SIZE)
+		return false;
+
+	queue[test.queued].file     = file - FRAGS_CARD(0);
+	queue[test.queued].buffer   = buffer;
+	queue[test.queued].length   = frag_length(length, offset);
+	queue[test.queued].offset   = offset;
+	queue[test.queued].write    = write;
+	queue[test.queued].callback = callback;
+	test.queued++;
+	return true;
+}
+
+int frag_read_write(int file, void *buffer, uint32_t length, uint32_t offset, bool write)
+{
+	if (offset >= CARD_SIZE)
+		return 0;
+
+	length = frag_length(length, offset);
+
+	if (write) {
+		memcpy(image[file - FRAGS_CARD(0)] + offset, buffer, length);
+		test.writes++;
+		test.sync_writes++;
+	} else {
+		memcpy(buffer, image[file - FRAGS_CARD(0)] + offset, length);
+	}
+
+	return length;
+}
+
+// Completes the oldest request on the device, returning false if there was none
+static bool device_step(void)
+{
+	if (!test.queued)
+		return false;
+
+	typeof(queue[0]) request = queue[0];
+	memmove(queue, queue + 1, --test.queued * sizeof(queue[0]));
+
+	uint8_t *data = image[request.file] + request.offset;
+
+	if (request.write) {
+		memcpy(data, request.buffer, request.length);
+		test.writes++;
+	} else {
+		memcpy(request.buffer, data, request.length);
+	}
+
+	request.callback(request.buffer, request.length);
+	return true;
+}
+
+static void device_run(void)
+{
+	while (device_step());
+}
+
+static void check(bool condition, const char *what)
+{
+	if (!condition) {
+		printf("  FAILED: %s\n", what);
+		test.failures++;
+	}
+}
+
+static void command(unsigned chan, uint8_t command, uint32_t offset, int length)
+{
+	card_select(chan);
+	card_imm(chan, command);
+	if (length >= 2) card_imm(chan, offset >> 17);
+	if (length >= 3) card_imm(chan, offset >> 9);
+	if (length >= 4) card_imm(chan, offset >> 7);
+	if (length >= 5) card_imm(chan, offset);
+}
+
+// Issues a DMA and, as the card library does, waits for it to complete
+static void transfer(unsigned chan, uint32_t length, int type)
+{
+	int completed = test.completed[chan];
+
+	if (card_dma(chan, DMA_ADDRESS, length, type)) {
+		while (test.completed[chan] == completed && device_step());
+		check(test.completed[chan] == completed + 1, "transfer completed");
+	}
+}
+
+static void enable_interrupt(unsigned chan)
+{
+	command(chan, 0x81, 0, 1);
+	card_imm(chan, 0x01);
+	card_deselect(chan);
+}
+
+static void write_page(unsigned chan, uint32_t offset)
+{
+	uint8_t *buffer = OSPhysicalToUncached(DMA_ADDRESS);
+
+	for (int i = 0; i < 512; i++)
+		buffer[i] = rand();
+	memcpy(expected[chan] + offset, buffer, 512);
+	test.pages++;
+
+	command(chan, 0xF2, offset, 5);
+	transfer(chan, 512, EXI_WRITE);
+	card_deselect(chan);
+}
+
+static void read_data(unsigned chan, uint32_t offset, uint32_t length)
+{
+	uint8_t *buffer = OSPhysicalToUncached(DMA_ADDRESS);
+
+	command(chan, 0x52, offset, 5);
+	for (int i = 0; i < 4; i++)
+		card_imm(chan, 0x00);
+	transfer(chan, length, EXI_READ);
+	card_deselect(chan);
+
+	check(!memcmp(buffer, expected[chan] + offset, length), "read back what was written");
+}
+
+static void erase_block(unsigned chan, uint32_t offset)
+{
+	command(chan, 0xF1, offset, 3);
+	card_deselect(chan);
+}
+
+static void write_pages(unsigned chan, uint32_t offset, int count)
+{
+	while (count--) {
+		write_page(chan, offset);
+		offset += 512;
+	}
+}
+
+// Lets the card sit idle until any pending flush starts
+static void idle(void)
+{
+	host_run_alarms();
+}
+
+static bool run_case(const char *name, void (*body)(void))
+{
+	int pages = test.pages;
+	int writes = test.writes;
+
+	test.failures = 0;
+	test.sync_writes = 0;
+
+	body();
+	device_run();
+
+	check(!memcmp(image, expected, sizeof(image)), "image matches");
+
+	printf("%-28s %3d pages, %3d device writes (%d synchronous): %s\n",
+		name, test.pages - pages, test.writes - writes, test.sync_writes,
+		test.failures ? "FAILED" : "ok");
+
+	return !test.failures;
+}
+
+static void full_blocks(void)
+{
+	for (int block = 0; block < 32; block++)
+		write_pages(block % 2, (block / 2) * 8192, 16);
+}
+
+static void mixed(void)
+{
+	write_pages(0, 0x40000, 2);
+	read_data(0, 0x40000, 512);
+	write_page(0, 0x40400 + 512 * 3);
+	write_page(1, 0x50000);
+	write_page(0, 0x41000);
+	write_pages(1, 0x60000, 16);
+	read_data(0, 0x40000, 4096);
+	read_data(1, 0x60000, 4096);
+	idle();
+}
+
+static void idle_flush(void)
+{
+	write_pages(0, 0x80000, 5);
+	idle();
+	device_run();
+	check(!memcmp(image[0] + 0x80000, expected[0] + 0x80000, 5 * 512), "written out once idle");
+}
+
+static void read_during_flush(void)
+{
+	write_pages(1, 0x90000, 3);
+	idle();
+	read_data(1, 0x90000, 1024);
+}
+
+static void write_during_flush(void)
+{
+	write_pages(0, 0xA0000, 3);
+	idle();
+	write_pages(0, 0xA0000 + 3 * 512, 13);
+}
+
+static void erase_during_flush(void)
+{
+	int interrupts;
+
+	write_pages(1, 0xB0000, 7);
+	idle();
+	interrupts = test.interrupts[1];
+	erase_block(1, 0xB2000);
+	check(test.interrupts[1] == interrupts, "erase waits for the flush");
+	device_run();
+	check(test.interrupts[1] == interrupts + 1, "erase completes after the flush");
+}
+
+static void fini_gathered(void)
+{
+	write_pages(0, 0xC0000, 9);
+	card_fini();
+	check(test.sync_writes == 2, "gathered block written synchronously");
+}
+
+static void fini_during_flush(void)
+{
+	write_pages(1, 0xD0000, 15);
+	idle();
+	device_step();
+	card_fini();
+	check(test.sync_writes == 1, "only the unfinished part written again");
+
+	// The device is reset after this, whatever was queued is lost
+	test.queued = 0;
+}
+
+int main(int argc, char *argv[])
+{
+	void *arenaLo = OSPhysicalToCached(ARENA_ADDRESS);
+	void *arenaHi = OSPhysicalToCached(ARENA_ADDRESS + ARENA_SIZE);
+	bool passed = true;
+
+	card_init(&arenaLo, &arenaHi);
+	enable_interrupt(0);
+	enable_interrupt(1);
+
+	passed &= run_case("full blocks", full_blocks);
+	passed &= run_case("mixed", mixed);
+	passed &= run_case("idle flush", idle_flush);
+	passed &= run_case("read during idle flush", read_during_flush);
+	passed &= run_case("write during idle flush", write_during_flush);
+	passed &= run_case("erase during idle flush", erase_during_flush);
+	passed &= run_case("fini with a gathered block", fini_gathered);
+	passed &= run_case("fini during a flush", fini_during_flush);
+
+	return !passed;
+}
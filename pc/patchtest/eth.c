@@ -0,0 +1,269 @@
+/* eth.c
+	- drives the BBA emulation with bursts of frames
+ */
+
+// Frames arrive from the network side in bursts while the game, acting as
+// the libogc driver would over EXI, drains the receive ring at its own pace
+// and frees pages with each of the ways a driver may write RRP. Every frame
+// has to come out whole and in order, or be counted as dropped.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "bba/bba.h"
+#include "dolphin/exi.h"
+#include "emulator.h"
+#include "emulator_eth.h"
+
+#define ARENA_ADDRESS 0x200000
+#define ARENA_SIZE    0x10000
+#define DMA_ADDRESS   0x100000
+
+enum {
+	RRP_WRITE_16,
+	RRP_WRITE_LOW,
+	RRP_WRITE_SPLIT,
+	RRP_WRITE_MAX
+};
+
+static const char *rrp_write_names[RRP_WRITE_MAX] = {
+	"16-bit RRP writes",
+	"low byte RRP writes",
+	"split RRP writes"
+};
+
+static struct {
+	uint32_t sent;
+	uint32_t received;
+	uint32_t next;
+	uint32_t errors;
+	uint32_t interrupts;
+} test;
+
+void exi_interrupt(unsigned chan)
+{
+	test.interrupts++;
+}
+
+void bba_transmit_fifo(const void *data, size_t size)
+{
+}
+
+static void mac_write(uint16_t reg, const void *data, int length)
+{
+	const uint8_t *p = data;
+
+	eth_exi_select();
+	eth_exi_imm(0xC0);
+	eth_exi_imm(reg >> 8);
+	eth_exi_imm(reg);
+	eth_exi_imm(0x00);
+	while (length--)
+		eth_exi_imm(*p++);
+	eth_exi_deselect();
+}
+
+static void mac_read(uint16_t reg, void *data, int length, bool dma)
+{
+	uint8_t *p = data;
+
+	eth_exi_select();
+	eth_exi_imm(0x80);
+	eth_exi_imm(reg >> 8);
+	eth_exi_imm(reg);
+	eth_exi_imm(0x00);
+	if (dma) {
+		eth_exi_dma(DMA_ADDRESS, OSRoundUp32B(length), EXI_READ);
+		memcpy(data, OSPhysicalToUncached(DMA_ADDRESS), length);
+	} else {
+		while (length--)
+			*p++ = eth_exi_imm(0x00);
+	}
+	eth_exi_deselect();
+}
+
+static void exi_write_imr(uint8_t imr)
+{
+	eth_exi_select();
+	eth_exi_imm(0x42);
+	eth_exi_imm(0x00);
+	eth_exi_imm(imr);
+	eth_exi_deselect();
+}
+
+static void mac_write16(uint16_t reg, uint16_t value)
+{
+	uint8_t data[2] = {value, value >> 8};
+	mac_write(reg, data, 2);
+}
+
+static uint16_t mac_read16(uint16_t reg)
+{
+	uint8_t data[2];
+	mac_read(reg, data, 2, false);
+	return data[0] | data[1] << 8;
+}
+
+static void mac_write8(uint16_t reg, uint8_t value)
+{
+	mac_write(reg, &value, 1);
+}
+
+static void send_frame(void)
+{
+	static uint8_t frame[1514];
+	uint32_t seq = test.sent++;
+	int size = 60 + rand() % (sizeof(frame) - 60 + 1);
+
+	frame[0] = seq >> 24;
+	frame[1] = seq >> 16;
+	frame[2] = seq >> 8;
+	frame[3] = seq;
+	for (int i = 4; i < size; i++)
+		frame[i] = seq + i;
+
+	eth_mac_receive(frame, size);
+}
+
+static void check_frame(const uint8_t *frame, int size)
+{
+	uint32_t seq = frame[0] << 24 | frame[1] << 16 | frame[2] << 8 | frame[3];
+
+	if (size < 60 || seq < test.next || seq >= test.sent) {
+		test.errors++;
+		return;
+	}
+
+	for (int i = 4; i < size; i++) {
+		if (frame[i] != (uint8_t)(seq + i)) {
+			test.errors++;
+			return;
+		}
+	}
+
+	test.next = seq + 1;
+	test.received++;
+}
+
+static void write_rrp(uint16_t rrp, int mode)
+{
+	switch (mode) {
+		case RRP_WRITE_16:
+			mac_write16(BBA_RRP, rrp);
+			break;
+		case RRP_WRITE_LOW:
+			mac_write8(BBA_RRP, rrp);
+			break;
+		case RRP_WRITE_SPLIT:
+			mac_write8(BBA_RRP, rrp);
+			mac_write8(BBA_RRP + 1, rrp >> 8);
+			break;
+	}
+}
+
+// Takes up to count frames off the receive ring, returning how many there were
+static int receive_frames(int count, int mode)
+{
+	static uint8_t frame[BBA_RX_MAX_PACKET_SIZE];
+	int received = 0;
+
+	while (received < count) {
+		uint16_t rwp = mac_read16(BBA_RWP);
+		uint16_t rrp = mac_read16(BBA_RRP);
+		uint8_t data[4];
+
+		if (rrp == rwp)
+			break;
+
+		mac_read(rrp << 8, data, 4, false);
+
+		uint16_t next   = data[0] | (data[1] & 0x0F) << 8;
+		uint16_t length = (data[1] >> 4 | data[2] << 4) - 4;
+
+		if (length > sizeof(frame) || next < BBA_INIT_BP || next > BBA_INIT_RHBP) {
+			test.errors++;
+			return -1;
+		}
+
+		mac_read((rrp << 8) + 4, frame, length, true);
+		check_frame(frame, length);
+		write_rrp(next, mode);
+		received++;
+	}
+
+	return received;
+}
+
+static void reset(void)
+{
+	void *arenaLo = OSPhysicalToCached(ARENA_ADDRESS);
+	void *arenaHi = OSPhysicalToCached(ARENA_ADDRESS + ARENA_SIZE);
+
+	memset(&test, 0, sizeof(test));
+	eth_init(&arenaLo, &arenaHi);
+
+	mac_write8(BBA_NCRA, BBA_NCRA_RESET);
+	mac_write8(BBA_NCRA, 0x00);
+	mac_write16(BBA_BP, BBA_INIT_BP);
+	mac_write16(BBA_RWP, BBA_INIT_RWP);
+	mac_write16(BBA_RRP, BBA_INIT_RRP);
+	mac_write16(BBA_RHBP, BBA_INIT_RHBP);
+	mac_write8(BBA_IMR, BBA_IMR_RIM);
+	mac_write8(BBA_NCRA, BBA_NCRA_SR);
+	exi_write_imr(0xFF);
+}
+
+static bool run(int mode, int bursts)
+{
+	struct timespec start, end;
+	uint32_t dropped, high_water;
+
+	srand(mode + 1);
+	reset();
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (int i = 0; i < bursts; i++) {
+		int burst = 1 + rand() % 32;
+
+		while (burst--) {
+			send_frame();
+
+			// Now and then the game gets around to the ring in the middle of a burst
+			if (!(rand() % 8))
+				receive_frames(rand() % 4, mode);
+		}
+
+		receive_frames(rand() % 64, mode);
+	}
+
+	// Everything left in the backlog must come through once the game catches up
+	while (receive_frames(INT32_MAX, mode) > 0);
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	eth_mac_stats(&dropped, &high_water);
+
+	double ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+	bool passed = !test.errors && test.received + dropped == test.sent;
+
+	printf("%-20s %u sent, %u received, %u dropped, %u backlog high water, %u interrupts, %u errors, %.0f ns/frame: %s\n",
+		rrp_write_names[mode], test.sent, test.received, dropped, high_water,
+		test.interrupts, test.errors, ns / test.sent, passed ? "ok" : "FAILED");
+
+	return passed;
+}
+
+int main(int argc, char *argv[])
+{
+	int bursts = argc > 1 ? atoi(argv[1]) : 10000;
+	bool passed = true;
+
+	for (int mode = 0; mode < RRP_WRITE_MAX; mode++)
+		passed &= run(mode, bursts);
+
+	return !passed;
+}
@@ -0,0 +1,535 @@
+/* gecko.c
+	- drives the USB Gecko patch against a model of the adapter and its host
+ */
+
+// The adapter is modelled at the EXI register level: every register access
+// the patch makes lets a started transfer complete, decoding each 16-bit
+// command frame in it against a receive FIFO that the host side fills with
+// the data it was asked for, a packet every so many commands. Interrupts are
+// only taken between steps of the test, through a stand-in for
+// usb_interrupt_vector that follows usbgecko_isr.S instruction for
+// instruction. Every payload
+// has to arrive whole, and whatever was asked for ahead of time has to be
+// drained when the file is unlocked, leaving nothing behind in the FIFO.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "dolphin/exi.h"
+#include "emulator.h"
+#include "frag.h"
+#include "interrupt.h"
+
+#define RX_FIFO_SIZE 384
+#define PACKET_SIZE  64
+#define MAX_REPLIES  64
+
+#define MAX_TICKS (1 << 24)
+
+#define BUFFER_ADDRESS 0x100000
+#define BUFFER_SIZE    0x8000
+
+static volatile u32 (*const exi)[5] = EXI;
+
+static struct {
+	uint8_t data[RX_FIFO_SIZE];
+	int head;
+	int count;
+} fifo;
+
+static struct {
+	uint8_t request[8];
+	int length;
+	struct {
+		uint32_t offset;
+		uint32_t size;
+	} reply[MAX_REPLIES];
+	int head;
+	int count;
+	int unlocks;
+	int packet_interval;
+} host;
+
+static struct {
+	uint32_t transfers;
+	uint32_t ticks;
+	uint32_t empty_frames;
+	uint32_t interrupts;
+	uint32_t bytes;
+	uint32_t completed;
+	int failures;
+} test;
+
+static OSInterruptHandler tc_handler;
+static bool vector_installed;
+
+static uint8_t pattern(uint32_t offset)
+{
+	return (offset * 0x9E3779B1) >> 24;
+}
+
+static void check(bool condition, const char *what)
+{
+	if (!condition) {
+		printf("  FAILED: %s\n", what);
+		test.failures++;
+	}
+}
+
+static void host_receive(uint8_t byte)
+{
+	host.request[host.length++] = byte;
+
+	if (host.length == sizeof(host.request)) {
+		uint32_t offset = host.request[0] | host.request[1] << 8 | host.request[2] << 16 | host.request[3] << 24;
+		uint32_t size   = host.request[4] | host.request[5] << 8 | host.request[6] << 16 | host.request[7] << 24;
+
+		host.length = 0;
+
+		if (!offset && !size) {
+			host.unlocks++;
+		} else if (host.count < MAX_REPLIES) {
+			int i = (host.head + host.count++) % MAX_REPLIES;
+			host.reply[i].offset = offset;
+			host.reply[i].size   = size;
+		}
+	}
+}
+
+// Sends the next packet of whatever the host still owes, as far as the FIFO has room
+static void host_send(void)
+{
+	for (int n = 0; n < PACKET_SIZE && host.count && fifo.count < RX_FIFO_SIZE; n++) {
+		fifo.data[(fifo.head + fifo.count++) % RX_FIFO_SIZE] = pattern(host.reply[host.head].offset++);
+
+		if (!--host.reply[host.head].size) {
+			host.head = (host.head + 1) % MAX_REPLIES;
+			host.count--;
+		}
+	}
+}
+
+// The host side gets a packet in every so many commands
+static void device_tick(void)
+{
+	if (++test.ticks % host.packet_interval == 0)
+		host_send();
+
+	if (test.ticks == MAX_TICKS) {
+		printf("  FAILED: still waiting on data the host no longer owes\n");
+		exit(1);
+	}
+}
+
+static uint16_t device_frame(uint16_t frame)
+{
+	device_tick();
+
+	switch (frame >> 12) {
+		case 0x9:
+			return 0x470;
+		case 0xA:
+			if (!fifo.count) {
+				test.empty_frames++;
+				return 0;
+			}
+			frame = fifo.data[fifo.head];
+			fifo.head = (fifo.head + 1) % RX_FIFO_SIZE;
+			fifo.count--;
+			return 0x800 | frame;
+		case 0xB:
+			host_receive(frame >> 4);
+			return 0x400;
+	}
+
+	return 0;
+}
+
+static uint8_t device_check(uint8_t command)
+{
+	device_tick();
+
+	switch (command >> 4) {
+		case 0xC:
+			return 0x04;
+		case 0xD:
+			return fifo.count ? 0x04 : 0x00;
+	}
+
+	return 0;
+}
+
+// Completes a started transfer, as the adapter would by the time it is looked at again
+static void device_step(void)
+{
+	uint32_t data = exi[EXI_CHANNEL_1][4];
+
+	if (!(exi[EXI_CHANNEL_1][3] & 0b01))
+		return;
+
+	exi[EXI_CHANNEL_1][0] &= ~0b001000;
+
+	switch ((exi[EXI_CHANNEL_1][3] >> 4) & 0b11) {
+		case 0:
+			data = device_check(data >> 24) << 24;
+			break;
+		case 1:
+			data = device_frame(data >> 16) << 16;
+			break;
+		case 3:
+			data = device_frame(data >> 16) << 16 | device_frame(data);
+			break;
+		default:
+			data = 0;
+			break;
+	}
+
+	exi[EXI_CHANNEL_1][4] = data;
+	exi[EXI_CHANNEL_1][0] |= 0b001000;
+	exi[EXI_CHANNEL_1][3] &= ~0b01;
+	test.transfers++;
+}
+
+static volatile u32 (*exi_step(void))[3][5]
+{
+	device_step();
+	return (volatile u32 (*)[3][5])EXI;
+}
+
+// From here on, every access the patch makes to the EXI registers lets the adapter catch up
+#define EXI (*exi_step())
+
+#include "usbgecko.c"
+
+typeof(_usb) _usb = {.registers = 0x0C006800 + 5*4};
+
+void usb_interrupt_vector(void)
+{
+}
+
+static s32 exi_lock(s32 chan, u32 dev, EXICallback unlockedCallback)
+{
+	return 1;
+}
+
+static s32 exi_unlock(s32 chan)
+{
+	return 1;
+}
+
+s32 (*EXILock)(s32 chan, u32 dev, EXICallback unlockedCallback) = exi_lock;
+s32 (*EXIUnlock)(s32 chan) = exi_unlock;
+
+OSInterruptHandler set_interrupt_handler(OSInterrupt interrupt, OSInterruptHandler handler)
+{
+	OSInterruptHandler old = tc_handler;
+	tc_handler = handler;
+	return old;
+}
+
+OSInterruptMask mask_interrupts(OSInterruptMask mask)
+{
+	if (mask & OS_INTERRUPTMASK_EXI_1_TC)
+		exi[EXI_CHANNEL_1][0] &= ~0b000100;
+	return 0;
+}
+
+OSInterruptMask unmask_interrupts(OSInterruptMask mask)
+{
+	if (mask & OS_INTERRUPTMASK_EXI_1_TC)
+		exi[EXI_CHANNEL_1][0] |= 0b000100;
+	return 0;
+}
+
+void write_branch(void *a, void *b)
+{
+	vector_installed = a == (void *)0x80000500 && b == usb_interrupt_vector;
+}
+
+void reset_device(void)
+{
+}
+
+void di_complete_transfer()
+{
+}
+
+void ipl_set_config(uint8_t config)
+{
+}
+
+int frag_get_list(int file, const frag_t **frag)
+{
+	return 0;
+}
+
+bool frag_read_write_async(int file, void *buffer, uint32_t length, uint32_t offset, bool write, frag_callback callback)
+{
+	return false;
+}
+
+static bool tc_pending(void)
+{
+	return (exi[EXI_CHANNEL_1][0] & 0b001100) == 0b001100 && !(exi[EXI_CHANNEL_1][3] & 0b01);
+}
+
+static void store_word(intptr_t address, uint32_t data)
+{
+	uint8_t *p = OSPhysicalToCached(address);
+
+	p[0] = data >> 24;
+	p[1] = data >> 16;
+	p[2] = data >> 8;
+	p[3] = data;
+}
+
+// Follows usb_interrupt_vector, returning whether it chains to the handler at 0x504
+static bool run_vector(void)
+{
+	uint32_t csr = exi[EXI_CHANNEL_1][0];
+
+	if (!(csr & (csr << 1) & 0b001000) || !_usb.requested)
+		return true;
+
+	bool two = exi[EXI_CHANNEL_1][3] & 0b100000;
+	uint32_t frames = exi[EXI_CHANNEL_1][4];
+
+	for (;;) {
+		if (frames & 0x08000000) {
+			_usb.requested--;
+			_usb.data = _usb.data << 8 | (uint8_t)(frames >> 16);
+			if (!(++_usb.buffer & 3))
+				store_word((_usb.buffer - 1) & ~3, _usb.data);
+		}
+		if (!two)
+			break;
+		two = false;
+		frames <<= 16;
+	}
+
+	if (_usb.requested) {
+		csr = exi[EXI_CHANNEL_1][0];
+		exi[EXI_CHANNEL_1][0] = csr & 0x405;
+		exi[EXI_CHANNEL_1][0] = csr & ((0x3FFF & ~0x80A) | (1 << 3));
+
+		if (_usb.requested == 1) {
+			exi[EXI_CHANNEL_1][4] = 0xA000 << 16;
+			exi[EXI_CHANNEL_1][3] = ((2 - 1) << 4) | 0b01;
+		} else {
+			exi[EXI_CHANNEL_1][4] = 0xA000 << 16 | 0xA000;
+			exi[EXI_CHANNEL_1][3] = ((4 - 1) << 4) | 0b01;
+		}
+	}
+
+	return tc_pending();
+}
+
+// Lets the transfer in flight complete and takes its interrupt, returning false if there was none
+static bool cpu_step(void)
+{
+	device_step();
+
+	if (!tc_pending())
+		return false;
+
+	test.interrupts++;
+
+	if (!vector_installed || run_vector())
+		tc_handler(OS_INTERRUPT_EXI_1_TC, NULL);
+
+	return true;
+}
+
+static struct {
+	void *buffer;
+	uint32_t offset;
+	uint32_t length;
+	bool busy;
+	bool done;
+} reads[QUEUE_SIZE];
+
+static uint32_t next_offset;
+
+static void read_callback(void *address, uint32_t length)
+{
+	for (int i = 0; i < QUEUE_SIZE; i++) {
+		if (reads[i].busy && reads[i].buffer == address) {
+			const uint8_t *data = OSUncachedToCached(address);
+			bool match = length == reads[i].length;
+
+			for (uint32_t j = 0; match && j < length; j++)
+				match = data[j] == pattern(reads[i].offset + j);
+
+			check(match, "payload arrived whole");
+			reads[i].busy = false;
+			reads[i].done = true;
+			test.bytes += length;
+			test.completed++;
+			return;
+		}
+	}
+
+	check(false, "completed a read that was issued");
+}
+
+static int submit(uint32_t length)
+{
+	for (int i = 0; i < QUEUE_SIZE; i++) {
+		if (!reads[i].busy) {
+			reads[i].buffer = OSPhysicalToUncached(BUFFER_ADDRESS + i * BUFFER_SIZE);
+			reads[i].offset = next_offset;
+			reads[i].length = length;
+			reads[i].busy   = true;
+			reads[i].done   = false;
+			memset(OSUncachedToCached(reads[i].buffer), 0, length);
+
+			if (!do_read_disc(reads[i].buffer, length, next_offset, NULL, read_callback)) {
+				reads[i].busy = false;
+				return -1;
+			}
+
+			next_offset += length;
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+static void reset(int packet_interval)
+{
+	memset(&fifo, 0, sizeof(fifo));
+	memset(&host, 0, sizeof(host));
+	memset(&test, 0, sizeof(test));
+	memset(&reads, 0, sizeof(reads));
+	memset(&usb, 0, sizeof(usb));
+	memset((void *)exi[EXI_CHANNEL_1], 0, sizeof(exi[EXI_CHANNEL_1]));
+
+	_usb.requested = 0;
+	host.packet_interval = packet_interval;
+	next_offset = 0;
+	vector_installed = false;
+}
+
+static bool report(const char *name)
+{
+	printf("%-28s %7u bytes, %.2f transfers/byte, %.2f interrupts/byte, %u empty frames: %s\n",
+		name, test.bytes, (double)test.transfers / test.bytes,
+		(double)test.interrupts / test.bytes, test.empty_frames,
+		test.failures ? "FAILED" : "ok");
+
+	return !test.failures;
+}
+
+static bool sync_receive(const char *name, int packet_interval)
+{
+	static uint8_t data[4096];
+
+	reset(packet_interval);
+
+	for (int i = 0; i < 64; i++) {
+		uint32_t size = 1 + rand() % sizeof(data);
+		bool match = true;
+
+		usb_request(next_offset, size);
+		check((uint32_t)usb_receive(data, size, size) == size, "received everything asked for");
+
+		for (uint32_t j = 0; match && j < size; j++)
+			match = data[j] == pattern(next_offset + j);
+
+		check(match, "payload arrived whole");
+		next_offset += size;
+		test.bytes += size;
+	}
+
+	check(!fifo.count && !host.count, "nothing left behind");
+	return report(name);
+}
+
+static bool queued_reads(const char *name, int packet_interval)
+{
+	reset(packet_interval);
+
+	for (int i = 0; i < 256; i++) {
+		while (submit(32 * (1 + rand() % (BUFFER_SIZE / 32))) >= 0);
+		if (!cpu_step())
+			check(false, "transfer in flight");
+	}
+
+	while (cpu_step());
+
+	check(!_usb.requested && !usb.queued, "queue drained");
+	check(!fifo.count && !host.count, "nothing left behind");
+	return report(name);
+}
+
+// Steps until the read in the given slot completes
+static void run_until_done(int slot)
+{
+	while (!reads[slot].done && cpu_step());
+}
+
+static bool unlock_drain(const char *name)
+{
+	int slot[5];
+
+	reset(1);
+
+	slot[0] = submit(0x1000);
+	slot[1] = submit(0x1000);
+	slot[2] = submit(0x1000);
+	slot[3] = submit(0x1000);
+	run_until_done(slot[0]);
+
+	// The freed slot is asked for after the ones above it, so the order the
+	// host answers in differs from the order of the queue
+	slot[4] = submit(0x400);
+	run_until_done(slot[1]);
+
+	check(slot[4] == slot[0], "slot reused");
+	check(usb.queued == &usb.queue[slot[2]], "third read in flight");
+	check(usb.queue[slot[3]].requested && usb.queue[slot[4]].requested, "rest asked for ahead of time");
+	check((uint8_t)(usb.queue[slot[4]].sequence - usb.queue[slot[3]].sequence) == 1, "asked for out of slot order");
+
+	while (_usb.requested > 0x800 && cpu_step());
+
+	usb_unlock_file();
+
+	for (int i = 3; i < 5; i++) {
+		const uint8_t *data = OSUncachedToCached(reads[slot[i]].buffer);
+		bool match = true;
+
+		for (uint32_t j = 0; match && j < reads[slot[i]].length; j++)
+			match = data[j] == pattern(reads[slot[i]].offset + j);
+
+		check(match, "drained into the buffer it was asked for");
+		test.bytes += reads[slot[i]].length;
+	}
+
+	check(host.unlocks == 1, "unlocked");
+	check(!_usb.requested, "current transfer drained");
+	check(!fifo.count && !host.count, "nothing left behind");
+	return report(name);
+}
+
+int main(int argc, char *argv[])
+{
+	bool passed = true;
+
+	reset(1);
+
+	if (!usb_probe()) {
+		printf("FAILED: adapter not found\n");
+		return 1;
+	}
+
+	passed &= sync_receive("receive, FIFO kept full", 1);
+	passed &= sync_receive("receive, FIFO starved", 96);
+	passed &= queued_reads("queued reads, FIFO kept full", 1);
+	passed &= queued_reads("queued reads, FIFO starved", 96);
+	passed &= unlock_drain("unlock mid-transfer");
+
+	return !passed;
+}
@@ -0,0 +1,119 @@
+/* host.c
+	- host backing for the reserved area, memory and alarms
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "host.h"
+
+#define HOST_MAX_ALARMS 16
+
+char VAR_AREA[0x3100] __attribute((aligned(32)));
+char VAR_CURRENT_DISC[1];
+char VAR_SECOND_DISC[1];
+char VAR_EMU_READ_SPEED[1];
+char VAR_IGR_TYPE[1];
+char VAR_CLIENT_MAC[6];
+char VAR_CARD_IDS[2];
+
+void *host_frag_list;
+volatile u32 EXI[3][5];
+
+OSTime host_time;
+
+static OSAlarm *alarms[HOST_MAX_ALARMS];
+
+__attribute((constructor))
+static void map_ram(void)
+{
+	FILE *fp = tmpfile();
+	int fd = fp ? fileno(fp) : -1;
+
+	if (fd < 0 || ftruncate(fd, HOST_RAM_SIZE) < 0 ||
+		mmap((void *)OS_BASE_CACHED, HOST_RAM_SIZE, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0) == MAP_FAILED ||
+		mmap((void *)OS_BASE_UNCACHED, HOST_RAM_SIZE, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0) == MAP_FAILED) {
+		perror("host_ram");
+		exit(1);
+	}
+
+	fclose(fp);
+}
+
+OSTime OSGetTime(void)
+{
+	return host_time;
+}
+
+OSTick OSGetTick(void)
+{
+	return host_time;
+}
+
+void DCZeroRange(void *addr, u32 nBytes)
+{
+	memset(addr, 0, nBytes);
+}
+
+// The host is coherent, there is nothing to write back or throw away
+void DCFlushRange(void *addr, u32 nBytes) {}
+void DCInvalidateRange(void *addr, u32 nBytes) {}
+void DCStoreRange(void *addr, u32 nBytes) {}
+void ICInvalidateRange(void *addr, u32 nBytes) {}
+
+static void cancel_alarm(OSAlarm *alarm)
+{
+	for (int i = 0; i < HOST_MAX_ALARMS; i++)
+		if (alarms[i] == alarm)
+			alarms[i] = NULL;
+}
+
+static void set_alarm(OSAlarm *alarm, OSTime tick, OSAlarmHandler handler)
+{
+	cancel_alarm(alarm);
+
+	alarm->handler = handler;
+	alarm->fire = host_time + tick;
+
+	for (int i = 0; i < HOST_MAX_ALARMS; i++) {
+		if (!alarms[i]) {
+			alarms[i] = alarm;
+			return;
+		}
+	}
+
+	abort();
+}
+
+void (*OSSetAlarm)(OSAlarm *alarm, OSTime tick, OSAlarmHandler handler) = set_alarm;
+void (*OSCancelAlarm)(OSAlarm *alarm) = cancel_alarm;
+
+bool host_run_alarm(void)
+{
+	OSAlarm *alarm;
+	int next = -1;
+
+	for (int i = 0; i < HOST_MAX_ALARMS; i++)
+		if (alarms[i] && (next < 0 || alarms[i]->fire < alarms[next]->fire))
+			next = i;
+
+	if (next < 0)
+		return false;
+
+	alarm = alarms[next];
+	alarms[next] = NULL;
+
+	if (alarm->fire > host_time)
+		host_time = alarm->fire;
+	alarm->handler(alarm, NULL);
+	return true;
+}
+
+void host_run_alarms(void)
+{
+	while (host_run_alarm());
+}
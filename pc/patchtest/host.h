@@ -0,0 +1,116 @@
+/* host.h
+	- host stand-ins for the Dolphin OS headers
+ */
+
+// Included ahead of every source file, this stands in for dolphin/os.h and
+// dolphin/dvd.h so that the patch code can be built for the host unchanged.
+// Main memory is mapped at both of its console addresses, so that pointers
+// the patch code masks and converts stay valid, and time only moves when the
+// test says so.
+
+#ifndef HOST_H
+#define HOST_H
+
+#define OS_H
+#define DVD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// VAR_FRAG_LIST holds a pointer, which is wider than the 4 bytes reserved for it
+#define VAR_FRAG_LIST host_frag_list_32
+#include "common.h"
+#undef VAR_FRAG_LIST
+
+extern void *host_frag_list;
+#define VAR_FRAG_LIST ((char *)&host_frag_list)
+
+#define HOST_RAM_SIZE 0x1800000
+
+#define OSRoundUp32B(x)   (((u32)(x) + (32 - 1)) & ~(32 - 1))
+#define OSRoundDown32B(x) ((u32)(x) & ~(32 - 1))
+
+#define OS_BASE_CACHED   0x80000000
+#define OS_BASE_UNCACHED 0xC0000000
+
+#define OSPhysicalToCached(paddr)    ((void *)((uintptr_t)(paddr) + OS_BASE_CACHED))
+#define OSPhysicalToUncached(paddr)  ((void *)((uintptr_t)(paddr) + OS_BASE_UNCACHED))
+#define OSCachedToPhysical(caddr)    ((u32)((uintptr_t)(caddr) - OS_BASE_CACHED))
+#define OSUncachedToPhysical(ucaddr) ((u32)((uintptr_t)(ucaddr) - OS_BASE_UNCACHED))
+#define OSCachedToUncached(caddr)    ((void *)((uintptr_t)(caddr) + (OS_BASE_UNCACHED - OS_BASE_CACHED)))
+#define OSUncachedToCached(ucaddr)   ((void *)((uintptr_t)(ucaddr) - (OS_BASE_UNCACHED - OS_BASE_CACHED)))
+
+typedef s64 OSTime;
+typedef u32 OSTick;
+
+#define OS_CORE_CLOCK  486000000
+#define OS_BUS_CLOCK   162000000
+#define OS_TIMER_CLOCK (OS_BUS_CLOCK / 4)
+
+#define OSTicksToMicroseconds(ticks) (((ticks) * 8) / (OS_TIMER_CLOCK / 125000))
+#define OSMillisecondsToTicks(msec)  ((msec) * (OS_TIMER_CLOCK / 1000))
+#define OSMicrosecondsToTicks(usec)  (((usec) * (OS_TIMER_CLOCK / 125000)) / 8)
+
+#define OSDiffTick(tick1, tick0) ((s32)(tick1) - (s32)(tick0))
+
+extern OSTime host_time;
+
+OSTime OSGetTime(void);
+OSTick OSGetTick(void);
+
+typedef struct OSAlarm OSAlarm;
+typedef struct OSContext OSContext;
+
+typedef void (*OSAlarmHandler)(OSAlarm *alarm, OSContext *context);
+
+struct OSAlarm {
+	OSAlarmHandler handler;
+	OSTime fire;
+};
+
+extern void (*OSSetAlarm)(OSAlarm *alarm, OSTime tick, OSAlarmHandler handler);
+extern void (*OSCancelAlarm)(OSAlarm *alarm);
+
+typedef enum OSInterrupt {
+	OS_INTERRUPT_EXI_0_EXI = 9,
+	OS_INTERRUPT_EXI_0_TC,
+	OS_INTERRUPT_EXI_0_EXT,
+	OS_INTERRUPT_EXI_1_EXI,
+	OS_INTERRUPT_EXI_1_TC,
+	OS_INTERRUPT_EXI_1_EXT,
+	OS_INTERRUPT_EXI_2_EXI,
+	OS_INTERRUPT_EXI_2_TC
+} OSInterrupt;
+
+typedef void (*OSInterruptHandler)(OSInterrupt interrupt, OSContext *context);
+
+typedef u32 OSInterruptMask;
+
+#define OS_INTERRUPTMASK(interrupt) (0x80000000U >> (interrupt))
+
+#define OS_INTERRUPTMASK_EXI_1_TC OS_INTERRUPTMASK(OS_INTERRUPT_EXI_1_TC)
+
+void DCZeroRange(void *addr, u32 nBytes);
+void DCFlushRange(void *addr, u32 nBytes);
+void DCInvalidateRange(void *addr, u32 nBytes);
+void DCStoreRange(void *addr, u32 nBytes);
+void ICInvalidateRange(void *addr, u32 nBytes);
+
+// Fires the earliest alarm, moving host_time up to it
+bool host_run_alarm(void);
+void host_run_alarms(void);
+
+#define DVDRoundUp32KB(x)   (((u32)(x) + (32768 - 1)) & ~(32768 - 1))
+#define DVDRoundDown32KB(x) ((u32)(x) & ~(32768 - 1))
+
+typedef struct DVDDiskID {
+	char gameName[4];
+	char company[2];
+	u8 diskNumber;
+	u8 gameVersion;
+	u8 streaming;
+	u8 streamingBufSize;
+	u8 padding[22];
+} DVDDiskID;
+
+#endif /* HOST_H */
@@ -0,0 +1,39 @@
+/* ppu_intrinsics.h
+	- host stand-ins for the byte reversed loads and stores
+ */
+
+#ifndef PPU_INTRINSICS_H
+#define PPU_INTRINSICS_H
+
+#include <stdint.h>
+#include <string.h>
+
+static inline uint16_t __lhbrx(const void *addr)
+{
+	const uint8_t *p = addr;
+	return p[0] | p[1] << 8;
+}
+
+static inline void __sthbrx(void *addr, uint16_t value)
+{
+	uint8_t *p = addr;
+	p[0] = value;
+	p[1] = value >> 8;
+}
+
+static inline uint32_t __lwbrx(const void *addr)
+{
+	const uint8_t *p = addr;
+	return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static inline void __stwbrx(void *addr, uint32_t value)
+{
+	uint8_t *p = addr;
+	p[0] = value;
+	p[1] = value >> 8;
+	p[2] = value >> 16;
+	p[3] = value >> 24;
+}
+
+#endif /* PPU_INTRINSICS_H */
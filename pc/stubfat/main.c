@@ -0,0 +1,216 @@
+/* main.c
+	- loads a DOL through the stub's Petit FatFs from FAT images in memory
+ */
+
+// FAT12, FAT16 and FAT32 volumes are built with AUTOEXEC.DOL spread over
+// cluster runs of random length with gaps between them. The file is read back
+// as the stub's DOL loader does, the header and then each section after a
+// seek, through the stub's pff.c. The data has to match, and the number of
+// card commands is reported next to the sectors they moved.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/param.h>
+#include "pff.h"
+#include "diskio.h"
+
+#define FILE_SIZE 600000
+
+typedef struct {
+	const char *name;
+	int fat;			// 12, 16 or 32
+	int cluster;		// sectors per cluster
+	int sectors;
+	int fatSize;		// sectors per FAT
+	int rootEntries;
+} volume;
+
+static const volume volumes[] = {
+	{"FAT12", 12, 4,  8000,   6, 224},
+	{"FAT16", 16, 2, 20000,  40, 512},
+	{"FAT32", 32, 1, 70000, 560,   0},
+};
+
+static uint8_t *image;
+static uint8_t data[FILE_SIZE];
+static uint8_t loaded[FILE_SIZE];
+
+static struct {
+	int commands;
+	int sectors;
+} test;
+
+DSTATUS disk_initialize(void)
+{
+	return 0;
+}
+
+DRESULT disk_readp(BYTE *buff, DWORD sector, UINT offset, UINT count)
+{
+	test.commands++;
+	test.sectors++;
+	memcpy(buff, image + sector * 512 + offset, count);
+	return RES_OK;
+}
+
+DRESULT disk_readm(BYTE *buff, DWORD sector, UINT count)
+{
+	test.commands++;
+	test.sectors += count;
+	memcpy(buff, image + sector * 512, count * 512);
+	return RES_OK;
+}
+
+static void put16(uint8_t *p, uint32_t value)
+{
+	p[0] = value;
+	p[1] = value >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t value)
+{
+	put16(p, value);
+	put16(p + 2, value >> 16);
+}
+
+static void set_fat(const volume *vol, uint8_t *fat, uint32_t cluster, uint32_t value)
+{
+	switch (vol->fat) {
+		case 12: {
+			uint8_t *p = fat + cluster + cluster / 2;
+			if (cluster & 1) {
+				p[0] = (p[0] & 0x0F) | value << 4;
+				p[1] = value >> 4;
+			} else {
+				p[0] = value;
+				p[1] = (p[1] & 0xF0) | (value >> 8 & 0x0F);
+			}
+			break;
+		}
+		case 16:
+			put16(fat + cluster * 2, value);
+			break;
+		case 32:
+			put32(fat + cluster * 4, value);
+			break;
+	}
+}
+
+static uint32_t build(const volume *vol)
+{
+	uint32_t reserved = vol->fat == 32 ? 32 : 1;
+	uint32_t rootSector = reserved + 2 * vol->fatSize;
+	uint32_t dataSector = rootSector + vol->rootEntries * 32 / 512;
+	uint32_t clusters = (vol->sectors - dataSector) / vol->cluster + 2;
+	uint32_t clusterSize = vol->cluster * 512;
+	uint32_t eoc = vol->fat == 12 ? 0xFFF : vol->fat == 16 ? 0xFFFF : 0x0FFFFFFF;
+	uint8_t *fat = image + reserved * 512;
+	uint8_t *boot = image;
+	uint8_t *entry;
+
+	memset(image, 0, vol->sectors * 512);
+
+	memcpy(boot, "\xEB\x3C\x90MSWIN4.1", 11);
+	put16(boot + 11, 512);
+	boot[13] = vol->cluster;
+	put16(boot + 14, reserved);
+	boot[16] = 2;
+	put16(boot + 17, vol->rootEntries);
+	put16(boot + 19, vol->sectors < 65536 ? vol->sectors : 0);
+	boot[21] = 0xF8;
+	put16(boot + 22, vol->fat == 32 ? 0 : vol->fatSize);
+	put32(boot + 32, vol->sectors);
+	if (vol->fat == 32) {
+		put32(boot + 36, vol->fatSize);
+		put32(boot + 44, 2);
+		memcpy(boot + 82, "FAT32   ", 8);
+		set_fat(vol, fat, 2, eoc);
+	} else {
+		memcpy(boot + 54, vol->fat == 12 ? "FAT12   " : "FAT16   ", 8);
+	}
+	boot[510] = 0x55;
+	boot[511] = 0xAA;
+
+	// Runs of 1 to 40 clusters with gaps of 1 to 5 between them
+	uint32_t count = (FILE_SIZE + clusterSize - 1) / clusterSize;
+	uint32_t cluster = 3, first = 3, previous = 0;
+
+	for (uint32_t written = 0; written < count;) {
+		uint32_t run = 1 + rand() % 40;
+		for (uint32_t i = 0; i < run && written < count && cluster < clusters; i++, cluster++, written++) {
+			uint32_t offset = written * clusterSize;
+			memcpy(image + (dataSector + (cluster - 2) * vol->cluster) * 512, data + offset,
+				MIN(clusterSize, FILE_SIZE - offset));
+			if (previous)
+				set_fat(vol, fat, previous, cluster);
+			previous = cluster;
+		}
+		if (cluster >= clusters)
+			return 0;
+		cluster += 1 + rand() % 5;
+	}
+	set_fat(vol, fat, previous, eoc);
+	memcpy(fat + vol->fatSize * 512, fat, vol->fatSize * 512);
+
+	entry = image + (vol->fat == 32 ? dataSector : rootSector) * 512;
+	memcpy(entry, "AUTOEXECDOL", 11);
+	entry[11] = 0x20;
+	put16(entry + 20, first >> 16);
+	put16(entry + 26, first);
+	put32(entry + 28, FILE_SIZE);
+	return count;
+}
+
+// The header, then sections in order as main.c in the stub reads them
+static bool load(void)
+{
+	static const uint32_t sections[] = {256, 3000, 70000, 200001, FILE_SIZE};
+	FATFS fs;
+	UINT br;
+
+	if (pf_mount(&fs) != FR_OK || pf_open("/AUTOEXEC.DOL") != FR_OK)
+		return false;
+	if (pf_read(loaded, sections[0], &br) != FR_OK || br != sections[0])
+		return false;
+	for (int i = 0; i < 4; i++) {
+		UINT length = sections[i + 1] - sections[i];
+		if (pf_lseek(sections[i]) != FR_OK)
+			return false;
+		if (pf_read(loaded + sections[i], length, &br) != FR_OK || br != length)
+			return false;
+	}
+	return !memcmp(loaded, data, FILE_SIZE);
+}
+
+int main(int argc, char *argv[])
+{
+	bool passed = true;
+
+	srand(1);
+	for (int i = 0; i < FILE_SIZE; i++)
+		data[i] = rand();
+
+	for (size_t i = 0; i < sizeof(volumes) / sizeof(*volumes); i++) {
+		const volume *vol = &volumes[i];
+		bool ok;
+
+		image = calloc(vol->sectors, 512);
+		if (!image)
+			return 1;
+
+		uint32_t clusters = build(vol);
+		memset(&test, 0, sizeof(test));
+		memset(loaded, 0, sizeof(loaded));
+		ok = clusters && load();
+
+		printf("%s, file in %4u clusters: %4d commands for %4d sectors: %s\n",
+			vol->name, clusters, test.commands, test.sectors, ok ? "ok" : "FAILED");
+		passed &= ok;
+		free(image);
+	}
+
+	return !passed;
+}
@@ -29,6 +29,9 @@
 #include <unistd.h>
 #include <errno.h>
 #include <dirent.h>
+#ifndef __WIN32__
+#include <sys/mman.h>
+#endif
 
 #include "gecko.h"
 
@@ -58,6 +61,11 @@ typedef struct {
 
 FILE *served_file_fp;
 char served_file[1024];		// The file we're currently serving to the GC
+void *served_file_map = NULL;	// Mapping of the served file, when available
+size_t served_file_size = 0;
+uint32_t served_file_next = 0;	// Where the next sequential request would start
+void *read_buffer = NULL;	// Reused when the file can't be mapped
+size_t read_buffer_size = 0;
 
 unsigned char ASK_READY = 0x15;
 unsigned char ASK_OPENPATH = 0x16;
@@ -70,8 +78,9 @@ unsigned char cmd_send = 0x14;
 const char *envvar = "USBGECKODEVICE";
 
 char *curPath = NULL;
-file_handle cached_files[2048];
+file_handle *cached_files = NULL;
 int cached_files_num = 0;
+int cached_files_max = 0;
 int next_serve_num = 0;
 
 //File type
@@ -117,6 +126,22 @@ char *getCurPath() {
 	return curPath;
 }
 
+file_handle *add_cached_file() {
+	if(cached_files_num == cached_files_max) {
+		int max = cached_files_max ? cached_files_max * 2 : 256;
+		file_handle *files = realloc(cached_files, max * sizeof(file_handle));
+		if(files == NULL) {
+			fprintf (stderr, "Out of memory listing [%s]\n",getCurPath());
+			exit(EXIT_FAILURE);
+		}
+		cached_files = files;
+		cached_files_max = max;
+	}
+	file_handle *file = &cached_files[cached_files_num++];
+	memset(file,0,sizeof(file_handle));
+	return file;
+}
+
 // Cache a paths contents
 void cache_path() {
 	DIR *dir = opendir (getCurPath());
@@ -137,11 +162,10 @@ void cache_path() {
 			sprintf(path, "%s/%s",curPath,ent->d_name);
 			stat(path, &fstat);
 			printf ("%s %i [%s]\n", ent->d_name, fstat.st_size, S_ISDIR(fstat.st_mode) ? "DIR":"FILE");
-			memset(&cached_files[cached_files_num],0,sizeof(file_handle));
-			sprintf(&cached_files[cached_files_num].name[0],"%s",path);
-			cached_files[cached_files_num].size = fstat.st_size;
-			cached_files[cached_files_num].fileAttrib = S_ISDIR(fstat.st_mode) ? IS_DIR:IS_FILE;
-			cached_files_num++;
+			file_handle *file = add_cached_file();
+			snprintf(file->name,sizeof(file->name),"%s",path);
+			file->size = fstat.st_size;
+			file->fileAttrib = S_ISDIR(fstat.st_mode) ? IS_DIR:IS_FILE;
 			free(path);
 		}
 		closedir (dir);
@@ -152,17 +176,80 @@ void cache_path() {
 	}
 }
 
+void close_served_file() {
+#ifndef __WIN32__
+	if(served_file_map) {
+		munmap(served_file_map, served_file_size);
+	}
+#endif
+	served_file_map = NULL;
+	served_file_size = 0;
+	served_file_next = 0;
+	if(served_file_fp) {
+		fclose(served_file_fp);
+		served_file_fp = NULL;
+	}
+}
+
+void open_served_file() {
+	served_file_fp = fopen(&served_file[0], "rb");
+#ifndef __WIN32__
+	struct stat st;
+	if(served_file_fp && !fstat(fileno(served_file_fp), &st) && st.st_size > 0) {
+		void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fileno(served_file_fp), 0);
+		if(map != MAP_FAILED) {
+			served_file_map = map;
+			served_file_size = st.st_size;
+			madvise(served_file_map, served_file_size, MADV_SEQUENTIAL);
+		}
+	}
+#endif
+}
+
+#ifndef __WIN32__
+// Games mostly read forward, so once a request follows on from the last one
+// ask the kernel to start fetching the next stretch while this one is sent.
+void prefetch_file_data(usb_data_req *req) {
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t start = (size_t)req->offset + req->size;
+	size_t length = (size_t)req->size * 4;
+	if(req->offset != served_file_next || start >= served_file_size) {
+		return;
+	}
+	if(length > served_file_size - start) {
+		length = served_file_size - start;
+	}
+	madvise((char*)served_file_map + (start & ~(page - 1)), length + (start & (page - 1)), MADV_WILLNEED);
+}
+#endif
+
 void send_file_data(usb_data_req *req) {
 	printf("Read File: offset %08X, size %i          \r", req->offset, req->size);
+#ifndef __WIN32__
+	if(served_file_map && (size_t)req->offset + req->size <= served_file_size) {
+		prefetch_file_data(req);
+		served_file_next = req->offset + req->size;
+		gecko_write((char*)served_file_map + req->offset, req->size);
+		return;
+	}
+#endif
 	if(served_file_fp) {
+		if(read_buffer_size < req->size) {
+			free(read_buffer);
+			read_buffer = malloc(req->size);
+			read_buffer_size = read_buffer ? req->size : 0;
+		}
+		if(read_buffer == NULL) {
+			fprintf (stderr, "\nOut of memory reading %i bytes\n", req->size);
+			exit(EXIT_FAILURE);
+		}
+		// Read and Send, past the end of the file the GC still expects the full size
 		fseek(served_file_fp, req->offset, SEEK_SET);
-		// Read and Send
-		void *buffer = (void*)malloc(req->size);
-		fread(buffer, 1, req->size, served_file_fp);
-		gecko_write(buffer, req->size);
-		free(buffer);
+		size_t read = fread(read_buffer, 1, req->size, served_file_fp);
+		memset((char*)read_buffer + read, 0, req->size - read);
+		gecko_write(read_buffer, req->size);
+		served_file_next = req->offset + req->size;
 	}
-	
 }
 
 int main (int argc, char **argv) {
@@ -221,8 +308,9 @@ int main (int argc, char **argv) {
 				}
 				else {
 					printf("Sending NULL entry to GC\n");
-					memset(&cached_files[0],0, sizeof(file_handle));
-					gecko_write(&cached_files[0], sizeof(file_handle));
+					file_handle empty;
+					memset(&empty,0, sizeof(file_handle));
+					gecko_write(&empty, sizeof(file_handle));
 				}
 			}
 			else if(resp == ASK_SERVEFILE) {
@@ -236,11 +324,10 @@ int main (int argc, char **argv) {
 				if(strcmp((const char*)&served_file, &filename[0])) {
 					if(served_file_fp) {
 						printf("Closed File %s\n",served_file);
-						fclose(served_file_fp);
-						served_file_fp = NULL;
+						close_served_file();
 					}	
 					strcpy((char*)served_file, &filename[0]);
-					served_file_fp = fopen(&served_file[0], "rb");
+					open_served_file();
 					printf("Opened File %s\n",served_file);
 				}
 			}
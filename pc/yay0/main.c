@@ -0,0 +1,308 @@
+/* main.c
+	- checks and times the IPL font's Yay0 decoder and I2 to I4 conversion
+ */
+
+// Streams are encoded here from synthetic data: random bytes, low entropy,
+// long runs, near repeats and a font-sized sheet of 2-bit glyph cells. Each is
+// decoded by yay0.c and by the byte-at-a-time decoder it replaced, and both
+// have to give back the input. The font sheet is timed through both decoders
+// and both I2 to I4 conversions. The decoder reads words in native byte order,
+// so the streams are written in host order.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "yay0.h"
+
+#define MAX_SIZE   0x10000
+#define WINDOW     0x1000
+#define MAX_MATCH  (0xFF + 18)
+#define CHAIN      64
+#define RUNS       200
+
+// The previous decoder, as reference
+static void decodeOld(unsigned char *s, unsigned char *d)
+{
+	int i, j, k, p, q, cnt;
+
+	// unsigned long on the console, 32 bits
+	i = *(unsigned int *)(s + 4);	  // size of decoded data
+	j = *(unsigned int *)(s + 8);	  // link table
+	k = *(unsigned int *)(s + 12);	 // byte chunks and count modifiers
+
+	q = 0;					// current offset in dest buffer
+	cnt = 0;				// mask bit counter
+	p = 16;					// current offset in mask table
+
+	unsigned int r22 = 0, r5;
+
+	do
+	{
+		if(cnt == 0)
+		{
+			r22 = *(unsigned int *)(s + p);
+			p += 4;
+			cnt = 32;
+		}
+		if(r22 & 0x80000000)
+		{
+			*(unsigned char *)(d + q) = *(unsigned char *)(s + k);
+			k++, q++;
+		}
+		else
+		{
+			int r26 = *(unsigned short *)(s + j);
+			j += 2;
+			int r25 = q - (r26 & 0xfff);
+			int r30 = r26 >> 12;
+			if(r30 == 0)
+			{
+				r5 = *(unsigned char *)(s + k);
+				k++;
+				r30 = r5 + 18;
+			}
+			else r30 += 2;
+			unsigned char *pt = ((unsigned char*)d) + r25;
+			int i;
+			for(i=0; i<r30; i++)
+			{
+				*(unsigned char *)(d + q) = *(unsigned char *)(pt - 1);
+				q++, pt++;
+			}
+		}
+		r22 <<= 1;
+		cnt--;
+
+	} while(q < i);
+}
+
+// The previous conversion, as reference
+static void convertOld(void *dst, void *src, int xres, int yres)
+{
+	int x, y;
+	unsigned char *d = (unsigned char*)dst;
+	unsigned char *s = (unsigned char*)src;
+
+	for (y = 0; y < yres; y += 8)
+		for (x = 0; x < xres; x += 8)
+		{
+			int iy, ix;
+			for (iy = 0; iy < 8; ++iy, s+=2)
+			{
+				for (ix = 0; ix < 2; ++ix)
+				{
+					int v = s[ix];
+					*d++ = (((v>>6)&3)<<6) | (((v>>6)&3)<<4) | (((v>>4)&3)<<2) | ((v>>4)&3);
+					*d++ = (((v>>2)&3)<<6) | (((v>>2)&3)<<4) | (((v)&3)<<2) | ((v)&3);
+				}
+			}
+		}
+}
+
+static u32 masks[MAX_SIZE / 32 + 1];
+static u16 links[MAX_SIZE];
+static u8 chunks[MAX_SIZE * 2];
+
+// Greedy encoder with hash chains over 3-byte prefixes, returns the stream size
+static int encode(const u8 *data, int size, u8 *stream)
+{
+	static int head[0x10000], prev[MAX_SIZE];
+	int ops = 0, nlinks = 0, nchunks = 0;
+
+	memset(head, -1, sizeof(head));
+	memset(masks, 0, sizeof(masks));
+
+	for (int pos = 0; pos < size;) {
+		int best = 0, dist = 0;
+
+		if (pos + 3 <= size) {
+			int hash = (data[pos] << 8 ^ data[pos + 1] << 4 ^ data[pos + 2]) & 0xFFFF;
+			int tries = CHAIN;
+			for (int cand = head[hash]; cand >= 0 && pos - cand <= WINDOW && tries--; cand = prev[cand]) {
+				int len = 0;
+				while (len < MAX_MATCH && pos + len < size && data[cand + len] == data[pos + len]) len++;
+				if (len > best) {
+					best = len;
+					dist = pos - cand;
+				}
+			}
+		}
+
+		int step = best >= 3 ? best : 1;
+		if (best >= 3) {
+			if (best <= 17) {
+				links[nlinks++] = (best - 2) << 12 | (dist - 1);
+			} else {
+				links[nlinks++] = dist - 1;
+				chunks[nchunks++] = best - 18;
+			}
+		} else {
+			masks[ops / 32] |= 0x80000000u >> (ops % 32);
+			chunks[nchunks++] = data[pos];
+		}
+		ops++;
+
+		for (int i = 0; i < step && pos + i + 3 <= size; i++) {
+			int hash = (data[pos + i] << 8 ^ data[pos + i + 1] << 4 ^ data[pos + i + 2]) & 0xFFFF;
+			prev[pos + i] = head[hash];
+			head[hash] = pos + i;
+		}
+		pos += step;
+	}
+
+	u32 maskSize = (ops + 31) / 32 * 4;
+	u32 linkOffset = 16 + maskSize;
+	u32 chunkOffset = linkOffset + nlinks * 2;
+
+	memcpy(stream, "Yay0", 4);
+	memcpy(stream + 4, &(u32){size}, 4);
+	memcpy(stream + 8, &linkOffset, 4);
+	memcpy(stream + 12, &chunkOffset, 4);
+	memcpy(stream + 16, masks, maskSize);
+	memcpy(stream + linkOffset, links, nlinks * 2);
+	memcpy(stream + chunkOffset, chunks, nchunks);
+	return chunkOffset + nchunks;
+}
+
+static void randomBytes(u8 *data, int size)
+{
+	for (int i = 0; i < size; i++)
+		data[i] = rand();
+}
+
+static void lowEntropy(u8 *data, int size)
+{
+	for (int i = 0; i < size; i++)
+		data[i] = rand() % 4 ? 0 : rand() % 3;
+}
+
+static void runs(u8 *data, int size)
+{
+	for (int i = 0; i < size;) {
+		int run = 1 + rand() % 600;
+		u8 value = rand();
+		while (run-- && i < size) data[i++] = value;
+	}
+}
+
+// Copies of earlier data at any distance in the window, with changes
+static void nearRepeats(u8 *data, int size)
+{
+	for (int i = 0; i < size;) {
+		int len = 1 + rand() % 300;
+		if (i < 16 || rand() % 3 == 0) {
+			while (len-- && i < size) data[i++] = rand();
+		} else {
+			int from = i - 1 - rand() % (i < WINDOW ? i : WINDOW);
+			while (len-- && i < size) {
+				data[i] = rand() % 50 ? data[from] : rand();
+				i++, from++;
+			}
+		}
+	}
+}
+
+// 2-bit glyph cells of 24x24 on a blank sheet, like the IPL font, each glyph
+// drawn from a few strokes that repeat down its rows
+static void fontSheet(u8 *data, int size)
+{
+	static const u8 shades[] = {0x00, 0x00, 0x0F, 0xF0, 0xFF, 0xFF, 0x5A, 0xA5};
+
+	memset(data, 0, size);
+	for (int cell = 0; cell < size / (128 * 24) * 21; cell++) {
+		u8 strokes[4][4];
+		for (int i = 0; i < 16; i++)
+			strokes[i / 4][i % 4] = shades[rand() % 8];
+		u8 *glyph = data + cell / 21 * 128 * 24 + cell % 21 * 6;
+		for (int y = 3; y < 21; y++)
+			memcpy(glyph + y * 128 + 1, strokes[(y / 4 + rand() % 2) % 4], 4);
+	}
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static u8 data[MAX_SIZE], stream[MAX_SIZE * 3], decoded[MAX_SIZE + MAX_MATCH], reference[MAX_SIZE + MAX_MATCH];
+static u8 converted[MAX_SIZE * 2], convertedOld[MAX_SIZE * 2];
+
+static double best(void (*decode)(unsigned char *, unsigned char *), u8 *out)
+{
+	double best = 1e9;
+
+	for (int run = 0; run < RUNS; run++) {
+		double start = now();
+		decode(stream, out);
+		double time = now() - start;
+		if (time < best) best = time;
+	}
+	return best * 1e6;
+}
+
+static double bestConvert(void (*convert)(void *, void *, int, int), u8 *out)
+{
+	double best = 1e9;
+
+	for (int run = 0; run < RUNS; run++) {
+		double start = now();
+		convert(out, decoded, 512, 512);
+		double time = now() - start;
+		if (time < best) best = time;
+	}
+	return best * 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct {
+		const char *name;
+		void (*make)(u8 *, int);
+	} sets[] = {
+		{"random", randomBytes},
+		{"low entropy", lowEntropy},
+		{"runs", runs},
+		{"near repeats", nearRepeats},
+		{"font sheet", fontSheet},
+	};
+	bool passed = true;
+
+	srand(1);
+	for (size_t set = 0; set < sizeof(sets) / sizeof(*sets); set++) {
+		int failures = 0, streams = 60;
+
+		for (int i = 0; i < streams; i++) {
+			int size = 1 + rand() % 20000;
+			sets[set].make(data, size);
+			encode(data, size, stream);
+			decodeYay0(stream, decoded);
+			decodeOld(stream, reference);
+			if (memcmp(decoded, data, size) || memcmp(reference, data, size))
+				failures++;
+		}
+		printf("%-12s %d streams up to 20KB: %s\n", sets[set].name, streams, failures ? "FAILED" : "ok");
+		passed &= !failures;
+	}
+
+	// 512x512 at 2 bits per pixel
+	fontSheet(data, MAX_SIZE);
+	int size = encode(data, MAX_SIZE, stream);
+	double timeOld = best(decodeOld, reference);
+	double timeNew = best(decodeYay0, decoded);
+	bool ok = !memcmp(decoded, data, MAX_SIZE) && !memcmp(reference, data, MAX_SIZE);
+	printf("font sheet   64KB from %dKB: decode %.1fus, previously %.1fus: %s\n",
+		size / 1024, timeNew, timeOld, ok ? "ok" : "FAILED");
+	passed &= ok;
+
+	timeOld = bestConvert(convertOld, convertedOld);
+	timeNew = bestConvert(convertI2toI4, converted);
+	ok = !memcmp(converted, convertedOld, sizeof(converted));
+	printf("I2 to I4     512x512: convert %.1fus, previously %.1fus: %s\n",
+		timeNew, timeOld, ok ? "ok" : "FAILED");
+	passed &= ok;
+
+	return !passed;
+}